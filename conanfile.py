@@ -13,6 +13,7 @@ class PongSdl2C(ConanFile):
     requires = (
         "sdl/2.26.5",
         "sdl_ttf/2.20.2",
+        "sdl_net/2.2.0",
         "log.c/cci.20200620",
         "clove-unit/2.4.1",
     )
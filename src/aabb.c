@@ -1,3 +1,6 @@
+#include <stdint.h>
+#include <stdlib.h>
+
 #include "aabb.h"
 
 /**
@@ -48,6 +51,29 @@ static bool is_point_within_aabb(aabb_t *aabb, int x, int y) {
     return (left < x && x < right && top < y && y < bottom);
 }
 
+/**
+ * Pick the edge with the smallest penetration distance.
+ *
+ * Ties resolve in left, right, top, bottom order.
+ */
+static aabb_edge_t closest_edge(int left, int right, int top, int bottom) {
+    int smallest_distance = left;
+    if (right < smallest_distance)
+        smallest_distance = right;
+    if (top < smallest_distance)
+        smallest_distance = top;
+    if (bottom < smallest_distance)
+        smallest_distance = bottom;
+
+    if (smallest_distance == left)
+        return AABB_LEFT_EDGE;
+    if (smallest_distance == right)
+        return AABB_RIGHT_EDGE;
+    if (smallest_distance == top)
+        return AABB_TOP_EDGE;
+    return AABB_BOTTOM_EDGE;
+}
+
 aabb_edge_t aabb_get_intersection(aabb_t *a, aabb_t *b) {
     aabb_t c;
     minkowksi_difference(a, b, &c);
@@ -61,27 +87,105 @@ aabb_edge_t aabb_get_intersection(aabb_t *a, aabb_t *b) {
     int bottom = abs(c.y + c.h);
 
     if (is_colliding) {
-        int smallest_distance = left;
-        if (right < smallest_distance)
-            smallest_distance = right;
-        if (top < smallest_distance)
-            smallest_distance = top;
-        if (bottom < smallest_distance)
-            smallest_distance = bottom;
-
-        if (smallest_distance == left)
-            return AABB_LEFT_EDGE;
-        if (smallest_distance == right)
-            return AABB_RIGHT_EDGE;
-        if (smallest_distance == top)
-            return AABB_TOP_EDGE;
-        if (smallest_distance == bottom)
-            return AABB_BOTTOM_EDGE;
+        return closest_edge(left, right, top, bottom);
     }
 
     return AABB_NO_EDGE; // Not intersecting
 }
 
+/**
+ * Get `aabb_get_intersection(a, b)` and `aabb_get_intersection(b, a)` at once.
+ *
+ * The difference `b - a` is `a - b` mirrored, so its left distance is the right
+ * distance of `a - b` (and so on); only the tie-break order differs.
+ */
+bool aabb_get_mutual_intersection(aabb_t *a, aabb_t *b, aabb_edge_t *a_edge,
+                                  aabb_edge_t *b_edge) {
+    aabb_t c;
+    minkowksi_difference(a, b, &c);
+
+    if (!is_point_within_aabb(&c, 0, 0)) {
+        *a_edge = AABB_NO_EDGE;
+        *b_edge = AABB_NO_EDGE;
+        return false;
+    }
+
+    int left   = abs(c.x);
+    int top    = abs(c.y);
+    int right  = abs(c.x + c.w);
+    int bottom = abs(c.y + c.h);
+
+    *a_edge = closest_edge(left, right, top, bottom);
+    *b_edge = closest_edge(right, left, bottom, top);
+    return true;
+}
+
+/**
+ * Get the fractions (Q16.16) of the movement `d` at which `a` starts and stops
+ * overlapping `b`, along one axis.
+ *
+ * Kept in 64-bit integers, so the outcome never depends on float rounding.
+ *
+ * \returns `false` if the boxes never overlap on this axis.
+ */
+static bool sweep_axis(int a_min, int a_size, int b_min, int b_size, int d,
+                       int64_t *entry, int64_t *exit) {
+    int64_t a_max = (int64_t)a_min + a_size;
+    int64_t b_max = (int64_t)b_min + b_size;
+
+    if (d == 0) {
+        // Static on this axis; overlapping throughout, or never.
+        *entry = INT64_MIN;
+        *exit  = INT64_MAX;
+        return a_min < b_max && b_min < a_max;
+    }
+
+    if (d > 0) {
+        *entry = (b_min - a_max) * FIXED_ONE / d;
+        *exit  = (b_max - a_min) * FIXED_ONE / d;
+    } else {
+        *entry = (b_max - a_min) * FIXED_ONE / d;
+        *exit  = (b_min - a_max) * FIXED_ONE / d;
+    }
+    return true;
+}
+
+/**
+ * Slab test on the movement of `a` relative to `b`.
+ *
+ * Entry on both axes must happen before exit on either; the later entry is the
+ * time of impact, and its axis decides the contact edges (horizontal wins ties).
+ */
+bool aabb_get_swept_intersection(aabb_t *a, int a_dx, int a_dy, aabb_t *b, int b_dx,
+                                 int b_dy, aabb_contact_t *contact) {
+    int dx = a_dx - b_dx;
+    int dy = a_dy - b_dy;
+
+    int64_t x_entry, x_exit, y_entry, y_exit;
+    if (!sweep_axis(a->x, a->w, b->x, b->w, dx, &x_entry, &x_exit) ||
+        !sweep_axis(a->y, a->h, b->y, b->h, dy, &y_entry, &y_exit)) {
+        return false;
+    }
+
+    int64_t entry = x_entry > y_entry ? x_entry : y_entry;
+    int64_t exit  = x_exit < y_exit ? x_exit : y_exit;
+
+    // Already overlapping (entry < 0), missing, or out of reach this movement.
+    if (entry >= exit || entry < 0 || entry > FIXED_ONE) {
+        return false;
+    }
+
+    contact->time = (fixed_t)entry;
+    if (x_entry >= y_entry) {
+        contact->a_edge = dx > 0 ? AABB_RIGHT_EDGE : AABB_LEFT_EDGE;
+        contact->b_edge = dx > 0 ? AABB_LEFT_EDGE : AABB_RIGHT_EDGE;
+    } else {
+        contact->a_edge = dy > 0 ? AABB_BOTTOM_EDGE : AABB_TOP_EDGE;
+        contact->b_edge = dy > 0 ? AABB_TOP_EDGE : AABB_BOTTOM_EDGE;
+    }
+    return true;
+}
+
 void aabb_set_center_position(aabb_t *aabb, int x, int y) {
     aabb->x = x + (aabb->w / 2);
     aabb->y = y + (aabb->h / 2);
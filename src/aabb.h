@@ -1,10 +1,14 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include <SDL_rect.h>
 
+#include "fixed.h"
+
 typedef SDL_Rect aabb_t;
+typedef SDL_FRect faabb_t;
 
 typedef enum {
   AABB_NO_EDGE,
@@ -14,6 +18,29 @@ typedef enum {
   AABB_BOTTOM_EDGE
 } aabb_edge_t;
 
+/** First contact between two moving boxes. */
+typedef struct {
+  fixed_t time;       // Fraction (0..FIXED_ONE) of the movement before they touch.
+  aabb_edge_t a_edge; // Edge of `a` that makes contact (its normal, reversed).
+  aabb_edge_t b_edge; // Edge of `b` that makes contact.
+} aabb_contact_t;
+
+/** Boxes laid out as parallel coordinate arrays, one element per box. */
+typedef struct {
+  int const *x;
+  int const *y;
+  int const *w;
+  int const *h;
+} aabb_columns_t;
+
+/** Batch kernel implementations, from least to most preferred. */
+typedef enum {
+  AABB_KERNEL_SCALAR,
+  AABB_KERNEL_SSE2,
+  AABB_KERNEL_AVX2,
+  AABB_KERNEL_COUNT,
+} aabb_kernel_t;
+
 /**
  * Return `true` if `inner` is beyond `outer` for given `edge`.
  *
@@ -26,7 +53,72 @@ bool aabb_is_beyond_edge(aabb_t *inner, aabb_t *outer, aabb_edge_t edge);
  */
 aabb_edge_t aabb_get_intersection(aabb_t *a, aabb_t *b);
 
+/**
+ * Get the edges where `a` overlaps `b` and `b` overlaps `a`, from one test.
+ *
+ * Equivalent to calling `aabb_get_intersection` both ways round.
+ *
+ * \returns `true` if the boxes overlap.
+ */
+bool aabb_get_mutual_intersection(aabb_t *a, aabb_t *b, aabb_edge_t *a_edge,
+                                  aabb_edge_t *b_edge);
+
+/**
+ * Get when `a`, moving by (a_dx, a_dy), first touches `b`, moving by (b_dx, b_dy).
+ *
+ * Both move in a straight line over the same interval. Boxes that already
+ * overlap are left to `aabb_get_mutual_intersection`.
+ *
+ * \returns `true` if the boxes come into contact during the movement.
+ */
+bool aabb_get_swept_intersection(aabb_t *a, int a_dx, int a_dy, aabb_t *b, int b_dx,
+                                 int b_dy, aabb_contact_t *contact);
+
 /**
  * Set the box center position, rather than "real" position.
  */
 void aabb_set_center_position(aabb_t *aabb, int x, int y);
+
+// -----------------------------------------------------------------------------
+// Batch Kernels
+// -----------------------------------------------------------------------------
+
+/**
+ * Get the most preferred batch kernel the running CPU supports.
+ */
+aabb_kernel_t aabb_kernel_detect(void);
+
+/**
+ * Route all batch calls through `kernel`.
+ *
+ * Batch calls use the scalar kernel until this is called. Not thread-safe;
+ * select once at startup.
+ *
+ * \returns `false` (keeping the current kernel) if the CPU lacks support.
+ */
+bool aabb_kernel_select(aabb_kernel_t kernel);
+
+/**
+ * Get the kernel batch calls currently go through.
+ */
+aabb_kernel_t aabb_kernel_get(void);
+
+/**
+ * Get a printable name for `kernel`.
+ */
+char const *aabb_kernel_name(aabb_kernel_t kernel);
+
+/**
+ * Get `aabb_get_intersection(a, box)` for each of `count` `boxes`.
+ */
+void aabb_get_intersections(aabb_t *a, aabb_columns_t *boxes, size_t count,
+                            aabb_edge_t *edges);
+
+/**
+ * Get, for each of `count` `boxes`, the first edge of `outer` it is beyond.
+ *
+ * Edges are checked top, bottom, left then right, as `aabb_is_beyond_edge`
+ * would; `AABB_NO_EDGE` if the box is within all four.
+ */
+void aabb_get_beyond_edges(aabb_t *outer, aabb_columns_t *boxes, size_t count,
+                           aabb_edge_t *edges);
@@ -0,0 +1,336 @@
+#include <stdint.h>
+
+#include "aabb.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define AABB_BATCH_X86
+#include <immintrin.h>
+#endif
+
+// Vector kernels store edges straight from 32-bit lanes.
+_Static_assert(sizeof(aabb_edge_t) == sizeof(int32_t), "aabb_edge_t is not 32-bit");
+
+typedef void (*intersections_fn_t)(aabb_t *a, aabb_columns_t *boxes, size_t count,
+                                   aabb_edge_t *edges);
+typedef void (*beyond_edges_fn_t)(aabb_t *outer, aabb_columns_t *boxes, size_t count,
+                                  aabb_edge_t *edges);
+
+// -----------------------------------------------------------------------------
+// Scalar
+// -----------------------------------------------------------------------------
+
+static void get_box(aabb_columns_t *boxes, size_t index, aabb_t *box) {
+    box->x = boxes->x[index];
+    box->y = boxes->y[index];
+    box->w = boxes->w[index];
+    box->h = boxes->h[index];
+}
+
+/**
+ * Scalar intersections for boxes [first, count); also finishes vector tails.
+ */
+static void intersections_from(aabb_t *a, aabb_columns_t *boxes, size_t first,
+                               size_t count, aabb_edge_t *edges) {
+    for (size_t index = first; index < count; index++) {
+        aabb_t box;
+        get_box(boxes, index, &box);
+        edges[index] = aabb_get_intersection(a, &box);
+    }
+}
+
+/**
+ * Scalar beyond-edge ladder for boxes [first, count); also finishes vector tails.
+ */
+static void beyond_edges_from(aabb_t *outer, aabb_columns_t *boxes, size_t first,
+                              size_t count, aabb_edge_t *edges) {
+    static aabb_edge_t const order[] = {AABB_TOP_EDGE, AABB_BOTTOM_EDGE,
+                                        AABB_LEFT_EDGE, AABB_RIGHT_EDGE};
+
+    for (size_t index = first; index < count; index++) {
+        aabb_t box;
+        get_box(boxes, index, &box);
+
+        edges[index] = AABB_NO_EDGE;
+        for (size_t edge = 0; edge < sizeof(order) / sizeof(*order); edge++) {
+            if (aabb_is_beyond_edge(&box, outer, order[edge])) {
+                edges[index] = order[edge];
+                break;
+            }
+        }
+    }
+}
+
+static void intersections_scalar(aabb_t *a, aabb_columns_t *boxes, size_t count,
+                                 aabb_edge_t *edges) {
+    intersections_from(a, boxes, 0, count, edges);
+}
+
+static void beyond_edges_scalar(aabb_t *outer, aabb_columns_t *boxes, size_t count,
+                                aabb_edge_t *edges) {
+    beyond_edges_from(outer, boxes, 0, count, edges);
+}
+
+#ifdef AABB_BATCH_X86
+
+// -----------------------------------------------------------------------------
+// SSE2 (4 boxes per step)
+// -----------------------------------------------------------------------------
+
+#define SSE2 __attribute__((target("sse2")))
+
+SSE2 static inline __m128i select_sse2(__m128i mask, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+SSE2 static inline __m128i abs_sse2(__m128i v) {
+    __m128i sign = _mm_srai_epi32(v, 31);
+    return _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+}
+
+SSE2 static inline __m128i min_sse2(__m128i a, __m128i b) {
+    return select_sse2(_mm_cmplt_epi32(a, b), a, b);
+}
+
+SSE2 static inline __m128i load_sse2(int const *column, size_t index) {
+    return _mm_loadu_si128((__m128i const *)&column[index]);
+}
+
+SSE2 static void intersections_sse2(aabb_t *a, aabb_columns_t *boxes, size_t count,
+                                    aabb_edge_t *edges) {
+    __m128i const zero   = _mm_setzero_si128();
+    __m128i const left   = _mm_set1_epi32(AABB_LEFT_EDGE);
+    __m128i const right  = _mm_set1_epi32(AABB_RIGHT_EDGE);
+    __m128i const top    = _mm_set1_epi32(AABB_TOP_EDGE);
+    __m128i const bottom = _mm_set1_epi32(AABB_BOTTOM_EDGE);
+
+    __m128i ax = _mm_set1_epi32(a->x);
+    __m128i ay = _mm_set1_epi32(a->y);
+    __m128i aw = _mm_set1_epi32(a->w);
+    __m128i ah = _mm_set1_epi32(a->h);
+
+    size_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+        __m128i bx = load_sse2(boxes->x, index);
+        __m128i by = load_sse2(boxes->y, index);
+        __m128i bw = load_sse2(boxes->w, index);
+        __m128i bh = load_sse2(boxes->h, index);
+
+        // --- Minkowski difference `a - b`, as its four borders
+        __m128i cx = _mm_sub_epi32(ax, _mm_add_epi32(bx, bw));
+        __m128i cy = _mm_sub_epi32(ay, _mm_add_epi32(by, bh));
+        __m128i cr = _mm_add_epi32(cx, _mm_add_epi32(aw, bw));
+        __m128i cb = _mm_add_epi32(cy, _mm_add_epi32(ah, bh));
+
+        // --- Origin strictly inside
+        __m128i hit = _mm_and_si128(
+            _mm_and_si128(_mm_cmplt_epi32(cx, zero), _mm_cmpgt_epi32(cr, zero)),
+            _mm_and_si128(_mm_cmplt_epi32(cy, zero), _mm_cmpgt_epi32(cb, zero)));
+
+        // --- Closest edge, ties resolving left, right, top, bottom
+        __m128i dl       = abs_sse2(cx);
+        __m128i dr       = abs_sse2(cr);
+        __m128i dt       = abs_sse2(cy);
+        __m128i db       = abs_sse2(cb);
+        __m128i smallest = min_sse2(min_sse2(min_sse2(dl, dr), dt), db);
+
+        __m128i edge = bottom;
+        edge         = select_sse2(_mm_cmpeq_epi32(dt, smallest), top, edge);
+        edge         = select_sse2(_mm_cmpeq_epi32(dr, smallest), right, edge);
+        edge         = select_sse2(_mm_cmpeq_epi32(dl, smallest), left, edge);
+
+        _mm_storeu_si128((__m128i *)&edges[index], _mm_and_si128(hit, edge));
+    }
+
+    intersections_from(a, boxes, index, count, edges);
+}
+
+SSE2 static void beyond_edges_sse2(aabb_t *outer, aabb_columns_t *boxes, size_t count,
+                                   aabb_edge_t *edges) {
+    __m128i const none   = _mm_setzero_si128();
+    __m128i const left   = _mm_set1_epi32(AABB_LEFT_EDGE);
+    __m128i const right  = _mm_set1_epi32(AABB_RIGHT_EDGE);
+    __m128i const top    = _mm_set1_epi32(AABB_TOP_EDGE);
+    __m128i const bottom = _mm_set1_epi32(AABB_BOTTOM_EDGE);
+
+    __m128i ox0 = _mm_set1_epi32(outer->x);
+    __m128i oy0 = _mm_set1_epi32(outer->y);
+    __m128i ox1 = _mm_set1_epi32(outer->x + outer->w);
+    __m128i oy1 = _mm_set1_epi32(outer->y + outer->h);
+
+    size_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+        __m128i ix0 = load_sse2(boxes->x, index);
+        __m128i iy0 = load_sse2(boxes->y, index);
+        __m128i ix1 = _mm_add_epi32(ix0, load_sse2(boxes->w, index));
+        __m128i iy1 = _mm_add_epi32(iy0, load_sse2(boxes->h, index));
+
+        // `a >= b` is `!(b > a)`; applied lowest priority first.
+        __m128i edge = none;
+        edge = select_sse2(_mm_cmpgt_epi32(ox1, ix1), edge, right);
+        edge = select_sse2(_mm_cmpgt_epi32(ix0, ox0), edge, left);
+        edge = select_sse2(_mm_cmpgt_epi32(oy1, iy1), edge, bottom);
+        edge = select_sse2(_mm_cmpgt_epi32(iy0, oy0), edge, top);
+
+        _mm_storeu_si128((__m128i *)&edges[index], edge);
+    }
+
+    beyond_edges_from(outer, boxes, index, count, edges);
+}
+
+// -----------------------------------------------------------------------------
+// AVX2 (8 boxes per step)
+// -----------------------------------------------------------------------------
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i select_avx2(__m256i mask, __m256i a, __m256i b) {
+    return _mm256_blendv_epi8(b, a, mask);
+}
+
+AVX2 static inline __m256i load_avx2(int const *column, size_t index) {
+    return _mm256_loadu_si256((__m256i const *)&column[index]);
+}
+
+AVX2 static void intersections_avx2(aabb_t *a, aabb_columns_t *boxes, size_t count,
+                                    aabb_edge_t *edges) {
+    __m256i const zero   = _mm256_setzero_si256();
+    __m256i const left   = _mm256_set1_epi32(AABB_LEFT_EDGE);
+    __m256i const right  = _mm256_set1_epi32(AABB_RIGHT_EDGE);
+    __m256i const top    = _mm256_set1_epi32(AABB_TOP_EDGE);
+    __m256i const bottom = _mm256_set1_epi32(AABB_BOTTOM_EDGE);
+
+    __m256i ax = _mm256_set1_epi32(a->x);
+    __m256i ay = _mm256_set1_epi32(a->y);
+    __m256i aw = _mm256_set1_epi32(a->w);
+    __m256i ah = _mm256_set1_epi32(a->h);
+
+    size_t index = 0;
+    for (; index + 8 <= count; index += 8) {
+        __m256i bx = load_avx2(boxes->x, index);
+        __m256i by = load_avx2(boxes->y, index);
+        __m256i bw = load_avx2(boxes->w, index);
+        __m256i bh = load_avx2(boxes->h, index);
+
+        // --- Minkowski difference `a - b`, as its four borders
+        __m256i cx = _mm256_sub_epi32(ax, _mm256_add_epi32(bx, bw));
+        __m256i cy = _mm256_sub_epi32(ay, _mm256_add_epi32(by, bh));
+        __m256i cr = _mm256_add_epi32(cx, _mm256_add_epi32(aw, bw));
+        __m256i cb = _mm256_add_epi32(cy, _mm256_add_epi32(ah, bh));
+
+        // --- Origin strictly inside
+        __m256i hit_x = _mm256_and_si256(_mm256_cmpgt_epi32(zero, cx),
+                                         _mm256_cmpgt_epi32(cr, zero));
+        __m256i hit_y = _mm256_and_si256(_mm256_cmpgt_epi32(zero, cy),
+                                         _mm256_cmpgt_epi32(cb, zero));
+        __m256i hit   = _mm256_and_si256(hit_x, hit_y);
+
+        // --- Closest edge, ties resolving left, right, top, bottom
+        __m256i dl       = _mm256_abs_epi32(cx);
+        __m256i dr       = _mm256_abs_epi32(cr);
+        __m256i dt       = _mm256_abs_epi32(cy);
+        __m256i db       = _mm256_abs_epi32(cb);
+        __m256i smallest = _mm256_min_epi32(_mm256_min_epi32(dl, dr),
+                                            _mm256_min_epi32(dt, db));
+
+        __m256i edge = bottom;
+        edge         = select_avx2(_mm256_cmpeq_epi32(dt, smallest), top, edge);
+        edge         = select_avx2(_mm256_cmpeq_epi32(dr, smallest), right, edge);
+        edge         = select_avx2(_mm256_cmpeq_epi32(dl, smallest), left, edge);
+
+        _mm256_storeu_si256((__m256i *)&edges[index], _mm256_and_si256(hit, edge));
+    }
+
+    intersections_from(a, boxes, index, count, edges);
+}
+
+AVX2 static void beyond_edges_avx2(aabb_t *outer, aabb_columns_t *boxes, size_t count,
+                                   aabb_edge_t *edges) {
+    __m256i const none   = _mm256_setzero_si256();
+    __m256i const left   = _mm256_set1_epi32(AABB_LEFT_EDGE);
+    __m256i const right  = _mm256_set1_epi32(AABB_RIGHT_EDGE);
+    __m256i const top    = _mm256_set1_epi32(AABB_TOP_EDGE);
+    __m256i const bottom = _mm256_set1_epi32(AABB_BOTTOM_EDGE);
+
+    __m256i ox0 = _mm256_set1_epi32(outer->x);
+    __m256i oy0 = _mm256_set1_epi32(outer->y);
+    __m256i ox1 = _mm256_set1_epi32(outer->x + outer->w);
+    __m256i oy1 = _mm256_set1_epi32(outer->y + outer->h);
+
+    size_t index = 0;
+    for (; index + 8 <= count; index += 8) {
+        __m256i ix0 = load_avx2(boxes->x, index);
+        __m256i iy0 = load_avx2(boxes->y, index);
+        __m256i ix1 = _mm256_add_epi32(ix0, load_avx2(boxes->w, index));
+        __m256i iy1 = _mm256_add_epi32(iy0, load_avx2(boxes->h, index));
+
+        // `a >= b` is `!(b > a)`; applied lowest priority first.
+        __m256i edge = none;
+        edge = select_avx2(_mm256_cmpgt_epi32(ox1, ix1), edge, right);
+        edge = select_avx2(_mm256_cmpgt_epi32(ix0, ox0), edge, left);
+        edge = select_avx2(_mm256_cmpgt_epi32(oy1, iy1), edge, bottom);
+        edge = select_avx2(_mm256_cmpgt_epi32(iy0, oy0), edge, top);
+
+        _mm256_storeu_si256((__m256i *)&edges[index], edge);
+    }
+
+    beyond_edges_from(outer, boxes, index, count, edges);
+}
+
+#endif // AABB_BATCH_X86
+
+// -----------------------------------------------------------------------------
+// Dispatch
+// -----------------------------------------------------------------------------
+
+static struct {
+    char const *name;
+    intersections_fn_t intersections;
+    beyond_edges_fn_t beyond_edges;
+} const kernels[AABB_KERNEL_COUNT] = {
+    [AABB_KERNEL_SCALAR] = {"scalar", intersections_scalar, beyond_edges_scalar},
+#ifdef AABB_BATCH_X86
+    [AABB_KERNEL_SSE2] = {"sse2", intersections_sse2, beyond_edges_sse2},
+    [AABB_KERNEL_AVX2] = {"avx2", intersections_avx2, beyond_edges_avx2},
+#else
+    [AABB_KERNEL_SSE2] = {"sse2", NULL, NULL},
+    [AABB_KERNEL_AVX2] = {"avx2", NULL, NULL},
+#endif
+};
+
+static aabb_kernel_t active_kernel = AABB_KERNEL_SCALAR;
+
+aabb_kernel_t aabb_kernel_detect(void) {
+#ifdef AABB_BATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return AABB_KERNEL_AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return AABB_KERNEL_SSE2;
+#endif
+    return AABB_KERNEL_SCALAR;
+}
+
+bool aabb_kernel_select(aabb_kernel_t kernel) {
+    if (kernel >= AABB_KERNEL_COUNT || !kernels[kernel].intersections ||
+        kernel > aabb_kernel_detect()) {
+        return false;
+    }
+    active_kernel = kernel;
+    return true;
+}
+
+aabb_kernel_t aabb_kernel_get(void) { return active_kernel; }
+
+char const *aabb_kernel_name(aabb_kernel_t kernel) {
+    return kernel < AABB_KERNEL_COUNT ? kernels[kernel].name : "unknown";
+}
+
+void aabb_get_intersections(aabb_t *a, aabb_columns_t *boxes, size_t count,
+                            aabb_edge_t *edges) {
+    kernels[active_kernel].intersections(a, boxes, count, edges);
+}
+
+void aabb_get_beyond_edges(aabb_t *outer, aabb_columns_t *boxes, size_t count,
+                           aabb_edge_t *edges) {
+    kernels[active_kernel].beyond_edges(outer, boxes, count, edges);
+}
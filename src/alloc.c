@@ -0,0 +1,129 @@
+#include <stdalign.h>
+#include <stdint.h>
+
+#include "alloc.h"
+
+#define ARENA_ALIGNMENT      alignof(max_align_t)
+#define ARENA_MIN_BLOCK_SIZE 1024
+
+typedef struct arena_block_s {
+    struct arena_block_s *previous;
+    size_t capacity;
+    size_t offset;
+    alignas(max_align_t) unsigned char data[];
+} arena_block_t;
+
+struct arena_s {
+    arena_block_t *block; // Current block; earlier ones chain off it.
+    arena_stats_t stats;
+};
+
+static size_t align_up(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+static arena_block_t *arena_block_init(size_t capacity, arena_block_t *previous) {
+    capacity = capacity < ARENA_MIN_BLOCK_SIZE ? ARENA_MIN_BLOCK_SIZE : capacity;
+
+    arena_block_t *block = malloc(sizeof(arena_block_t) + capacity);
+    if (!block) {
+        return NULL;
+    }
+    block->previous = previous;
+    block->capacity = capacity;
+    block->offset   = 0;
+    return block;
+}
+
+static void arena_blocks_term(arena_block_t *block) {
+    while (block) {
+        arena_block_t *previous = block->previous;
+        delete (block);
+        block = previous;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Lifecycle
+// -----------------------------------------------------------------------------
+
+arena_t *arena_init(size_t capacity) {
+    arena_t *arena = new_clean(1, arena_t);
+    if (!arena) {
+        return NULL;
+    }
+
+    if (!(arena->block = arena_block_init(align_up(capacity), NULL))) {
+        delete (arena);
+        return NULL;
+    }
+
+    arena->stats.capacity    = arena->block->capacity;
+    arena->stats.block_count = 1;
+    return arena;
+}
+
+void arena_term(arena_t *arena) {
+    if (!arena) {
+        return;
+    }
+    arena_blocks_term(arena->block);
+    delete (arena);
+}
+
+// -----------------------------------------------------------------------------
+// Allocation
+// -----------------------------------------------------------------------------
+
+void *arena_alloc(arena_t *arena, size_t size) {
+    arena_block_t *block = arena->block;
+    size                 = align_up(size ? size : 1);
+
+    // --- Spill into a new block, at least double the last
+    if (size > block->capacity - block->offset) {
+        size_t capacity = block->capacity * 2 > size ? block->capacity * 2 : size;
+        if (!(block = arena_block_init(capacity, arena->block))) {
+            return NULL;
+        }
+        arena->block = block;
+        arena->stats.capacity += block->capacity;
+        arena->stats.block_count++;
+    }
+
+    void *memory = block->data + block->offset;
+    block->offset += size;
+
+    arena->stats.used += size;
+    if (arena->stats.used > arena->stats.high_water) {
+        arena->stats.high_water = arena->stats.used;
+    }
+    return memory;
+}
+
+void arena_reset(arena_t *arena) {
+    arena->stats.resets++;
+    arena->stats.used = 0;
+
+    if (!arena->block->previous) {
+        arena->block->offset = 0;
+        return;
+    }
+
+    // --- Merge a chain into one block that fits the high-water mark
+    arena_block_t *merged = arena_block_init(arena->stats.high_water, NULL);
+    if (!merged) {
+        // Keep the newest (largest) block rather than fail.
+        arena_blocks_term(arena->block->previous);
+        arena->block->previous = NULL;
+        arena->block->offset   = 0;
+        merged                 = arena->block;
+    } else {
+        arena_blocks_term(arena->block);
+    }
+
+    arena->block             = merged;
+    arena->stats.capacity    = merged->capacity;
+    arena->stats.block_count = 1;
+}
+
+void arena_get_stats(arena_t *arena, arena_stats_t *stats) { *stats = arena->stats; }
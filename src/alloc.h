@@ -1,7 +1,64 @@
 #pragma once
+#include <stddef.h>
 #include <stdlib.h>
 
 #define new(x) malloc(sizeof(x))
-#define new_array(n, x) malloc(n * sizeof(x))
+#define new_array(n, x) malloc((n) * sizeof(x))
 #define delete(x) free(x)
 #define new_clean(n, x) calloc(n, sizeof(x))
+
+// -----------------------------------------------------------------------------
+// Arenas
+// -----------------------------------------------------------------------------
+
+/**
+ * Bump allocator for memory that shares a lifetime (a frame, a game, the app).
+ *
+ * Allocation is a pointer bump; everything is released at once by
+ * `arena_reset` or `arena_term`, never individually.
+ */
+typedef struct arena_s arena_t;
+
+typedef struct {
+  size_t used;          // Bytes handed out since the last reset, padding included.
+  size_t high_water;    // Most bytes ever in use at once.
+  size_t capacity;      // Bytes reserved.
+  size_t block_count;   // More than one only until the next reset.
+  unsigned long resets;
+} arena_stats_t;
+
+#define arena_new(arena, x) arena_alloc((arena), sizeof(x))
+#define arena_new_array(arena, n, x) arena_alloc((arena), (n) * sizeof(x))
+
+/**
+ * Initialize an arena, reserving `capacity` bytes up front.
+ *
+ * \sa arena_term
+ */
+arena_t *arena_init(size_t capacity);
+
+/**
+ * Terminate an arena, releasing everything allocated from it.
+ */
+void arena_term(arena_t *arena);
+
+/**
+ * Allocate `size` bytes, aligned for any type.
+ *
+ * A full arena chains another block rather than failing, so earlier
+ * allocations stay put.
+ *
+ * \returns NULL only if the system is out of memory.
+ */
+void *arena_alloc(arena_t *arena, size_t size);
+
+/**
+ * Release everything allocated from `arena` in O(1).
+ *
+ * If the arena had to chain blocks since the last reset, they are merged into
+ * one block that fits the high-water mark, so the next cycle bumps through a
+ * single block again.
+ */
+void arena_reset(arena_t *arena);
+
+void arena_get_stats(arena_t *arena, arena_stats_t *stats);
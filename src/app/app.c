@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdlib.h>
 
 #include "SDL.h"
@@ -7,11 +8,37 @@
 
 #include "alloc.h"
 #include "app.h"
+#include "pacer.h"
+#include "profile/profile.h"
+#include "triple_buffer.h"
 #include "video.h"
 
 // --- Window
 #define DEFAULT_WINDOW_FLAGS 0
 
+// --- Events
+#define EVENT_BATCH_SIZE 32
+
+// --- Simulation
+#define DEFAULT_MAX_TICKS_PER_FRAME 8
+#define DEFAULT_HEADLESS_TICK_RATE  60
+
+// --- Arenas
+#define APP_ARENA_SIZE 1024
+
+// --- Profiling
+#define PROFILE_CAPACITY     (1 << 16) // Zones kept; older ones are overwritten.
+#define DEFAULT_PROFILE_PATH "trace.json"
+
+/**
+ * A snapshot as kept in the triple buffer: when its tick ended, then whatever
+ * the tick processor left for frames.
+ */
+typedef struct {
+    uint64_t published_time; // Performance counter.
+    max_align_t data[];
+} snapshot_t;
+
 /**
  * Initialize static application.
  *
@@ -19,33 +46,75 @@
  */
 app_t *app_init(app_config_t *config) {
 
-    app_t *app   = new (app_t);
-    app->video   = NULL;
-    app->running = false;
+    arena_t *arena = arena_init(APP_ARENA_SIZE);
+    if (!arena) {
+        return NULL;
+    }
+
+    app_t *app     = arena_new(arena, app_t);
+    app->arena     = arena;
+    app->video     = NULL;
+    app->snapshots = NULL;
+    atomic_init(&app->running, false);
+
+    app->is_headless         = config->is_headless;
+    app->frame_rate          = config->frame_rate;
+    app->tick_rate           = config->tick_rate;
+    app->max_ticks_per_frame = config->max_ticks_per_frame
+                                   ? config->max_ticks_per_frame
+                                   : DEFAULT_MAX_TICKS_PER_FRAME;
+    app->tick_limit          = config->tick_limit;
+    app->tick_count          = 0;
+    app->tick_time           = 0;
+    app->profile_path        = config->profile_path;
+    app->snapshot_size       = config->snapshot_size;
+    app->frame_snapshot      = NULL;
+    app->is_sim_threaded     = config->is_sim_threaded && !config->is_headless;
+
+    // Headless runs must be deterministic, so they always use a fixed step.
+    if (app->is_headless && !app->tick_rate) {
+        app->tick_rate = DEFAULT_HEADLESS_TICK_RATE;
+    }
 
     log_set_level(LOG_DEBUG);
 
+    // Frames can only be drawn apart from ticks at a steady rate, from snapshots.
+    if (app->is_sim_threaded && (!app->tick_rate || !app->snapshot_size)) {
+        log_warn("Cannot tick on a thread of its own without a fixed tick rate and "
+                 "snapshots; ticking on the main thread");
+        app->is_sim_threaded = false;
+    }
+
+    // --- Profiler
+    if (!profile_init(PROFILE_CAPACITY)) {
+        log_warn("Cannot allocate profiler; profiling is unavailable");
+    }
+    profile_set_enabled(app->profile_path != NULL);
+
+    // --- Snapshots, unless nothing will draw them
+    size_t const slot_size = sizeof(snapshot_t) + app->snapshot_size;
+    if (!app->is_headless && app->snapshot_size &&
+        !(app->snapshots = triple_buffer_init(slot_size))) {
+        log_error("Cannot allocate snapshots");
+        app_term(app);
+        return NULL;
+    }
+
     if (!(app->video = video_init(
               &(video_cfg_t){.window_title         = config->window_title,
                              .window_position_x    = config->window_position_x,
                              .window_position_y    = config->window_position_y,
                              .window_width         = config->window_width,
                              .window_height        = config->window_height,
-                             .window_is_fullscreen = config->window_is_fullscreen}))) {
+                             .window_is_fullscreen = config->window_is_fullscreen,
+                             .is_headless          = config->is_headless,
+                             .is_vsync             = config->is_vsync}))) {
 
         log_error("Cannot initialize video sub-system");
         app_term(app);
         return NULL;
     }
 
-    // --- RNG
-    // Seed RNG
-    srand(time(NULL));
-    // Toss out the first few values.
-    for (int count = 0; count < 1000; count++) {
-        rand();
-    }
-
     return app;
 }
 
@@ -56,12 +125,141 @@ void app_term(app_t *app) {
     if (!app) {
         return;
     }
+
+    if (profile_get_count()) {
+        char const *path = app->profile_path ? app->profile_path : DEFAULT_PROFILE_PATH;
+        if (profile_write_chrome_trace(path)) {
+            log_info("Wrote profile trace to %s", path);
+        } else {
+            log_error("Cannot write profile trace to %s", path);
+        }
+    }
+    profile_term();
+
+    triple_buffer_term(app->snapshots);
+
     video_term(app->video);
     SDL_Quit();
-    delete (app);
+    arena_term(app->arena);
+}
+
+/**
+ * Take up to a batch of queued events other than key presses and releases.
+ *
+ * \returns how many were taken.
+ */
+static int take_events(SDL_Event events[EVENT_BATCH_SIZE]) {
+    int count = SDL_PeepEvents(events, EVENT_BATCH_SIZE, SDL_GETEVENT, SDL_FIRSTEVENT,
+                               SDL_KEYDOWN - 1);
+    if (count < 0) {
+        return 0;
+    }
+    int rest = SDL_PeepEvents(events + count, EVENT_BATCH_SIZE - count, SDL_GETEVENT,
+                              SDL_KEYUP + 1, SDL_LASTEVENT);
+    return rest > 0 ? count + rest : count;
+}
+
+/**
+ * Run one tick, then publish the snapshot it filled in.
+ */
+static void tick(app_t *app, tick_processor_t process_tick, float delta) {
+    profile_zone_t tick_zone = profile_begin("tick");
+    process_tick(app, delta);
+    profile_end(&tick_zone);
+    app->tick_count++;
+
+    if (app->snapshots) {
+        snapshot_t *snapshot     = triple_buffer_get_back(app->snapshots);
+        snapshot->published_time = SDL_GetPerformanceCounter();
+        triple_buffer_publish(app->snapshots);
+    }
+}
+
+/**
+ * Run the simulation alone, as fast as possible: no events, frames or delays.
+ */
+static void app_run_headless(app_t *app, tick_processor_t process_tick) {
+    float const tick_delta = 1.0f / app->tick_rate;
+    uint64_t const start   = SDL_GetPerformanceCounter();
+
+    while (app->running) {
+        tick(app, process_tick, tick_delta);
+
+        if (app->tick_count == app->tick_limit) {
+            app->running = false;
+        }
+    }
+
+    double seconds = (SDL_GetPerformanceCounter() - start) /
+                     (double)SDL_GetPerformanceFrequency();
+    log_info("Simulated %lu ticks in %.3f s (%.0f ticks/s)", app->tick_count, seconds,
+             app->tick_count / seconds);
 }
 
-void app_run(app_t *app, frame_processor_t process_frame,
+/** What the simulation thread runs. */
+typedef struct {
+    app_t *app;
+    tick_processor_t process_tick;
+} sim_thread_t;
+
+/**
+ * Tick at exactly `tick_rate` Hz until the app stops, on a thread of its own.
+ *
+ * Ticks are paced like frames, on absolute deadlines; ticks that run late are
+ * caught up on straight away. Each simulates up to the time it starts.
+ */
+static int run_sim_thread(void *context) {
+    sim_thread_t *sim = context;
+    app_t *app        = sim->app;
+
+    pacer_t *pacer = pacer_init(&(pacer_config_t){.frame_rate = app->tick_rate});
+    if (!pacer) {
+        log_error("Cannot allocate tick pacer");
+        app->running = false;
+        return -1;
+    }
+
+    float const tick_delta = 1.0f / app->tick_rate;
+    while (app->running) {
+        app->tick_time = SDL_GetTicks();
+        tick(app, sim->process_tick, tick_delta);
+
+        if (app->tick_limit && app->tick_count >= app->tick_limit) {
+            app->running = false;
+        }
+        pacer_wait(pacer);
+    }
+
+    pacer_stats_t stats;
+    pacer_get_stats(pacer, &stats);
+    log_info("%lu ticks: %.3f ms mean, %.3f ms jitter, %.3f - %.3f ms, %lu late",
+             stats.frame_count, stats.mean_ms, stats.jitter_ms, stats.min_ms,
+             stats.max_ms, stats.late_count);
+    pacer_term(pacer);
+    return 0;
+}
+
+/**
+ * Run the application loop.
+ *
+ * With a zero tick rate, the simulation is stepped once per frame by the real
+ * frame time. Otherwise it is stepped at exactly `tick_rate` Hz from an
+ * accumulator fed by the high-resolution counter, and each frame is drawn
+ * interpolated between the last two ticks. Frames slower than
+ * `max_ticks_per_frame` ticks drop the excess time rather than trying to catch
+ * up, so one slow frame cannot snowball into the next.
+ *
+ * With `is_sim_threaded`, ticks run on a thread of their own at `tick_rate`
+ * instead, and this loop only polls events and draws the latest snapshot,
+ * interpolated by how long ago it was published.
+ *
+ * Frames are paced to `frame_rate` by the pacer, or by VSync if the renderer
+ * has it. Frame-time statistics are logged when the loop ends.
+ *
+ * Headless applications only tick, back to back, until stopped or the tick
+ * limit is reached.
+ */
+void app_run(app_t *app, tick_processor_t process_tick, frame_processor_t process_frame,
              event_processor_t process_event) {
 
     // --- Validation Checks
@@ -69,6 +267,10 @@ void app_run(app_t *app, frame_processor_t process_frame,
         log_error("Application instance is NULL");
     }
 
+    if (!process_tick) {
+        log_error("Tick Processor is NULL");
+    }
+
     if (!process_frame) {
         log_error("Frame Processor is NULL");
     }
@@ -80,68 +282,153 @@ void app_run(app_t *app, frame_processor_t process_frame,
     // Set running flag.
     app->running = true;
 
-    /** CPU ticks at the start of the last frame. */
-    uint64_t prev_frame_ticks = SDL_GetTicks64();
+    if (app->is_headless) {
+        app_run_headless(app, process_tick);
+        return;
+    }
+
+    /** High-resolution counter ticks per second. */
+    double const counter_frequency = SDL_GetPerformanceFrequency();
+
+    /** Fixed simulation step, in seconds (0 when stepping per frame). */
+    float const tick_delta = app->tick_rate ? 1.0f / app->tick_rate : 0;
+
+    /** Most simulation time a single frame may consume, in seconds. */
+    double const max_frame_time = tick_delta * app->max_ticks_per_frame;
 
-    /** CPU ticks at the start of this frame. */
-    uint64_t curr_frame_ticks = 0;
+    /** Counter value at the start of the last frame. */
+    uint64_t prev_frame_start_time = SDL_GetPerformanceCounter();
 
     /** Time at the beginning of the frame. */
     uint64_t frame_start_time = 0;
 
-    /** Time at the end of the frame. */
-    uint64_t frame_end_time = 0;
-
-    /** Milliseconds this frame has taken. */
-    float elapsed_frame_ms = 0;
+    /** The same, as SDL_GetTicks milliseconds, the clock events are stamped by. */
+    uint32_t frame_start_ms = 0;
 
     /** Time between frames. Measured in seconds. */
-    float delta = 0;
+    double delta = 0;
+
+    /** Simulation time not yet consumed by ticks. Measured in seconds. */
+    double accumulator = 0;
+
+    /** Ends each frame on time. */
+    pacer_t *pacer = pacer_init(&(pacer_config_t){
+        .frame_rate = app->frame_rate,
+        .is_vsync   = video_is_vsync(app->video),
+    });
+    if (!pacer) {
+        log_error("Cannot allocate frame pacer");
+        return;
+    }
+
+    /** Ticks, when they run apart from frames. */
+    sim_thread_t sim       = {app, process_tick};
+    SDL_Thread *sim_thread = NULL;
+    if (app->is_sim_threaded &&
+        !(sim_thread = SDL_CreateThread(run_sim_thread, "sim", &sim))) {
+        log_warn("Cannot start simulation thread (%s); ticking on the main thread",
+                 SDL_GetError());
+        app->is_sim_threaded = false;
+    }
 
     // --- Application Loop
     while (app->running) {
 
         // --- Start Frame Timing
 
-        frame_start_time = SDL_GetPerformanceCounter();
-        curr_frame_ticks = SDL_GetTicks64();
-        delta            = (curr_frame_ticks - prev_frame_ticks) / 1000.0f;
-
-        // --- Poll input events
-        /** Input Event Processing */
-        SDL_Event event;
-        while (SDL_PollEvent(&event)) {
-            process_event(app, &event);
-            // --- Check OS-level quit request
-            if (event.type == SDL_QUIT) {
-                app->running = false;
-                break;
+        frame_start_time      = SDL_GetPerformanceCounter();
+        frame_start_ms        = SDL_GetTicks();
+        delta                 = (frame_start_time - prev_frame_start_time) /
+                                counter_frequency;
+        prev_frame_start_time = frame_start_time;
+
+        profile_zone_t frame_zone = profile_begin("frame");
+
+        // --- Poll events, a batch at a time
+        profile_zone_t events_zone = profile_begin("events");
+        SDL_Event events[EVENT_BATCH_SIZE];
+        int event_count;
+        SDL_PumpEvents();
+        while (app->running && (event_count = take_events(events)) > 0) {
+            for (int index = 0; index < event_count; index++) {
+                process_event(app, &events[index]);
+                // --- Check OS-level quit request
+                if (events[index].type == SDL_QUIT) {
+                    app->running = false;
+                }
             }
         }
+        profile_end(&events_zone);
 
         // --- Process Frame
-        process_frame(app, delta);
+        float alpha = 1.0f;
+        if (!app->tick_rate) {
+            app->tick_time = frame_start_ms;
+            tick(app, process_tick, delta);
+        } else if (!app->is_sim_threaded) {
+            // Spiral-of-death guard: drop time the cap will not let us simulate.
+            accumulator += delta < max_frame_time ? delta : max_frame_time;
+
+            while (accumulator >= tick_delta && app->running) {
+                accumulator -= tick_delta;
+                // The tick ends as far before the frame as time is left over.
+                app->tick_time = frame_start_ms - (uint32_t)(accumulator * 1000);
+
+                tick(app, process_tick, tick_delta);
+            }
 
-        // --- End Frame Timing
-        //
-        prev_frame_ticks = curr_frame_ticks;
-        frame_end_time   = SDL_GetPerformanceCounter();
-        elapsed_frame_ms = (frame_end_time - frame_start_time) /
-                           (float)SDL_GetPerformanceFrequency() * 1000.0f;
+            alpha = accumulator / tick_delta;
+        }
 
-        // 60 FPS in Milliseconds
-        // == 1 (frame) / 60 (seconds) * 1000 (convert to ms)
-        static float const FPS60 = 16.666f;
+        snapshot_t const *snapshot = app->snapshots
+                                         ? triple_buffer_get_front(app->snapshots)
+                                         : NULL;
+        app->frame_snapshot        = snapshot ? snapshot->data : NULL;
 
-        long frame_delay = floor(FPS60 - elapsed_frame_ms);
+        // Apart from frames, ticks are drawn one period behind, as they arrive.
+        if (app->is_sim_threaded && snapshot) {
+            alpha = (frame_start_time - snapshot->published_time) / counter_frequency *
+                    app->tick_rate;
+            alpha = alpha < 1.0f ? alpha : 1.0f;
+        }
 
-        // Delay each frame to get as close to 60FPS as possible.
-        if (frame_delay < 0)
-            frame_delay = 0;
-        SDL_Delay(frame_delay);
+        profile_zone_t draw_zone = profile_begin("draw");
+        process_frame(app, alpha);
+        profile_end(&draw_zone);
+
+        profile_end(&frame_zone);
+
+        if (!app->is_sim_threaded && app->tick_limit &&
+            app->tick_count >= app->tick_limit) {
+            app->running = false;
+        }
+
+        // --- End Frame Timing
+        profile_zone_t pace_zone = profile_begin("pace");
+        pacer_wait(pacer);
+        profile_end(&pace_zone);
     }
 
-    return;
+    SDL_WaitThread(sim_thread, NULL);
+
+    pacer_stats_t stats;
+    pacer_get_stats(pacer, &stats);
+    log_info("%lu frames: %.3f ms mean, %.3f ms jitter, %.3f - %.3f ms, %lu late "
+             "(%s, %.2f ms sleep margin)",
+             stats.frame_count, stats.mean_ms, stats.jitter_ms, stats.min_ms,
+             stats.max_ms, stats.late_count,
+             video_is_vsync(app->video) ? "vsync" : "timer", stats.sleep_margin_ms);
+    pacer_term(pacer);
 }
 
 void app_stop(app_t *app) { app->running = false; }
+
+void *app_get_tick_snapshot(app_t *app) {
+    if (!app->snapshots) {
+        return NULL;
+    }
+    snapshot_t *snapshot = triple_buffer_get_back(app->snapshots);
+    return snapshot->data;
+}
+
+void const *app_get_frame_snapshot(app_t *app) { return app->frame_snapshot; }
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <stdatomic.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#include "alloc.h"
+#include "triple_buffer.h"
 #include "video.h"
 
 /**
@@ -14,19 +19,76 @@ typedef struct {
   unsigned short window_width;
   unsigned short window_height;
   unsigned char window_is_fullscreen;
+  unsigned short frame_rate;         // Frames per second to pace to (0: unpaced).
+  unsigned char is_vsync;            // Pace frames to the display instead, if able.
+  unsigned short tick_rate;          // Simulation ticks per second (0: per frame).
+  unsigned char max_ticks_per_frame; // Catch-up cap for slow frames.
+  unsigned char is_headless;         // No window; simulate uncapped, never draw.
+  unsigned long tick_limit;          // Stop after this many ticks (0: never).
+  char const *profile_path;          // Profile from startup; trace written here.
+  size_t snapshot_size;              // Bytes each tick leaves for frames to draw.
+  unsigned char is_sim_threaded;     // Tick on a thread of its own, at its own rate.
 } app_config_t;
 
 typedef struct {
+  arena_t *arena; // App lifetime; holds the app itself.
   video_t *video;
-  bool running;
+  atomic_bool running;
+  bool is_headless;
+  bool is_sim_threaded;
+  unsigned short frame_rate;
+  unsigned short tick_rate;
+  unsigned char max_ticks_per_frame;
+  unsigned long tick_limit;
+  unsigned long tick_count;
+  uint32_t tick_time;       // SDL_GetTicks time the current tick simulates up to.
+  char const *profile_path;
+  size_t snapshot_size;
+  triple_buffer_t *snapshots; // Ticks to frames; NULL when headless or unsized.
+  void const *frame_snapshot; // Taken for the current frame.
 } app_t;
 
-typedef void (*frame_processor_t)(app_t *, float);
+/**
+ * Advance the simulation by `delta` seconds, up to real time `app->tick_time`.
+ *
+ * With a fixed tick rate, `delta` is always `1 / tick_rate`, and the ticks of
+ * one frame end at evenly spaced times before the frame started.
+ */
+typedef void (*tick_processor_t)(app_t *, float delta);
+
+/**
+ * Draw a frame, `alpha` (0..1) of the way from the previous to the latest tick.
+ *
+ * With the simulation on its own thread, frames share nothing with ticks but
+ * the snapshot (see app_get_frame_snapshot).
+ */
+typedef void (*frame_processor_t)(app_t *, float alpha);
+
+/**
+ * Handle one event. Key presses and releases are left in SDL's queue, to be
+ * taken as timestamped input and applied by each tick up to its own time.
+ */
 typedef void (*event_processor_t)(app_t *, SDL_Event *event);
 
 // TODO: Redesign relationship to app allocation
 app_t *app_init(app_config_t *config);
 void app_term(app_t *app);
-void app_run(app_t *app, frame_processor_t frame_processor,
-             event_processor_t event_processor);
+void app_run(app_t *app, tick_processor_t tick_processor,
+             frame_processor_t frame_processor, event_processor_t event_processor);
 void app_stop(app_t *app);
+
+/**
+ * Get the snapshot the current tick publishes, for the tick processor to fill
+ * in full; it is published as soon as the tick returns.
+ *
+ * \returns NULL if the app keeps no snapshots.
+ */
+void *app_get_tick_snapshot(app_t *app);
+
+/**
+ * Get the latest snapshot published, for the frame processor to draw. It is
+ * never written while the frame has it, however far the ticks run ahead.
+ *
+ * \returns NULL if the app keeps no snapshots, or no tick has published one.
+ */
+void const *app_get_frame_snapshot(app_t *app);
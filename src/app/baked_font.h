@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+// --- Glyph Range (inclusive, printable ASCII), baked and drawn
+#define BAKED_FONT_FIRST_GLYPH ' '
+#define BAKED_FONT_LAST_GLYPH  '~'
+#define BAKED_FONT_GLYPH_COUNT (BAKED_FONT_LAST_GLYPH - BAKED_FONT_FIRST_GLYPH + 1)
+
+/**
+ * Where one glyph sits in a baked font's atlas, and how far it advances.
+ */
+typedef struct {
+  int16_t x;
+  int16_t y;
+  int16_t w; // 0 for blank glyphs, which only advance.
+  int16_t h;
+  int16_t advance;
+} baked_glyph_t;
+
+/**
+ * A font rasterized at build time (by src/tools/font_baker.c) into a glyph
+ * atlas: coverage for white glyphs, and where each glyph is in it.
+ */
+typedef struct {
+  char const *name;            // Font file it was baked from.
+  int size;                    // Point size it was baked at.
+  int first_glyph;             // Character of the first glyph.
+  int glyph_count;             // Glyphs, for consecutive characters.
+  int width;                   // Atlas width, in pixels.
+  int height;                  // Atlas height, in pixels.
+  int line_height;             // Distance between lines, in pixels.
+  baked_glyph_t const *glyphs; // `glyph_count` of them.
+  uint8_t const *coverage;     // Atlas alpha, `width` * `height`, row by row.
+} baked_font_t;
+
+/** The font compiled into the binary, generated at build time. */
+extern baked_font_t const baked_font;
@@ -0,0 +1,103 @@
+/**
+ * Cached Layer Benchmark.
+ *
+ * Draws a paused frame the way dimmed states do, paddles, ball and scores under
+ * a blended dimmer over the whole window with text on top, at two window sizes:
+ * redrawn in full every frame, and copied from an opaque layer drawn once. Runs
+ * on the SDL dummy video driver. One op is one frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include "app/video.h"
+#include "bench/bench.h"
+
+/** Window sizes compared, to show which costs grow with the window. */
+#define SIZE_COUNT 2
+static struct {
+    int width;
+    int height;
+    char const *direct_name;
+    char const *cached_name;
+} const sizes[SIZE_COUNT] = {
+    {640, 480, "layers/direct_480p", "layers/cached_480p"},
+    {1920, 1080, "layers/direct_1080p", "layers/cached_1080p"},
+};
+
+typedef struct {
+    video_t *video;
+    video_layer_t *layer; // NULL to redraw the scene every frame.
+    aabb_t field;
+} paused_frame_t;
+
+/**
+ * Draw one paused frame, the scene through the frame's layer.
+ */
+static void run_paused_frame(void *context) {
+    paused_frame_t *frame = context;
+    video_t *video        = frame->video;
+    aabb_t *field         = &frame->field;
+
+    video_clear(video);
+    if (video_layer_begin(video, frame->layer)) {
+        video_set_color(video, 255, 255, 255, 255);
+        video_draw_region(video, &(aabb_t){field->x + 40, field->h / 2 - 40, 10, 80});
+        video_draw_region(video, &(aabb_t){field->w - 50, field->h / 2 - 40, 10, 80});
+        video_draw_region(video, &(aabb_t){field->w / 2, field->h / 3, 10, 10});
+        video_draw_text(video, "3", field->w / 2 - 48, 16);
+        video_draw_text(video, "1", field->w / 2 + 48, 16);
+        video_set_color(video, 0, 0, 0, 160);
+        video_draw_region(video, field);
+        video_layer_end(video, frame->layer);
+    }
+    video_layer_draw(video, frame->layer);
+    video_draw_text(video, "Paused", field->w / 2, field->h / 2);
+    video_render(video);
+}
+
+static void bench_size(bench_t *bench, int index) {
+    video_t *video = video_init(&(video_cfg_t){.window_title  = "bench",
+                                               .window_width  = sizes[index].width,
+                                               .window_height = sizes[index].height});
+    if (!video) {
+        return;
+    }
+    paused_frame_t frame = {
+        .video = video,
+        .field = {0, 0, sizes[index].width, sizes[index].height},
+    };
+    bench_run(bench, sizes[index].direct_name, run_paused_frame, &frame, 1);
+
+    if ((frame.layer = video_layer_init(video, true))) {
+        bench_run(bench, sizes[index].cached_name, run_paused_frame, &frame, 1);
+    } else {
+        printf("layers: no render targets; %s skipped\n", sizes[index].cached_name);
+    }
+
+    video_stats_t stats;
+    video_get_stats(video, &stats);
+    printf("layers: %dx%d, layer drawn %lu time(s) over %lu frames\n",
+           sizes[index].width, sizes[index].height, stats.layer_redraws, stats.frames);
+
+    video_layer_term(frame.layer);
+    video_term(video);
+}
+
+int main(int argc, char *argv[]) {
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+
+    bench_t *bench = bench_init("layers", argc, argv);
+    if (!bench) {
+        return EXIT_FAILURE;
+    }
+
+    for (int index = 0; index < SIZE_COUNT; index++) {
+        bench_size(bench, index);
+    }
+
+    SDL_Quit();
+    return bench_term(bench);
+}
@@ -0,0 +1,101 @@
+/**
+ * Rect Rendering Benchmark.
+ *
+ * Draws thousands of regions per frame in a handful of colors, the way entity
+ * drawing does, and compares one renderer call per region against the recorded
+ * and batched `video_*` path. Runs headless on the SDL dummy video driver. One op
+ * is one frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include "app/video.h"
+#include "bench/bench.h"
+
+#define FRAME_WIDTH  640
+#define FRAME_HEIGHT 480
+#define RECT_COUNT   5000
+#define COLOR_COUNT  4
+
+static aabb_t rects[RECT_COUNT];
+static SDL_Color const colors[COLOR_COUNT] = {
+    {255, 255, 255, 255}, {255, 0, 0, 255}, {0, 255, 0, 255}, {0, 0, 0, 160}};
+
+static void rects_init(void) {
+    for (int index = 0; index < RECT_COUNT; index++) {
+        rects[index] = (aabb_t){(index * 7) % FRAME_WIDTH, (index * 13) % FRAME_HEIGHT,
+                                8, 8};
+    }
+}
+
+/**
+ * One color change and one fill call per region, as `video_*` used to issue.
+ */
+static void run_immediate(void *context) {
+    SDL_Renderer *renderer = context;
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    for (int index = 0; index < RECT_COUNT; index++) {
+        SDL_Color c = colors[(index / (RECT_COUNT / COLOR_COUNT)) % COLOR_COUNT];
+        SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+        SDL_RenderFillRect(renderer, &rects[index]);
+    }
+}
+
+static void run_batched(void *context) {
+    video_t *video = context;
+    video_clear(video);
+    for (int index = 0; index < RECT_COUNT; index++) {
+        SDL_Color c = colors[(index / (RECT_COUNT / COLOR_COUNT)) % COLOR_COUNT];
+        video_set_color(video, c.r, c.g, c.b, c.a);
+        video_draw_region(video, &rects[index]);
+    }
+    video_render(video);
+}
+
+static void bench_immediate(bench_t *bench) {
+    SDL_Surface *target = SDL_CreateRGBSurfaceWithFormat(0, FRAME_WIDTH, FRAME_HEIGHT,
+                                                         32, SDL_PIXELFORMAT_RGBA32);
+    SDL_Renderer *renderer = SDL_CreateSoftwareRenderer(target);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+
+    bench_run(bench, "rects/immediate", run_immediate, renderer, 1);
+
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(target);
+}
+
+int main(int argc, char *argv[]) {
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+
+    bench_t *bench = bench_init("rects", argc, argv);
+    if (!bench) {
+        return EXIT_FAILURE;
+    }
+
+    video_t *video = video_init(&(video_cfg_t){.window_title  = "bench",
+                                               .window_width  = FRAME_WIDTH,
+                                               .window_height = FRAME_HEIGHT});
+    if (!video) {
+        bench_term(bench);
+        return EXIT_FAILURE;
+    }
+
+    rects_init();
+
+    bench_immediate(bench);
+    bench_run(bench, "rects/batched", run_batched, video, 1);
+
+    video_stats_t stats;
+    video_get_stats(video, &stats);
+
+    printf("rects: immediate issues %d renderer calls/frame, batched %lu\n",
+           RECT_COUNT * 2 + 2, (stats.batches + stats.state_changes) / stats.frames);
+
+    video_term(video);
+    SDL_Quit();
+    return bench_term(bench);
+}
@@ -0,0 +1,150 @@
+/**
+ * Text Rendering Benchmark.
+ *
+ * Compares the per-frame cost of the old text path (rasterize, upload and destroy
+ * every string, every frame) against immediate glyph atlas draws and retained
+ * text, using the strings of the busiest overlay state. Runs headless on the SDL
+ * dummy video driver. One op is one frame.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+#include <SDL_ttf.h>
+
+#include "app/video.h"
+#include "bench/bench.h"
+
+#define FRAME_WIDTH  640
+#define FRAME_HEIGHT 480
+
+/** Strings drawn per frame in the pause state (two scores plus overlay). */
+#define FRAME_STRING_COUNT 3
+static char *frame_strings[FRAME_STRING_COUNT] = {"0", "3", "Paused"};
+
+/**
+ * Previous `video_draw_text_with_color` implementation, kept for comparison.
+ */
+static void legacy_draw_text(SDL_Renderer *renderer, TTF_Font *font, char *str, int x,
+                             int y) {
+    SDL_Color color      = {255, 255, 255, 255};
+    SDL_Surface *surface = TTF_RenderText_Solid(font, str, color);
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+
+    SDL_RenderCopy(renderer, texture, NULL,
+                   &(SDL_Rect){x - (surface->w / 2), y - (surface->h / 2), surface->w,
+                               surface->h});
+
+    SDL_DestroyTexture(texture);
+    SDL_FreeSurface(surface);
+}
+
+typedef struct {
+    SDL_Renderer *renderer;
+    TTF_Font *font;
+} legacy_context_t;
+
+static void run_legacy(void *context) {
+    legacy_context_t *legacy = context;
+    SDL_RenderClear(legacy->renderer);
+    for (size_t index = 0; index < FRAME_STRING_COUNT; index++) {
+        legacy_draw_text(legacy->renderer, legacy->font, frame_strings[index], 320,
+                         48 * index);
+    }
+}
+
+static void run_atlas(void *context) {
+    video_t *video = context;
+    video_clear(video);
+    for (size_t index = 0; index < FRAME_STRING_COUNT; index++) {
+        video_draw_text(video, frame_strings[index], 320, 48 * index);
+    }
+}
+
+typedef struct {
+    video_t *video;
+    video_text_t *texts[FRAME_STRING_COUNT];
+} retained_context_t;
+
+static void run_retained(void *context) {
+    retained_context_t *retained = context;
+    video_clear(retained->video);
+    for (size_t index = 0; index < FRAME_STRING_COUNT; index++) {
+        video_text_draw(retained->video, retained->texts[index], 320, 48 * index);
+    }
+}
+
+static double bench_legacy(bench_t *bench) {
+    // The game no longer starts SDL_ttf; only this comparison uses it.
+    if (TTF_Init() < 0) {
+        fprintf(stderr, "legacy setup failed: %s\n", TTF_GetError());
+        exit(EXIT_FAILURE);
+    }
+    SDL_Surface *target = SDL_CreateRGBSurfaceWithFormat(0, FRAME_WIDTH, FRAME_HEIGHT,
+                                                         32, SDL_PIXELFORMAT_RGBA32);
+    legacy_context_t legacy = {SDL_CreateSoftwareRenderer(target),
+                               TTF_OpenFont("res/font.ttf", 24)};
+
+    if (!legacy.renderer || !legacy.font) {
+        fprintf(stderr, "legacy setup failed: %s\n", SDL_GetError());
+        exit(EXIT_FAILURE);
+    }
+
+    bench_run(bench, "text/legacy", run_legacy, &legacy, 1);
+
+    TTF_CloseFont(legacy.font);
+    SDL_DestroyRenderer(legacy.renderer);
+    SDL_FreeSurface(target);
+    TTF_Quit();
+
+    return bench_get_last_ns_per_op(bench);
+}
+
+static double bench_atlas(bench_t *bench, video_t *video) {
+    bench_run(bench, "text/atlas", run_atlas, video, 1);
+    return bench_get_last_ns_per_op(bench);
+}
+
+static double bench_retained(bench_t *bench, video_t *video) {
+    retained_context_t retained = {.video = video};
+    for (size_t index = 0; index < FRAME_STRING_COUNT; index++) {
+        retained.texts[index] = video_text_init(video, frame_strings[index]);
+    }
+
+    bench_run(bench, "text/retained", run_retained, &retained, 1);
+
+    for (size_t index = 0; index < FRAME_STRING_COUNT; index++) {
+        video_text_term(retained.texts[index]);
+    }
+
+    return bench_get_last_ns_per_op(bench);
+}
+
+int main(int argc, char *argv[]) {
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+
+    bench_t *bench = bench_init("text", argc, argv);
+    if (!bench) {
+        return EXIT_FAILURE;
+    }
+
+    video_t *video = video_init(&(video_cfg_t){.window_title  = "bench",
+                                               .window_width  = FRAME_WIDTH,
+                                               .window_height = FRAME_HEIGHT});
+    if (!video) {
+        bench_term(bench);
+        return EXIT_FAILURE;
+    }
+
+    double legacy_ns   = bench_legacy(bench);
+    double atlas_ns    = bench_atlas(bench, video);
+    double retained_ns = bench_retained(bench, video);
+
+    printf("text: atlas %.2fx, retained %.2fx faster than legacy\n",
+           legacy_ns / atlas_ns, legacy_ns / retained_ns);
+
+    video_term(video);
+    SDL_Quit();
+    return bench_term(bench);
+}
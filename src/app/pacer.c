@@ -0,0 +1,134 @@
+#include <math.h>
+
+#include "SDL.h"
+
+#include "alloc.h"
+#include "pacer.h"
+
+// Time left to spin after sleeping until the spread of sleep times is known.
+#define INITIAL_SLEEP_MARGIN_MS 2.0
+
+// Standard deviations of sleep time kept in hand, so a slow wake-up rarely
+// makes a frame late.
+#define SLEEP_MARGIN_DEVIATIONS 2.0
+
+// Most time spun per frame; a scheduler any more erratic is not worth burning a
+// core to beat.
+#define MAX_SLEEP_MARGIN_MS 4.0
+
+typedef struct pacer_s {
+    bool is_waiting;      // Paced by timer, not VSync.
+    double frequency;     // Counter ticks per second.
+    uint64_t period;      // Counter ticks per frame.
+    uint64_t deadline;    // When the current frame is due to end.
+    uint64_t frame_start; // When the current frame started.
+
+    // --- Duration of a 1 ms sleep: running mean and sum of squared deviations
+    unsigned long sleep_count;
+    double sleep_mean_ms;
+    double sleep_m2;
+
+    // --- Frame times, likewise
+    pacer_stats_t stats;
+    double frame_m2;
+} pacer_t;
+
+/**
+ * Fold one sample into a running mean and sum of squared deviations (Welford).
+ */
+static void accumulate(double sample, unsigned long count, double *mean, double *m2) {
+    double const deviation = sample - *mean;
+    *mean += deviation / count;
+    *m2 += deviation * (sample - *mean);
+}
+
+/**
+ * Time to stop sleeping before a deadline and spin instead.
+ */
+static double sleep_margin_ms(pacer_t const *pacer) {
+    if (pacer->sleep_count < 2) {
+        return INITIAL_SLEEP_MARGIN_MS;
+    }
+    double const deviation = sqrt(pacer->sleep_m2 / (pacer->sleep_count - 1));
+    double const margin    = pacer->sleep_mean_ms + SLEEP_MARGIN_DEVIATIONS * deviation;
+    return margin < MAX_SLEEP_MARGIN_MS ? margin : MAX_SLEEP_MARGIN_MS;
+}
+
+/**
+ * Sleep, a millisecond at a time, until the deadline is within the margin, then
+ * spin until it passes.
+ */
+static void wait_until(pacer_t *pacer, uint64_t deadline) {
+    uint64_t now = SDL_GetPerformanceCounter();
+    while (now < deadline &&
+           (deadline - now) * 1000 / pacer->frequency > sleep_margin_ms(pacer)) {
+        SDL_Delay(1);
+        uint64_t const woken = SDL_GetPerformanceCounter();
+        accumulate((woken - now) * 1000 / pacer->frequency, ++pacer->sleep_count,
+                   &pacer->sleep_mean_ms, &pacer->sleep_m2);
+        now = woken;
+    }
+    while (SDL_GetPerformanceCounter() < deadline) {
+        // Spin; only the counter is fine enough for the last stretch.
+    }
+}
+
+static void record_frame(pacer_t *pacer, uint64_t frame_end) {
+    pacer_stats_t *stats = &pacer->stats;
+    double const ms      = (frame_end - pacer->frame_start) * 1000 / pacer->frequency;
+    pacer->frame_start   = frame_end;
+
+    stats->frame_count++;
+    accumulate(ms, stats->frame_count, &stats->mean_ms, &pacer->frame_m2);
+    stats->min_ms = stats->frame_count == 1 || ms < stats->min_ms ? ms : stats->min_ms;
+    stats->max_ms = ms > stats->max_ms ? ms : stats->max_ms;
+}
+
+void pacer_wait(pacer_t *pacer) {
+    if (!pacer->is_waiting) {
+        record_frame(pacer, SDL_GetPerformanceCounter());
+        return;
+    }
+
+    uint64_t const now = SDL_GetPerformanceCounter();
+    if (now < pacer->deadline) {
+        wait_until(pacer, pacer->deadline);
+    } else {
+        pacer->stats.late_count++;
+        // More than a frame behind: start afresh rather than rush frames out.
+        if (now - pacer->deadline >= pacer->period) {
+            pacer->deadline = now;
+        }
+    }
+    record_frame(pacer, SDL_GetPerformanceCounter());
+    pacer->deadline += pacer->period;
+}
+
+void pacer_get_stats(pacer_t const *pacer, pacer_stats_t *stats) {
+    *stats                 = pacer->stats;
+    stats->jitter_ms       = stats->frame_count > 1
+                                 ? sqrt(pacer->frame_m2 / (stats->frame_count - 1))
+                                 : 0;
+    stats->sleep_margin_ms = sleep_margin_ms(pacer);
+}
+
+pacer_t *pacer_init(pacer_config_t const *config) {
+    pacer_t *pacer = new (pacer_t);
+    if (!pacer) {
+        return NULL;
+    }
+    pacer->is_waiting    = config->frame_rate && !config->is_vsync;
+    pacer->frequency     = SDL_GetPerformanceFrequency();
+    pacer->period        = config->frame_rate ? pacer->frequency / config->frame_rate
+                                              : 0;
+    pacer->frame_start   = SDL_GetPerformanceCounter();
+    pacer->deadline      = pacer->frame_start + pacer->period;
+    pacer->sleep_count   = 0;
+    pacer->sleep_mean_ms = 0;
+    pacer->sleep_m2      = 0;
+    pacer->stats         = (pacer_stats_t){0};
+    pacer->frame_m2      = 0;
+    return pacer;
+}
+
+void pacer_term(pacer_t *pacer) { delete (pacer); }
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Frame Pacer Configuration Parameters.
+ */
+typedef struct {
+  unsigned short frame_rate; // Frames per second to pace to (0: unpaced).
+  bool is_vsync;             // Presenting already waits for the display.
+} pacer_config_t;
+
+/**
+ * Frame times measured at the pace point, accumulated since initialization.
+ *
+ * Jitter is the standard deviation of the frame time; a steady 60 Hz loop
+ * shows a mean of 16.667 ms with jitter well under a millisecond.
+ */
+typedef struct {
+  unsigned long frame_count; // Frame times measured.
+  double mean_ms;            // Mean frame time.
+  double jitter_ms;          // Standard deviation of the frame time.
+  double min_ms;             // Shortest frame.
+  double max_ms;             // Longest frame.
+  unsigned long late_count;  // Frames whose work ran past their deadline.
+  double sleep_margin_ms;    // Time left to spin after sleeping, as last estimated.
+} pacer_stats_t;
+
+typedef struct pacer_s pacer_t;
+
+/**
+ * Initialize a frame pacer, starting the first frame now.
+ *
+ * \returns NULL if out of memory.
+ * \sa pacer_term
+ */
+pacer_t *pacer_init(pacer_config_t const *config);
+
+void pacer_term(pacer_t *pacer);
+
+/**
+ * End the frame: wait until the next frame is due, then start it.
+ *
+ * Deadlines are absolute, one frame period apart, so time lost oversleeping
+ * one frame is taken back from the next rather than accumulating. The wait
+ * sleeps while the deadline is further off than the scheduler has been seen to
+ * oversleep, then spins on the performance counter for the rest.
+ *
+ * With VSync, or an unpaced frame rate, nothing is waited for; frame times are
+ * only measured.
+ */
+void pacer_wait(pacer_t *pacer);
+
+void pacer_get_stats(pacer_t const *pacer, pacer_stats_t *stats);
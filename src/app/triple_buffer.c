@@ -0,0 +1,77 @@
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "alloc.h"
+#include "triple_buffer.h"
+
+// Set in `middle` when the slot there was published after the reader last took
+// one.
+#define FRESH 4u
+
+// Keeps the writer's and reader's own fields off each other's cache line.
+#define CACHE_LINE 64
+
+typedef struct triple_buffer_s {
+    unsigned char *slots; // Three, back to back.
+    size_t slot_size;
+    atomic_uint middle; // Slot handed between them, or'd with FRESH.
+
+    _Alignas(CACHE_LINE) unsigned back; // Writer's slot.
+
+    _Alignas(CACHE_LINE) unsigned front; // Reader's slot.
+    bool has_front;                      // Taken a published slot yet?
+} triple_buffer_t;
+
+triple_buffer_t *triple_buffer_init(size_t slot_size) {
+    triple_buffer_t *buffer = new (triple_buffer_t);
+    if (!buffer) {
+        return NULL;
+    }
+    // Round slots up so that each is aligned for anything.
+    size_t const alignment = _Alignof(max_align_t);
+    slot_size              = (slot_size + alignment - 1) / alignment * alignment;
+
+    if (!(buffer->slots = new_clean(3 * slot_size, unsigned char))) {
+        delete (buffer);
+        return NULL;
+    }
+    buffer->slot_size = slot_size;
+    buffer->back      = 0;
+    buffer->front     = 1;
+    buffer->has_front = false;
+    atomic_init(&buffer->middle, 2);
+    return buffer;
+}
+
+void triple_buffer_term(triple_buffer_t *buffer) {
+    if (!buffer) {
+        return;
+    }
+    delete (buffer->slots);
+    delete (buffer);
+}
+
+void *triple_buffer_get_back(triple_buffer_t *buffer) {
+    return buffer->slots + buffer->back * buffer->slot_size;
+}
+
+void triple_buffer_publish(triple_buffer_t *buffer) {
+    // Release the slot's contents along with it; acquire whatever the reader
+    // last left in the one taken back.
+    unsigned previous = atomic_exchange_explicit(&buffer->middle, buffer->back | FRESH,
+                                                 memory_order_acq_rel);
+    buffer->back      = previous & ~FRESH;
+}
+
+void const *triple_buffer_get_front(triple_buffer_t *buffer) {
+    if (atomic_load_explicit(&buffer->middle, memory_order_relaxed) & FRESH) {
+        unsigned previous = atomic_exchange_explicit(&buffer->middle, buffer->front,
+                                                     memory_order_acq_rel);
+        buffer->front     = previous & ~FRESH;
+        buffer->has_front = true;
+    }
+    if (!buffer->has_front) {
+        return NULL;
+    }
+    return buffer->slots + buffer->front * buffer->slot_size;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct triple_buffer_s triple_buffer_t;
+
+/**
+ * Initialize a triple buffer: three slots of `slot_size` bytes, each aligned
+ * for any type, passed between one writer thread and one reader thread without
+ * locks.
+ *
+ * The writer fills its back slot and publishes it. The reader takes the latest
+ * published slot whenever it wants; the writer never waits for the reader, and
+ * the reader never sees a slot being written.
+ *
+ * \returns NULL if out of memory.
+ * \sa triple_buffer_term
+ */
+triple_buffer_t *triple_buffer_init(size_t slot_size);
+
+void triple_buffer_term(triple_buffer_t *buffer);
+
+/**
+ * Get the writer's slot. It holds whatever was published two slots ago (or
+ * zeros), so fill it in full.
+ */
+void *triple_buffer_get_back(triple_buffer_t *buffer);
+
+/**
+ * Publish the writer's slot, and take another to write next.
+ */
+void triple_buffer_publish(triple_buffer_t *buffer);
+
+/**
+ * Get the latest published slot, for the reader; it stays put until the next
+ * call, however often the writer publishes meanwhile.
+ *
+ * \returns NULL until the writer has published once.
+ */
+void const *triple_buffer_get_front(triple_buffer_t *buffer);
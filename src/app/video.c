@@ -1,26 +1,603 @@
+#include <assert.h>
+#include <string.h>
+
 #include <SDL2/SDL.h>
-#include <SDL_ttf.h>
 
 #include "log.h"
 
 #include "alloc.h"
+#include "baked_font.h"
+#include "profile/profile.h"
 #include "video.h"
 
+// -----------------------------------------------------------------------------
+// Glyph Atlas
+// -----------------------------------------------------------------------------
+
+// --- Upper bound on glyphs submitted by a single text draw call.
+#define TEXT_MAX_GLYPHS 128
+
+/** Location and metrics of a single glyph within the atlas. */
+typedef struct {
+    SDL_Rect region;
+    int advance;
+} glyph_t;
+
+/** All printable glyphs of the baked font, uploaded once into one texture. */
+typedef struct {
+    SDL_Texture *texture;
+    int width;
+    int height;
+    int line_height;
+    glyph_t glyphs[BAKED_FONT_GLYPH_COUNT];
+} glyph_atlas_t;
+
+// -----------------------------------------------------------------------------
+// Command Buffer
+// -----------------------------------------------------------------------------
+
+// --- How many recorded commands a new rect may hop back over to join a batch.
+#define CMD_LOOKBACK 8
+
+typedef enum {
+    VIDEO_CMD_CLEAR,
+    VIDEO_CMD_RECTS,
+    VIDEO_CMD_GLYPHS,
+    VIDEO_CMD_TARGET,
+    VIDEO_CMD_COPY,
+} video_cmd_type_t;
+
+/**
+ * One renderer submission: a clear, a same-colored rect batch, an atlas batch,
+ * a switch of render target, or a layer copy.
+ *
+ * `first` and `count` index rects (for rect batches) or quads (for glyph batches).
+ */
+typedef struct {
+    video_cmd_type_t type;
+    SDL_Color color;
+    SDL_Rect bounds;
+    int first;
+    int count;
+    SDL_Texture *texture; // Drawn into from now on (NULL: the screen), or copied.
+} video_cmd_t;
+
+/**
+ * Draw calls recorded during a frame, submitted all at once by `video_render`.
+ */
+typedef struct {
+    video_cmd_t *cmds;
+    int cmd_count;
+    int cmd_capacity;
+
+    // Rects in recording order, tagged with the command that owns them.
+    SDL_FRect *rects;
+    int *rect_owners;
+    SDL_FRect *sorted_rects;
+    int rect_count;
+    int rect_capacity;
+    bool is_rect_order_dirty;
+
+    SDL_Vertex *vertices;
+    int vertex_count;
+    int vertex_capacity;
+
+    // Counts at the end of the last finished layer, which a clear does not drop.
+    int kept_cmd_count;
+    int kept_rect_count;
+    int kept_vertex_count;
+
+    // Constant quad index pattern, shared by all glyph batches.
+    int *indices;
+    int index_quad_capacity;
+} video_cmd_buffer_t;
+
 // -----------------------------------------------------------------------------
 // Static SDL2 Resources
 // -----------------------------------------------------------------------------
 
 typedef struct video_s {
+    bool is_headless;
+    bool is_vsync; // Presenting waits for the display.
+    int width;
+    int height;
     SDL_Window *window;
     SDL_Renderer *renderer;
-    TTF_Font *font;
+    glyph_atlas_t atlas;
+    video_cmd_buffer_t cmd;
+    // --- Draw State
+    video_layer_t *recording; // Layer between `video_layer_begin` and its end.
+    SDL_Color color;
+    SDL_Color renderer_color;
+    bool is_renderer_color_known;
+    // --- Statistics
+    video_stats_t stats;
 } video_t;
 
+/**
+ * Upload a font baked at build time (see tools/font_baker.c) as the atlas
+ * texture. No font file is read and nothing is rasterized.
+ *
+ * Coverage becomes the alpha of white texels, so color is still applied
+ * per-vertex at draw time.
+ */
+static bool glyph_atlas_init(glyph_atlas_t *atlas, SDL_Renderer *renderer,
+                             baked_font_t const *font) {
+    atlas->texture = NULL;
+
+    if (font->first_glyph != BAKED_FONT_FIRST_GLYPH ||
+        font->glyph_count != BAKED_FONT_GLYPH_COUNT) {
+        log_error("Baked font %s covers other glyphs than the atlas", font->name);
+        return false;
+    }
+
+    atlas->width       = font->width;
+    atlas->height      = font->height;
+    atlas->line_height = font->line_height;
+    for (int index = 0; index < BAKED_FONT_GLYPH_COUNT; index++) {
+        baked_glyph_t const *baked = &font->glyphs[index];
+
+        atlas->glyphs[index] = (glyph_t){
+            .region  = {baked->x, baked->y, baked->w, baked->h},
+            .advance = baked->advance,
+        };
+    }
+
+    // --- Expand coverage to white texels
+    int const texel_count = font->width * font->height;
+    Uint32 *texels        = new_array(texel_count, Uint32);
+    if (!texels) {
+        log_error("Out of memory for the glyph atlas");
+        return false;
+    }
+    for (int index = 0; index < texel_count; index++) {
+        texels[index] = 0xFFFFFF00u | font->coverage[index];
+    }
+
+    // --- Upload once
+    atlas->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                                       SDL_TEXTUREACCESS_STATIC, font->width,
+                                       font->height);
+    int const pitch = font->width * sizeof *texels;
+    if (atlas->texture && SDL_UpdateTexture(atlas->texture, NULL, texels, pitch)) {
+        SDL_DestroyTexture(atlas->texture);
+        atlas->texture = NULL;
+    }
+    delete (texels);
+
+    if (!atlas->texture) {
+        log_error(SDL_GetError());
+        return false;
+    }
+
+    SDL_SetTextureBlendMode(atlas->texture, SDL_BLENDMODE_BLEND);
+    return true;
+}
+
+static void glyph_atlas_term(glyph_atlas_t *atlas) {
+    SDL_DestroyTexture(atlas->texture);
+    atlas->texture = NULL;
+}
+
+/**
+ * Get atlas entry for `ch`, substituting `?` for glyphs outside the atlas.
+ */
+static glyph_t *glyph_atlas_get(glyph_atlas_t *atlas, char ch) {
+    if (ch < BAKED_FONT_FIRST_GLYPH || ch > BAKED_FONT_LAST_GLYPH) {
+        ch = '?';
+    }
+    return &atlas->glyphs[ch - BAKED_FONT_FIRST_GLYPH];
+}
+
+/**
+ * Get the width in pixels of `str` when drawn from the atlas.
+ */
+static int glyph_atlas_measure(glyph_atlas_t *atlas, char const *str) {
+    int width = 0;
+    for (char const *ch = str; *ch; ch++) {
+        width += glyph_atlas_get(atlas, *ch)->advance;
+    }
+    return width;
+}
+
+// -----------------------------------------------------------------------------
+// Command Recording
+// -----------------------------------------------------------------------------
+
+/**
+ * Get capacity (doubling, from a minimum of 64) that fits `required` elements.
+ */
+static int cmd_buffer_grow_capacity(int capacity, int required) {
+    capacity = capacity ? capacity : 64;
+    while (capacity < required) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+/**
+ * Grow `buffer` so it holds at least `required` elements of `size` bytes.
+ *
+ * \returns the grown buffer, or NULL if out of memory, leaving `buffer` and
+ *          `capacity` as they were.
+ */
+static void *cmd_buffer_reserve(void *buffer, int *capacity, int required,
+                                size_t size) {
+    if (required <= *capacity) {
+        return buffer;
+    }
+    int grown_capacity = cmd_buffer_grow_capacity(*capacity, required);
+    void *grown        = realloc(buffer, grown_capacity * size);
+    if (!grown) {
+        log_error("Out of memory recording draws; dropping a draw");
+        return NULL;
+    }
+    *capacity = grown_capacity;
+    return grown;
+}
+
+/**
+ * Grow the rect arrays, which share one capacity.
+ *
+ * \returns false if out of memory. Arrays already grown are kept, but the
+ *          capacity stays what all of them hold.
+ */
+static bool cmd_buffer_reserve_rects(video_cmd_buffer_t *cmd, int required) {
+    if (required <= cmd->rect_capacity) {
+        return true;
+    }
+    int capacity = cmd_buffer_grow_capacity(cmd->rect_capacity, required);
+
+    SDL_FRect *rects = realloc(cmd->rects, capacity * sizeof(SDL_FRect));
+    if (rects) {
+        cmd->rects = rects;
+    }
+    int *rect_owners = realloc(cmd->rect_owners, capacity * sizeof(int));
+    if (rect_owners) {
+        cmd->rect_owners = rect_owners;
+    }
+    SDL_FRect *sorted_rects = realloc(cmd->sorted_rects, capacity * sizeof(SDL_FRect));
+    if (sorted_rects) {
+        cmd->sorted_rects = sorted_rects;
+    }
+
+    if (!rects || !rect_owners || !sorted_rects) {
+        log_error("Out of memory recording draws; dropping a draw");
+        return false;
+    }
+    cmd->rect_capacity = capacity;
+    return true;
+}
+
+static void cmd_buffer_term(video_cmd_buffer_t *cmd) {
+    free(cmd->cmds);
+    free(cmd->rects);
+    free(cmd->rect_owners);
+    free(cmd->sorted_rects);
+    free(cmd->vertices);
+    free(cmd->indices);
+    *cmd = (video_cmd_buffer_t){0};
+}
+
+/**
+ * Drop everything recorded so far (storage is kept for the next frame).
+ */
+static void cmd_buffer_reset(video_cmd_buffer_t *cmd) {
+    cmd->cmd_count           = 0;
+    cmd->rect_count          = 0;
+    cmd->vertex_count        = 0;
+    cmd->is_rect_order_dirty = false;
+    cmd->kept_cmd_count      = 0;
+    cmd->kept_rect_count     = 0;
+    cmd->kept_vertex_count   = 0;
+}
+
+/**
+ * Keep everything recorded so far through `cmd_buffer_drop_unkept`.
+ */
+static void cmd_buffer_keep(video_cmd_buffer_t *cmd) {
+    cmd->kept_cmd_count    = cmd->cmd_count;
+    cmd->kept_rect_count   = cmd->rect_count;
+    cmd->kept_vertex_count = cmd->vertex_count;
+}
+
+/**
+ * Drop everything recorded since the last `cmd_buffer_keep`.
+ *
+ * Rects and quads never join a batch across a render target switch, so those
+ * recorded since belong only to the commands dropped.
+ */
+static void cmd_buffer_drop_unkept(video_cmd_buffer_t *cmd) {
+    cmd->cmd_count    = cmd->kept_cmd_count;
+    cmd->rect_count   = cmd->kept_rect_count;
+    cmd->vertex_count = cmd->kept_vertex_count;
+}
+
+/**
+ * Record a command.
+ *
+ * \returns the command, or NULL if out of memory (nothing is recorded).
+ */
+static video_cmd_t *cmd_buffer_push(video_cmd_buffer_t *cmd, video_cmd_type_t type,
+                                    SDL_Color color, SDL_Rect *bounds, int first) {
+    video_cmd_t *cmds = cmd_buffer_reserve(cmd->cmds, &cmd->cmd_capacity,
+                                           cmd->cmd_count + 1, sizeof(video_cmd_t));
+    if (!cmds) {
+        return NULL;
+    }
+    cmd->cmds      = cmds;
+    video_cmd_t *c = &cmd->cmds[cmd->cmd_count++];
+    c->type        = type;
+    c->color       = color;
+    c->bounds      = *bounds;
+    c->first       = first;
+    c->count       = 0;
+    c->texture     = NULL;
+    return c;
+}
+
+static bool is_same_color(SDL_Color a, SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+/**
+ * Find a rect batch of `color` that `rect` can join without changing the image.
+ *
+ * Walks back over at most `CMD_LOOKBACK` commands; joining an earlier batch moves
+ * `rect` beneath every command in between, so none of them may overlap it.
+ *
+ * \returns command index, or -1 if a new batch is needed.
+ */
+static int cmd_buffer_find_rect_batch(video_cmd_buffer_t *cmd, SDL_Color color,
+                                      SDL_Rect *rect) {
+    int last = cmd->cmd_count - 1;
+    for (int index = last; index >= 0 && last - index < CMD_LOOKBACK; index--) {
+        video_cmd_t *c = &cmd->cmds[index];
+        if (c->type == VIDEO_CMD_RECTS && is_same_color(c->color, color)) {
+            return index;
+        }
+        if (c->type == VIDEO_CMD_CLEAR || c->type == VIDEO_CMD_TARGET ||
+            SDL_HasIntersection(&c->bounds, rect)) {
+            return -1;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Get the whole-pixel rect covering every pixel `rect` touches.
+ */
+static SDL_Rect get_covering_rect(SDL_FRect *rect) {
+    int left   = (int)SDL_floorf(rect->x);
+    int top    = (int)SDL_floorf(rect->y);
+    int right  = (int)SDL_ceilf(rect->x + rect->w);
+    int bottom = (int)SDL_ceilf(rect->y + rect->h);
+    return (SDL_Rect){left, top, right - left, bottom - top};
+}
+
+static void cmd_buffer_push_rect(video_cmd_buffer_t *cmd, SDL_Color color,
+                                 SDL_FRect *rect) {
+    if (!cmd_buffer_reserve_rects(cmd, cmd->rect_count + 1)) {
+        return;
+    }
+
+    SDL_Rect bounds = get_covering_rect(rect);
+    int owner       = cmd_buffer_find_rect_batch(cmd, color, &bounds);
+
+    if (owner < 0) {
+        if (!cmd_buffer_push(cmd, VIDEO_CMD_RECTS, color, &bounds, cmd->rect_count)) {
+            return;
+        }
+        owner = cmd->cmd_count - 1;
+    } else {
+        video_cmd_t *c = &cmd->cmds[owner];
+        SDL_UnionRect(&c->bounds, &bounds, &c->bounds);
+        cmd->is_rect_order_dirty |= owner != cmd->cmd_count - 1;
+    }
+
+    cmd->rects[cmd->rect_count]       = *rect;
+    cmd->rect_owners[cmd->rect_count] = owner;
+    cmd->rect_count++;
+    cmd->cmds[owner].count++;
+}
+
+/**
+ * Get space for up to `quad_count` glyph quads at the end of the vertex buffer.
+ *
+ * \returns NULL if out of memory.
+ * \sa cmd_buffer_commit_glyphs
+ */
+static SDL_Vertex *cmd_buffer_reserve_glyphs(video_cmd_buffer_t *cmd, int quad_count) {
+    SDL_Vertex *vertices =
+        cmd_buffer_reserve(cmd->vertices, &cmd->vertex_capacity,
+                           cmd->vertex_count + quad_count * 4, sizeof(SDL_Vertex));
+    if (!vertices) {
+        return NULL;
+    }
+    cmd->vertices = vertices;
+    return cmd->vertices + cmd->vertex_count;
+}
+
+/**
+ * Record `quad_count` quads written into space from `cmd_buffer_reserve_glyphs`.
+ *
+ * Consecutive glyph draws share one batch, as their vertices are contiguous.
+ */
+static void cmd_buffer_commit_glyphs(video_cmd_buffer_t *cmd, int quad_count,
+                                     SDL_Rect *bounds) {
+    if (!quad_count) {
+        return;
+    }
+
+    video_cmd_t *last = cmd->cmd_count ? &cmd->cmds[cmd->cmd_count - 1] : NULL;
+    if (!last || last->type != VIDEO_CMD_GLYPHS) {
+        last = cmd_buffer_push(cmd, VIDEO_CMD_GLYPHS, (SDL_Color){0}, bounds,
+                               cmd->vertex_count / 4);
+        if (!last) {
+            return;
+        }
+    } else {
+        SDL_UnionRect(&last->bounds, bounds, &last->bounds);
+    }
+
+    last->count += quad_count;
+    cmd->vertex_count += quad_count * 4;
+}
+
+/**
+ * Make each rect batch contiguous in `sorted_rects`, preserving recording order
+ * within each batch (counting sort on owning command).
+ */
+static SDL_FRect *cmd_buffer_sort_rects(video_cmd_buffer_t *cmd) {
+    if (!cmd->is_rect_order_dirty) {
+        return cmd->rects;
+    }
+
+    int offset = 0;
+    for (int index = 0; index < cmd->cmd_count; index++) {
+        video_cmd_t *c = &cmd->cmds[index];
+        if (c->type == VIDEO_CMD_RECTS) {
+            c->first = offset;
+            offset += c->count;
+        }
+    }
+
+    // `first` doubles as a write cursor, then is wound back afterwards.
+    for (int index = 0; index < cmd->rect_count; index++) {
+        video_cmd_t *c                = &cmd->cmds[cmd->rect_owners[index]];
+        cmd->sorted_rects[c->first++] = cmd->rects[index];
+    }
+    for (int index = 0; index < cmd->cmd_count; index++) {
+        video_cmd_t *c = &cmd->cmds[index];
+        if (c->type == VIDEO_CMD_RECTS) {
+            c->first -= c->count;
+        }
+    }
+
+    return cmd->sorted_rects;
+}
+
+/**
+ * Make sure the shared quad index pattern covers `quad_count` quads.
+ *
+ * \returns NULL if out of memory.
+ */
+static int *cmd_buffer_get_indices(video_cmd_buffer_t *cmd, int quad_count) {
+    int old_capacity = cmd->index_quad_capacity;
+    if (quad_count <= old_capacity) {
+        return cmd->indices;
+    }
+
+    int *indices = cmd_buffer_reserve(cmd->indices, &cmd->index_quad_capacity,
+                                      quad_count, 6 * sizeof(int));
+    if (!indices) {
+        return NULL;
+    }
+    cmd->indices = indices;
+
+    for (int quad = old_capacity; quad < cmd->index_quad_capacity; quad++) {
+        int *index = cmd->indices + quad * 6;
+        int vertex = quad * 4;
+        index[0]   = vertex + 0;
+        index[1]   = vertex + 1;
+        index[2]   = vertex + 2;
+        index[3]   = vertex + 2;
+        index[4]   = vertex + 3;
+        index[5]   = vertex + 0;
+    }
+
+    return cmd->indices;
+}
+
+// -----------------------------------------------------------------------------
+// Command Submission
+// -----------------------------------------------------------------------------
+
+/**
+ * Set renderer draw color, skipping the call if it would not change anything.
+ */
+static void video_apply_color(video_t *v, SDL_Color color) {
+    if (v->is_renderer_color_known && is_same_color(v->renderer_color, color)) {
+        return;
+    }
+    SDL_SetRenderDrawColor(v->renderer, color.r, color.g, color.b, color.a);
+    v->renderer_color          = color;
+    v->is_renderer_color_known = true;
+    v->stats.state_changes++;
+}
+
+/**
+ * Submit every recorded command to the renderer, in order.
+ */
+static void video_flush(video_t *v) {
+    video_cmd_buffer_t *cmd = &v->cmd;
+    SDL_FRect *rects        = cmd_buffer_sort_rects(cmd);
+    SDL_Texture *target     = NULL;
+    int *indices            = NULL;
+
+    for (int index = 0; index < cmd->cmd_count; index++) {
+        video_cmd_t *c = &cmd->cmds[index];
+        switch (c->type) {
+        case VIDEO_CMD_CLEAR:
+            video_apply_color(v, c->color);
+            SDL_RenderClear(v->renderer);
+            break;
+        case VIDEO_CMD_RECTS:
+            video_apply_color(v, c->color);
+            SDL_RenderFillRectsF(v->renderer, rects + c->first, c->count);
+            v->stats.rects += c->count;
+            break;
+        case VIDEO_CMD_GLYPHS:
+            indices = cmd_buffer_get_indices(cmd, c->count);
+            if (!indices) {
+                break;
+            }
+            SDL_RenderGeometry(v->renderer, v->atlas.texture,
+                               cmd->vertices + c->first * 4, c->count * 4, indices,
+                               c->count * 6);
+            v->stats.glyphs += c->count;
+            break;
+        case VIDEO_CMD_TARGET:
+            SDL_SetRenderTarget(v->renderer, c->texture);
+            target = c->texture;
+            break;
+        case VIDEO_CMD_COPY:
+            SDL_RenderCopy(v->renderer, c->texture, NULL, &c->bounds);
+            break;
+        }
+        v->stats.batches++;
+    }
+
+    // A layer whose end could not be recorded still must not swallow the present.
+    if (target) {
+        SDL_SetRenderTarget(v->renderer, NULL);
+    }
+    cmd_buffer_reset(cmd);
+}
+
 video_t *video_init(video_cfg_t *config) {
     video_t *v  = new (video_t);
     v->window   = NULL;
     v->renderer = NULL;
-    v->font     = NULL;
+
+    v->atlas     = (glyph_atlas_t){0};
+    v->cmd       = (video_cmd_buffer_t){0};
+    v->recording = NULL;
+    v->color     = (SDL_Color){0, 0, 0, 0};
+    v->stats     = (video_stats_t){0};
+
+    v->is_renderer_color_known = false;
+
+    v->is_headless = config->is_headless;
+    v->is_vsync    = false;
+    v->width       = config->window_width;
+    v->height      = config->window_height;
+
+    // --- Headless
+    // No window, renderer or font: draw calls only update statistics.
+    if (v->is_headless) {
+        return v;
+    }
 
     if (SDL_InitSubSystem(SDL_INIT_VIDEO)) {
         log_error(SDL_GetError());
@@ -38,34 +615,36 @@ video_t *video_init(video_cfg_t *config) {
     }
 
     // --- Renderer
-    // No use for variable index or flags.
+    // No use for variable index.
     static unsigned char const RENDERER_INDEX = 0;
-    static unsigned char const RENDERER_FLAGS = 0;
+    Uint32 const renderer_flags = config->is_vsync ? SDL_RENDERER_PRESENTVSYNC : 0;
 
     if (!(v->renderer =
-              SDL_CreateRenderer(v->window, RENDERER_INDEX, RENDERER_FLAGS))) {
+              SDL_CreateRenderer(v->window, RENDERER_INDEX, renderer_flags))) {
         video_term(v);
         log_error(SDL_GetError());
         return NULL;
     }
 
-    if (SDL_SetRenderDrawBlendMode(v->renderer, SDL_BLENDMODE_BLEND)) {
-        video_term(v);
-        log_error(SDL_GetError());
-        return NULL;
+    SDL_RendererInfo renderer_info;
+    if (!SDL_GetRendererInfo(v->renderer, &renderer_info)) {
+        v->is_vsync = renderer_info.flags & SDL_RENDERER_PRESENTVSYNC;
+    }
+    if (config->is_vsync && !v->is_vsync) {
+        log_warn("VSync unavailable; frames are paced by timer instead");
     }
 
-    // --- Font
-    // TODO: Generalize font selection
-    if (TTF_Init() < 0) {
+    if (SDL_SetRenderDrawBlendMode(v->renderer, SDL_BLENDMODE_BLEND)) {
         video_term(v);
-        log_error(TTF_GetError());
+        log_error(SDL_GetError());
         return NULL;
     }
 
-    if (!(v->font = TTF_OpenFont("res/font.ttf", 24))) {
+    // --- Glyph Atlas
+    // Baked into the binary at build time; no font file is read.
+    if (!glyph_atlas_init(&v->atlas, v->renderer, &baked_font)) {
         video_term(v);
-        log_error(TTF_GetError());
+        log_error("Cannot build glyph atlas");
         return NULL;
     }
 
@@ -76,35 +655,58 @@ void video_term(video_t *v) {
     if (!v) {
         return;
     }
-    TTF_CloseFont(v->font);
-    SDL_DestroyRenderer(v->renderer);
-    SDL_DestroyWindow(v->window);
-    SDL_QuitSubSystem(SDL_INIT_VIDEO);
+    cmd_buffer_term(&v->cmd);
+    if (!v->is_headless) {
+        glyph_atlas_term(&v->atlas);
+        SDL_DestroyRenderer(v->renderer);
+        SDL_DestroyWindow(v->window);
+        SDL_QuitSubSystem(SDL_INIT_VIDEO);
+    }
     delete (v);
 }
 
 /**
  * Clear the screen.
+ *
+ * Screen draws recorded since the last finished layer would be painted over, so
+ * they are dropped. Layers recorded earlier in the frame are kept, as they were
+ * marked up to date when begun.
  */
 void video_clear(video_t *v) {
+    assert(!v->recording && "video_clear called while recording a layer");
     video_reset_color(v);
-    SDL_RenderClear(v->renderer);
+    if (v->is_headless) {
+        return;
+    }
+    cmd_buffer_drop_unkept(&v->cmd);
+    cmd_buffer_push(&v->cmd, VIDEO_CMD_CLEAR, v->color, &(SDL_Rect){0}, 0);
     return;
 }
 
 /**
  * Render all drawn elements.
+ *
+ * Recorded commands are submitted here, batched by state, then presented.
  */
 void video_render(video_t *v) {
+    v->stats.frames++;
+    if (v->is_headless) {
+        return;
+    }
+    profile_zone_t zone = profile_begin("video_render");
+    video_flush(v);
     SDL_RenderPresent(v->renderer);
+    profile_end(&zone);
     return;
 }
 
 /**
  * Set draw color.
+ *
+ * Only recorded; the renderer is updated at flush time, and only when needed.
  */
 void video_set_color(video_t *v, uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
-    SDL_SetRenderDrawColor(v->renderer, r, g, b, a);
+    v->color = (SDL_Color){r, g, b, a};
     return;
 }
 
@@ -120,31 +722,91 @@ void video_reset_color(video_t *g) {
  * Draw specific axis-aligned region
  */
 void video_draw_region(video_t *v, aabb_t *region) {
-    SDL_RenderFillRect(v->renderer, region);
+    faabb_t subpixel_region = {region->x, region->y, region->w, region->h};
+    video_draw_region_f(v, &subpixel_region);
+}
+
+/**
+ * Draw specific axis-aligned region, with sub-pixel position and size.
+ */
+void video_draw_region_f(video_t *v, faabb_t *region) {
+    if (v->is_headless) {
+        v->stats.rects++;
+        return;
+    }
+    cmd_buffer_push_rect(&v->cmd, v->color, region);
     return;
 }
 
+/**
+ * Lay out `str` as atlas quads centered on (`x`, `y`).
+ *
+ * \returns number of quads written to `vertices` (4 vertices each).
+ */
+static int glyph_atlas_layout(glyph_atlas_t *atlas, char const *str, int x, int y,
+                              SDL_Color color, SDL_Vertex *vertices) {
+    float const u_scale = 1.0f / atlas->width;
+    float const v_scale = 1.0f / atlas->height;
+
+    // Centered on (x, y), as a single rendered line would be.
+    int pen_x = x - (glyph_atlas_measure(atlas, str) / 2);
+    int pen_y = y - (atlas->line_height / 2);
+
+    int quad_count = 0;
+    for (char const *ch = str; *ch && quad_count < TEXT_MAX_GLYPHS; ch++) {
+        glyph_t *glyph = glyph_atlas_get(atlas, *ch);
+        SDL_Rect *src  = &glyph->region;
+
+        if (src->w) {
+            float left   = pen_x;
+            float top    = pen_y;
+            float right  = pen_x + src->w;
+            float bottom = pen_y + src->h;
+
+            float u0 = src->x * u_scale;
+            float v0 = src->y * v_scale;
+            float u1 = (src->x + src->w) * u_scale;
+            float v1 = (src->y + src->h) * v_scale;
+
+            SDL_Vertex *quad = vertices + quad_count * 4;
+            quad[0]          = (SDL_Vertex){{left, top}, color, {u0, v0}};
+            quad[1]          = (SDL_Vertex){{right, top}, color, {u1, v0}};
+            quad[2]          = (SDL_Vertex){{right, bottom}, color, {u1, v1}};
+            quad[3]          = (SDL_Vertex){{left, bottom}, color, {u0, v1}};
+            quad_count++;
+        }
+
+        pen_x += glyph->advance;
+    }
+
+    return quad_count;
+}
+
 /**
  * Draw text with specified color.
  *
- * TODO: Make text elements first-class citizens with texture properties.
+ * Glyphs are recorded as atlas quads and batched with neighbouring text.
+ * Prefer `video_text_t` for text that persists across frames.
  */
 void video_draw_text_with_color(video_t *v, char *str, int x, int y, uint8_t r,
                                 uint8_t g, uint8_t b, uint8_t a) {
-    SDL_Surface *surface = TTF_RenderText_Solid(v->font, str, (SDL_Color){r, g, b, a});
-
-    SDL_Texture *texture = SDL_CreateTextureFromSurface(v->renderer, surface);
+    if (v->is_headless) {
+        v->stats.glyphs += strlen(str);
+        return;
+    }
 
-    SDL_RenderCopy(v->renderer, texture, NULL,
-                   &(SDL_Rect){
-                       x - (surface->w / 2),
-                       y - (surface->h / 2),
-                       surface->w,
-                       surface->h,
-                   });
+    glyph_atlas_t *atlas = &v->atlas;
+    SDL_Vertex *vertices = cmd_buffer_reserve_glyphs(&v->cmd, TEXT_MAX_GLYPHS);
+    if (!vertices) {
+        return;
+    }
+    int quad_count =
+        glyph_atlas_layout(atlas, str, x, y, (SDL_Color){r, g, b, a}, vertices);
 
-    SDL_DestroyTexture(texture);
-    SDL_FreeSurface(surface);
+    int width       = glyph_atlas_measure(atlas, str);
+    SDL_Rect bounds = {x - width / 2, y - atlas->line_height / 2, width,
+                       atlas->line_height};
+    cmd_buffer_commit_glyphs(&v->cmd, quad_count, &bounds);
 }
 
 /**
@@ -155,5 +817,253 @@ void video_draw_text(video_t *v, char *str, int x, int y) {
 }
 
 void video_get_window_size(video_t *v, int *w, int *h) {
+    if (v->is_headless) {
+        *w = v->width;
+        *h = v->height;
+        return;
+    }
     SDL_GetWindowSize(v->window, w, h);
 }
+
+// -----------------------------------------------------------------------------
+// Retained Text
+// -----------------------------------------------------------------------------
+
+typedef struct video_text_s {
+    char str[TEXT_MAX_GLYPHS + 1];
+    SDL_Color color;
+    int width;
+    int height;
+    // --- Cached layout (valid while `is_dirty` is false)
+    int x;
+    int y;
+    int quad_count;
+    bool is_dirty;
+    SDL_Vertex vertices[TEXT_MAX_GLYPHS * 4];
+} video_text_t;
+
+/**
+ * Create a retained text element, drawn in white until recolored.
+ */
+video_text_t *video_text_init(video_t *v, char const *str) {
+    video_text_t *text = new (video_text_t);
+    text->str[0]       = '\0';
+    text->color        = (SDL_Color){255, 255, 255, 255};
+    text->width        = 0;
+    text->height       = v->atlas.line_height;
+    text->quad_count   = 0;
+    text->is_dirty     = true;
+    video_text_set_string(v, text, str);
+    return text;
+}
+
+/**
+ * Destroy a retained text element.
+ */
+void video_text_term(video_text_t *text) {
+    if (!text) {
+        return;
+    }
+    delete (text);
+}
+
+/**
+ * Change text content. Layout is only invalidated if the content differs.
+ */
+void video_text_set_string(video_t *v, video_text_t *text, char const *str) {
+    if (!strncmp(text->str, str, TEXT_MAX_GLYPHS)) {
+        return;
+    }
+    strncpy(text->str, str, TEXT_MAX_GLYPHS);
+    text->str[TEXT_MAX_GLYPHS] = '\0';
+    text->width                = glyph_atlas_measure(&v->atlas, text->str);
+    text->is_dirty             = true;
+}
+
+/**
+ * Change text color. Layout is only invalidated if the color differs.
+ */
+void video_text_set_color(video_text_t *text, uint8_t r, uint8_t g, uint8_t b,
+                          uint8_t a) {
+    SDL_Color *color = &text->color;
+    if (color->r == r && color->g == g && color->b == b && color->a == a) {
+        return;
+    }
+    *color         = (SDL_Color){r, g, b, a};
+    text->is_dirty = true;
+}
+
+/**
+ * Draw text centered on (`x`, `y`), re-using the cached layout when unchanged.
+ */
+void video_text_draw(video_t *v, video_text_t *text, int x, int y) {
+    if (v->is_headless) {
+        v->stats.glyphs += strlen(text->str);
+        return;
+    }
+
+    if (text->is_dirty || text->x != x || text->y != y) {
+        text->quad_count = glyph_atlas_layout(&v->atlas, text->str, x, y, text->color,
+                                              text->vertices);
+        text->x          = x;
+        text->y          = y;
+        text->is_dirty   = false;
+    }
+
+    SDL_Vertex *vertices = cmd_buffer_reserve_glyphs(&v->cmd, text->quad_count);
+    if (!vertices) {
+        return;
+    }
+    memcpy(vertices, text->vertices, text->quad_count * 4 * sizeof(SDL_Vertex));
+
+    SDL_Rect bounds = {x - text->width / 2, y - text->height / 2, text->width,
+                       text->height};
+    cmd_buffer_commit_glyphs(&v->cmd, text->quad_count, &bounds);
+}
+
+/**
+ * Get measured text size in pixels.
+ */
+void video_text_get_size(video_text_t *text, int *w, int *h) {
+    *w = text->width;
+    *h = text->height;
+}
+
+// -----------------------------------------------------------------------------
+// Cached Layers
+// -----------------------------------------------------------------------------
+
+typedef struct video_layer_s {
+    SDL_Texture *texture;
+    SDL_Rect bounds; // The whole window, where it is copied to.
+    bool is_opaque;
+    bool is_valid; // Drawn, and not invalidated since.
+} video_layer_t;
+
+/**
+ * Create a layer backed by a render-target texture the size of the window.
+ */
+video_layer_t *video_layer_init(video_t *v, bool is_opaque) {
+    if (v->is_headless || !SDL_RenderTargetSupported(v->renderer)) {
+        return NULL;
+    }
+    int width, height;
+    video_get_window_size(v, &width, &height);
+
+    video_layer_t *layer = new (video_layer_t);
+    if (!layer) {
+        return NULL;
+    }
+    layer->bounds    = (SDL_Rect){0, 0, width, height};
+    layer->is_opaque = is_opaque;
+    layer->is_valid  = false;
+
+    if (!(layer->texture = SDL_CreateTexture(v->renderer, SDL_PIXELFORMAT_RGBA8888,
+                                             SDL_TEXTUREACCESS_TARGET, width,
+                                             height))) {
+        log_warn("Cannot create layer texture (%s); drawing it directly",
+                 SDL_GetError());
+        delete (layer);
+        return NULL;
+    }
+
+    // Blending into a transparent layer leaves its colors already multiplied by
+    // their alpha, so they are copied out without multiplying again. Renderers
+    // without custom blend modes blend plainly, slightly darkening soft edges.
+    SDL_BlendMode const premultiplied = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA,
+        SDL_BLENDOPERATION_ADD, SDL_BLENDFACTOR_ONE,
+        SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    if (is_opaque) {
+        SDL_SetTextureBlendMode(layer->texture, SDL_BLENDMODE_NONE);
+    } else if (SDL_SetTextureBlendMode(layer->texture, premultiplied)) {
+        SDL_SetTextureBlendMode(layer->texture, SDL_BLENDMODE_BLEND);
+    }
+    return layer;
+}
+
+void video_layer_term(video_layer_t *layer) {
+    if (!layer) {
+        return;
+    }
+    SDL_DestroyTexture(layer->texture);
+    delete (layer);
+}
+
+void video_layer_invalidate(video_layer_t *layer) {
+    if (layer) {
+        layer->is_valid = false;
+    }
+}
+
+/**
+ * Start recording into the layer's texture, cleared, if it is out of date.
+ *
+ * Without a layer, contents are recorded straight to the screen, every time.
+ */
+bool video_layer_begin(video_t *v, video_layer_t *layer) {
+    if (!layer) {
+        return true;
+    }
+    if (layer->is_valid) {
+        return false;
+    }
+    SDL_Color const clear_color = {0, 0, 0, layer->is_opaque ? 255 : 0};
+
+    video_cmd_t *target = cmd_buffer_push(&v->cmd, VIDEO_CMD_TARGET, clear_color,
+                                          &layer->bounds, 0);
+    if (!target) {
+        return false;
+    }
+    target->texture = layer->texture;
+    if (!cmd_buffer_push(&v->cmd, VIDEO_CMD_CLEAR, clear_color, &layer->bounds, 0)) {
+        v->cmd.cmd_count--;
+        return false;
+    }
+
+    layer->is_valid = true;
+    v->recording    = layer;
+    v->stats.layer_redraws++;
+    return true;
+}
+
+void video_layer_end(video_t *v, video_layer_t *layer) {
+    if (!layer) {
+        return;
+    }
+    v->recording = NULL;
+    // Unable to switch back, the rest of the frame lands in the layer; redraw it.
+    if (!cmd_buffer_push(&v->cmd, VIDEO_CMD_TARGET, v->color, &layer->bounds, 0)) {
+        layer->is_valid = false;
+        return;
+    }
+    cmd_buffer_keep(&v->cmd);
+}
+
+/**
+ * Record a copy of the layer's texture over the whole window.
+ */
+void video_layer_draw(video_t *v, video_layer_t *layer) {
+    if (!layer || !layer->is_valid) {
+        return;
+    }
+    video_cmd_t *copy = cmd_buffer_push(&v->cmd, VIDEO_CMD_COPY, v->color,
+                                        &layer->bounds, 0);
+    if (copy) {
+        copy->texture = layer->texture;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Statistics
+// -----------------------------------------------------------------------------
+
+/**
+ * Does presenting wait for the display's refresh?
+ */
+bool video_is_vsync(video_t *v) { return v->is_vsync; }
+
+/**
+ * Get draw statistics accumulated since initialization.
+ */
+void video_get_stats(video_t *v, video_stats_t *stats) { *stats = v->stats; }
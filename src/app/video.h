@@ -1,10 +1,13 @@
 #pragma once
 
-#include "SDL_ttf.h"
+#include <stdbool.h>
+#include <stdint.h>
 
 #include "aabb.h"
 
 typedef struct video_s video_t;
+typedef struct video_text_s video_text_t;
+typedef struct video_layer_s video_layer_t;
 
 /**
  * Video System Configuration Parameters.
@@ -16,8 +19,25 @@ typedef struct {
   unsigned short window_width;
   unsigned short window_height;
   unsigned char window_is_fullscreen;
+  unsigned char is_headless; // No window or renderer; draw calls only count.
+  unsigned char is_vsync;    // Ask for presenting to wait for the display.
 } video_cfg_t;
 
+/**
+ * Draw statistics, accumulated since initialization.
+ *
+ * Draw calls are recorded and only submitted at `video_render`; `batches` counts
+ * the renderer submissions they were merged into.
+ */
+typedef struct {
+  unsigned long frames;        // Frames rendered.
+  unsigned long rects;         // Regions drawn.
+  unsigned long glyphs;        // Glyph quads drawn.
+  unsigned long batches;       // Renderer submissions (clears, fills, copies).
+  unsigned long state_changes; // Renderer draw color changes.
+  unsigned long layer_redraws; // Cached layers drawn into their textures.
+} video_stats_t;
+
 /**
  * Initialize video handle.
  *
@@ -34,11 +54,17 @@ void video_term(video_t *video);
 
 /**
  * Clear the screen.
+ *
+ * Drops what was drawn to the screen so far this frame, but not layers: those
+ * begun earlier in the frame must have ended before the clear.
  */
 void video_clear(video_t *video);
 
 /**
  * Display all drawn elements.
+ *
+ * Draw calls made since `video_clear` are submitted here, merged into as few
+ * renderer calls as their color and draw order allow.
  */
 void video_render(video_t *video);
 
@@ -58,8 +84,15 @@ void video_reset_color(video_t *video);
  */
 void video_draw_region(video_t *video, aabb_t *region);
 
+/**
+ * Draw an axis-aligned region with sub-pixel position and size.
+ */
+void video_draw_region_f(video_t *video, faabb_t *region);
+
 /**
  * Draw text with specified color.
+ *
+ * Laid out from scratch on every call; use `video_text_t` for persistent text.
  */
 void video_draw_text_with_color(video_t *v, char *str, int x, int y, uint8_t r,
                                 uint8_t g, uint8_t b, uint8_t a);
@@ -75,3 +108,97 @@ void video_draw_text(video_t *video, char *str, int x, int y);
  * Get window size.
  */
 void video_get_window_size(video_t *video, int *width, int *height);
+
+/**
+ * Create a retained text element.
+ *
+ * Retained text keeps its measured size and glyph layout between frames, and
+ * only rebuilds them when its string, color or position actually change.
+ *
+ * \param video Video handle providing the font.
+ * \param str Initial text content.
+ * \returns video_text_t handle.
+ * \sa video_text_term
+ */
+video_text_t *video_text_init(video_t *video, char const *str);
+
+/**
+ * Destroy a retained text element.
+ */
+void video_text_term(video_text_t *text);
+
+/**
+ * Set retained text content.
+ */
+void video_text_set_string(video_t *video, video_text_t *text, char const *str);
+
+/**
+ * Set retained text color.
+ */
+void video_text_set_color(video_text_t *text, uint8_t r, uint8_t g, uint8_t b,
+                          uint8_t a);
+
+/**
+ * Draw retained text centered on (`x`, `y`).
+ */
+void video_text_draw(video_t *video, video_text_t *text, int x, int y);
+
+/**
+ * Get measured size of retained text.
+ */
+void video_text_get_size(video_text_t *text, int *width, int *height);
+
+/**
+ * Create a cached layer the size of the window.
+ *
+ * A layer is drawn once into a texture of its own, then copied to the screen
+ * in a single call every frame, until invalidated. Opaque layers start from
+ * black and are copied without blending, so drawing them costs the same
+ * whatever was blended into them; others start transparent and are blended.
+ *
+ * \returns NULL if headless, or if the renderer cannot draw into textures; a
+ * NULL layer is simply drawn straight to the screen every frame.
+ * \sa video_layer_term
+ */
+video_layer_t *video_layer_init(video_t *video, bool is_opaque);
+
+void video_layer_term(video_layer_t *layer);
+
+/**
+ * Mark a layer's contents out of date, so the next `video_layer_begin` has them
+ * drawn again.
+ */
+void video_layer_invalidate(video_layer_t *layer);
+
+/**
+ * Start drawing into `layer`, if its contents are out of date.
+ *
+ * Call between `video_clear` and `video_render`. While it returns `true`, draw
+ * the layer's contents, then call `video_layer_end`.
+ *
+ * \returns `false` if the layer is up to date, and nothing need be drawn, or if
+ * out of memory, in which case it is left out of this frame.
+ */
+bool video_layer_begin(video_t *video, video_layer_t *layer);
+
+/**
+ * Finish drawing into `layer`; later draw calls go to the screen again.
+ */
+void video_layer_end(video_t *video, video_layer_t *layer);
+
+/**
+ * Copy `layer` to the screen, over whatever has been drawn so far.
+ */
+void video_layer_draw(video_t *video, video_layer_t *layer);
+
+/**
+ * Does presenting wait for the display's refresh?
+ *
+ * Asking for VSync is only a request; drivers may refuse it.
+ */
+bool video_is_vsync(video_t *video);
+
+/**
+ * Get draw statistics.
+ */
+void video_get_stats(video_t *video, video_stats_t *stats);
@@ -0,0 +1,98 @@
+/**
+ * AABB Benchmark.
+ *
+ * Single pair tests (`aabb_get_intersection`, `aabb_get_mutual_intersection`),
+ * then one box against many and many boxes against a field for each batch
+ * kernel the CPU supports. One op is one box tested.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "aabb.h"
+#include "bench/bench.h"
+
+#define BOX_COUNT 4096
+
+static int xs[BOX_COUNT], ys[BOX_COUNT], ws[BOX_COUNT], hs[BOX_COUNT];
+static aabb_t boxes[BOX_COUNT];
+static aabb_edge_t edges[BOX_COUNT];
+
+static aabb_columns_t columns = {xs, ys, ws, hs};
+static aabb_t subject         = {320, 240, 64, 64};
+static aabb_t field           = {0, 0, 640, 480};
+
+/** Sum of edges; kept global so the work cannot be optimised away. */
+static volatile unsigned long checksum = 0;
+
+static void boxes_init(void) {
+    srand(BOX_COUNT);
+    for (int index = 0; index < BOX_COUNT; index++) {
+        xs[index]    = rand() % 640 - 8;
+        ys[index]    = rand() % 480 - 8;
+        ws[index]    = 8 + rand() % 16;
+        hs[index]    = 8 + rand() % 16;
+        boxes[index] = (aabb_t){xs[index], ys[index], ws[index], hs[index]};
+    }
+}
+
+// --- Cases
+
+static void run_intersection(void *context) {
+    (void)context;
+    unsigned long sum = 0;
+    for (int index = 0; index < BOX_COUNT; index++) {
+        sum += aabb_get_intersection(&subject, &boxes[index]);
+    }
+    checksum += sum;
+}
+
+static void run_mutual_intersection(void *context) {
+    (void)context;
+    unsigned long sum = 0;
+    for (int index = 0; index < BOX_COUNT; index++) {
+        aabb_edge_t a_edge, b_edge;
+        sum += aabb_get_mutual_intersection(&subject, &boxes[index], &a_edge, &b_edge);
+    }
+    checksum += sum;
+}
+
+static void run_intersections(void *context) {
+    (void)context;
+    aabb_get_intersections(&subject, &columns, BOX_COUNT, edges);
+    checksum += edges[BOX_COUNT / 2];
+}
+
+static void run_beyond_edges(void *context) {
+    (void)context;
+    aabb_get_beyond_edges(&field, &columns, BOX_COUNT, edges);
+    checksum += edges[BOX_COUNT / 2];
+}
+
+int main(int argc, char *argv[]) {
+    bench_t *bench = bench_init("aabb", argc, argv);
+    if (!bench) {
+        return EXIT_FAILURE;
+    }
+
+    boxes_init();
+
+    bench_run(bench, "aabb/intersection", run_intersection, NULL, BOX_COUNT);
+    bench_run(bench, "aabb/mutual_intersection", run_mutual_intersection, NULL,
+              BOX_COUNT);
+
+    for (aabb_kernel_t kernel = AABB_KERNEL_SCALAR; kernel < AABB_KERNEL_COUNT;
+         kernel++) {
+        if (!aabb_kernel_select(kernel)) {
+            continue;
+        }
+
+        char name[64];
+        snprintf(name, sizeof name, "aabb/%s/intersections", aabb_kernel_name(kernel));
+        bench_run(bench, name, run_intersections, NULL, BOX_COUNT);
+        snprintf(name, sizeof name, "aabb/%s/beyond_edges", aabb_kernel_name(kernel));
+        bench_run(bench, name, run_beyond_edges, NULL, BOX_COUNT);
+    }
+
+    return bench_term(bench);
+}
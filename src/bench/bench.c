@@ -0,0 +1,303 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "alloc.h"
+#include "bench.h"
+
+#define DEFAULT_SAMPLE_COUNT 50
+#define MIN_SAMPLE_COUNT     5
+#define SAMPLE_NS            1000000.0    // Target length of one sample.
+#define CASE_BUDGET_NS       2000000000.0 // Per case; long cases take fewer samples.
+#define NAME_MAX_LENGTH      64
+
+typedef struct {
+    char name[NAME_MAX_LENGTH];
+    double p50;
+} bench_baseline_t;
+
+typedef struct {
+    char name[NAME_MAX_LENGTH];
+    size_t samples;
+    double ns_per_op; // Mean over every sample.
+    double ops_per_sec;
+    double min;
+    double p50;
+    double p90;
+    double p99;
+    double baseline_p50; // 0 without a baseline entry.
+} bench_result_t;
+
+struct bench_s {
+    char const *suite;
+    char const *json_path;
+    double max_regression; // Percent; negative to never fail.
+    size_t sample_count;
+    double *sample_ns_per_op;
+
+    bench_result_t *results;
+    size_t result_count;
+    size_t result_capacity;
+
+    bench_baseline_t *baseline;
+    size_t baseline_count;
+};
+
+// -----------------------------------------------------------------------------
+// Helpers
+// -----------------------------------------------------------------------------
+
+static double now_ns(void) {
+    return SDL_GetPerformanceCounter() * 1000000000.0 / SDL_GetPerformanceFrequency();
+}
+
+static double time_calls(bench_fn_t fn, void *context, size_t calls) {
+    double start = now_ns();
+    for (size_t call = 0; call < calls; call++) {
+        fn(context);
+    }
+    return now_ns() - start;
+}
+
+static int compare_doubles(void const *a, void const *b) {
+    double x = *(double const *)a, y = *(double const *)b;
+    return (x > y) - (x < y);
+}
+
+/** Nearest-rank percentile of sorted `values`. */
+static double percentile(double const *values, size_t count, double percent) {
+    size_t rank = (size_t)(percent / 100.0 * count + 0.5);
+    return values[rank ? (rank < count ? rank : count) - 1 : 0];
+}
+
+/**
+ * Load results written by an earlier run; bench_term writes one per line.
+ */
+static bool load_baseline(bench_t *bench, char const *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return false;
+    }
+
+    char line[512];
+    size_t capacity = 0;
+    while (fgets(line, sizeof line, file)) {
+        char *name = strstr(line, "\"name\":\"");
+        char *p50  = strstr(line, "\"p50\":");
+        if (!name || !p50) {
+            continue;
+        }
+
+        if (bench->baseline_count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            bench_baseline_t *grown =
+                realloc(bench->baseline, capacity * sizeof(bench_baseline_t));
+            if (!grown) {
+                break;
+            }
+            bench->baseline = grown;
+        }
+
+        bench_baseline_t *entry = &bench->baseline[bench->baseline_count++];
+        name += strlen("\"name\":\"");
+        size_t length = strcspn(name, "\"");
+        length        = length < NAME_MAX_LENGTH - 1 ? length : NAME_MAX_LENGTH - 1;
+        memcpy(entry->name, name, length);
+        entry->name[length] = '\0';
+        entry->p50          = strtod(p50 + strlen("\"p50\":"), NULL);
+    }
+
+    fclose(file);
+    return true;
+}
+
+static double find_baseline(bench_t *bench, char const *name) {
+    for (size_t index = 0; index < bench->baseline_count; index++) {
+        if (!strcmp(bench->baseline[index].name, name)) {
+            return bench->baseline[index].p50;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Compare medians: one preempted sample moves the mean far more than the p50.
+ */
+static double get_change_percent(bench_result_t *result) {
+    return (result->p50 / result->baseline_p50 - 1.0) * 100.0;
+}
+
+static bool write_json(bench_t *bench) {
+    FILE *file = fopen(bench->json_path, "w");
+    if (!file) {
+        return false;
+    }
+
+    fprintf(file, "{\"suite\":\"%s\",\"results\":[", bench->suite);
+    for (size_t index = 0; index < bench->result_count; index++) {
+        bench_result_t *result = &bench->results[index];
+        fprintf(file,
+                "%s\n{\"name\":\"%s\",\"samples\":%zu,\"ns_per_op\":%.3f,"
+                "\"ops_per_sec\":%.1f,\"min\":%.3f,\"p50\":%.3f,\"p90\":%.3f,"
+                "\"p99\":%.3f}",
+                index ? "," : "", result->name, result->samples, result->ns_per_op,
+                result->ops_per_sec, result->min, result->p50, result->p90,
+                result->p99);
+    }
+    fputs("\n]}\n", file);
+
+    return fclose(file) == 0;
+}
+
+// -----------------------------------------------------------------------------
+// Suite
+// -----------------------------------------------------------------------------
+
+static void print_usage(char const *program) {
+    fprintf(stderr,
+            "usage: %s [--json PATH] [--baseline PATH] [--max-regression PCT] "
+            "[--samples N]\n",
+            program);
+}
+
+bench_t *bench_init(char const *suite, int argc, char *argv[]) {
+    bench_t *bench = new_clean(1, bench_t);
+    if (!bench) {
+        return NULL;
+    }
+
+    bench->suite          = suite;
+    bench->max_regression = -1;
+    bench->sample_count   = DEFAULT_SAMPLE_COUNT;
+
+    for (int index = 1; index < argc; index++) {
+        bool has_value = index + 1 < argc;
+        if (!strcmp(argv[index], "--json") && has_value) {
+            bench->json_path = argv[++index];
+        } else if (!strcmp(argv[index], "--baseline") && has_value) {
+            // A missing baseline is fine: the first run has nothing to compare.
+            if (!load_baseline(bench, argv[++index])) {
+                fprintf(stderr, "%s: no baseline at %s\n", suite, argv[index]);
+            }
+        } else if (!strcmp(argv[index], "--max-regression") && has_value) {
+            bench->max_regression = strtod(argv[++index], NULL);
+        } else if (!strcmp(argv[index], "--samples") && has_value) {
+            bench->sample_count = strtoul(argv[++index], NULL, 10);
+        } else {
+            print_usage(argv[0]);
+            bench_term(bench);
+            return NULL;
+        }
+    }
+
+    if (bench->sample_count < MIN_SAMPLE_COUNT) {
+        bench->sample_count = MIN_SAMPLE_COUNT;
+    }
+    if (!(bench->sample_ns_per_op = new_array(bench->sample_count, double))) {
+        bench_term(bench);
+        return NULL;
+    }
+
+    return bench;
+}
+
+int bench_term(bench_t *bench) {
+    if (!bench) {
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+
+    if (bench->json_path && !write_json(bench)) {
+        fprintf(stderr, "%s: cannot write %s\n", bench->suite, bench->json_path);
+        status = EXIT_FAILURE;
+    }
+
+    for (size_t index = 0; index < bench->result_count; index++) {
+        bench_result_t *result = &bench->results[index];
+        if (bench->max_regression >= 0 && result->baseline_p50 &&
+            get_change_percent(result) > bench->max_regression) {
+            fprintf(stderr, "%s: %.1f%% slower than baseline\n", result->name,
+                    get_change_percent(result));
+            status = EXIT_FAILURE;
+        }
+    }
+
+    delete (bench->sample_ns_per_op);
+    delete (bench->results);
+    delete (bench->baseline);
+    delete (bench);
+    return status;
+}
+
+// -----------------------------------------------------------------------------
+// Cases
+// -----------------------------------------------------------------------------
+
+void bench_run(bench_t *bench, char const *name, bench_fn_t fn, void *context,
+               double ops) {
+    if (bench->result_count == bench->result_capacity) {
+        size_t capacity = bench->result_capacity ? bench->result_capacity * 2 : 16;
+        bench_result_t *grown =
+            realloc(bench->results, capacity * sizeof(bench_result_t));
+        if (!grown) {
+            fprintf(stderr, "%s: out of memory\n", name);
+            return;
+        }
+        bench->results         = grown;
+        bench->result_capacity = capacity;
+    }
+
+    // --- Calibrate: warm up, then size samples to about SAMPLE_NS each.
+    size_t calls   = 1;
+    double elapsed = time_calls(fn, context, calls);
+    while (elapsed < SAMPLE_NS / 10) {
+        calls *= 2;
+        elapsed = time_calls(fn, context, calls);
+    }
+    if (elapsed < SAMPLE_NS) {
+        calls = (size_t)(calls * SAMPLE_NS / elapsed);
+    }
+
+    size_t samples = bench->sample_count;
+    if (samples * elapsed > CASE_BUDGET_NS) {
+        samples = (size_t)(CASE_BUDGET_NS / elapsed);
+        samples = samples < MIN_SAMPLE_COUNT ? MIN_SAMPLE_COUNT : samples;
+    }
+
+    // --- Measure
+    double total_ns = 0;
+    for (size_t sample = 0; sample < samples; sample++) {
+        double sample_ns = time_calls(fn, context, calls);
+        total_ns += sample_ns;
+        bench->sample_ns_per_op[sample] = sample_ns / (calls * ops);
+    }
+    qsort(bench->sample_ns_per_op, samples, sizeof(double), compare_doubles);
+
+    // --- Report
+    bench_result_t *result = &bench->results[bench->result_count++];
+    snprintf(result->name, sizeof result->name, "%s", name);
+    result->samples            = samples;
+    result->ns_per_op          = total_ns / (samples * calls * ops);
+    result->ops_per_sec        = 1000000000.0 / result->ns_per_op;
+    result->min                = bench->sample_ns_per_op[0];
+    result->p50                = percentile(bench->sample_ns_per_op, samples, 50);
+    result->p90                = percentile(bench->sample_ns_per_op, samples, 90);
+    result->p99                = percentile(bench->sample_ns_per_op, samples, 99);
+    result->baseline_p50       = find_baseline(bench, result->name);
+
+    printf("%-32s %12.2f ns/op %14.0f ops/s  p50 %.2f  p90 %.2f  p99 %.2f",
+           result->name, result->ns_per_op, result->ops_per_sec, result->p50,
+           result->p90, result->p99);
+    if (result->baseline_p50) {
+        printf("  (p50 %+.1f%% vs baseline)", get_change_percent(result));
+    }
+    putchar('\n');
+}
+
+double bench_get_last_ns_per_op(bench_t *bench) {
+    return bench->result_count ? bench->results[bench->result_count - 1].ns_per_op : 0;
+}
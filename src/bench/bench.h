@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stddef.h>
+
+/**
+ * Shared benchmark harness.
+ *
+ * Each case is timed over a number of samples, each sample a batch of calls
+ * sized to run for about a millisecond. Results are printed as ns/op, ops/sec
+ * and sample percentiles, optionally written as JSON, and optionally compared
+ * against a baseline written by an earlier run.
+ *
+ * Options (after the program name):
+ *
+ *   --json PATH            Write results to PATH.
+ *   --baseline PATH        Compare against results previously written to PATH.
+ *   --max-regression PCT   Fail if any case's p50 got more than PCT percent slower.
+ *   --samples N            Samples per case (default 50).
+ */
+typedef struct bench_s bench_t;
+
+/**
+ * One benchmarked call, performing `ops` operations of the case (see bench_run).
+ */
+typedef void (*bench_fn_t)(void *context);
+
+/**
+ * Initialize a benchmark suite from the command line.
+ *
+ * \returns NULL on a usage error, after printing usage.
+ */
+bench_t *bench_init(char const *suite, int argc, char *argv[]);
+
+/**
+ * Finish the suite: write JSON and report the baseline comparison.
+ *
+ * \returns process exit status; failure if output cannot be written or a case
+ *          regressed past `--max-regression`.
+ */
+int bench_term(bench_t *bench);
+
+/**
+ * Time `fn`, where each call performs `ops` operations, and report it as `name`.
+ */
+void bench_run(bench_t *bench, char const *name, bench_fn_t fn, void *context,
+               double ops);
+
+/**
+ * Get the mean ns/op of the last case run, for derived ratios.
+ */
+double bench_get_last_ns_per_op(bench_t *bench);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+/**
+ * Signed Q16.16 fixed-point number.
+ *
+ * Integer arithmetic rounds the same everywhere, so anything simulated in fixed
+ * point replays bit-for-bit regardless of compiler, flags or thread count.
+ */
+typedef int32_t fixed_t;
+
+#define FIXED_SHIFT 16
+#define FIXED_ONE   ((fixed_t)1 << FIXED_SHIFT)
+
+static inline fixed_t fixed_from_int(int value) { return value * FIXED_ONE; }
+
+/**
+ * Round towards negative infinity, so positions floor onto the pixel grid.
+ */
+static inline int fixed_to_int(fixed_t value) { return value >> FIXED_SHIFT; }
+
+static inline fixed_t fixed_from_float(float value) {
+    return (fixed_t)lroundf(value * FIXED_ONE);
+}
+
+static inline float fixed_to_float(fixed_t value) { return (float)value / FIXED_ONE; }
+
+static inline fixed_t fixed_mul(fixed_t a, fixed_t b) {
+    return (fixed_t)(((int64_t)a * b) >> FIXED_SHIFT);
+}
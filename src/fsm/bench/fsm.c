@@ -0,0 +1,123 @@
+/**
+ * FSM Benchmark.
+ *
+ * Triggers and activities on a small ring of states, the shape of the game's
+ * own state machine. One op is one `fsm_trigger` or `fsm_do_activity` call.
+ * The `instances` cases step many instances of one shared definition, as
+ * concurrent matches would.
+ */
+
+#include <stdlib.h>
+
+#include "bench/bench.h"
+#include "fsm/fsm.h"
+
+#define CALLS_PER_RUN  1024
+#define INSTANCE_COUNT 100000
+
+typedef enum {
+    GUARD_STATE,
+    A_STATE,
+    B_STATE,
+    C_STATE,
+    D_STATE,
+    STATE_COUNT,
+} bench_state_t;
+
+typedef enum {
+    NEXT_TRIGGER,
+    IGNORED_TRIGGER, // No transitions; exercises the rejected path.
+    TRIGGER_COUNT,
+} bench_trigger_t;
+
+static volatile unsigned long activity_count = 0;
+
+static void count_activity(fsm_def_t const *def, fsm_t *fsm) {
+    (void)def;
+    (void)fsm;
+    activity_count++;
+}
+
+static void advance_activity(fsm_def_t const *def, fsm_t *fsm) {
+    activity_count++;
+    fsm_trigger(def, fsm, NEXT_TRIGGER);
+}
+
+/** One definition, and the instances stepped through it. */
+typedef struct {
+    fsm_def_t *def;
+    fsm_t *fsms;
+    size_t count;
+} ring_t;
+
+// --- Cases
+
+static void run_trigger(void *context) {
+    ring_t *ring = context;
+    for (int call = 0; call < CALLS_PER_RUN; call++) {
+        fsm_trigger(ring->def, ring->fsms, NEXT_TRIGGER);
+    }
+}
+
+static void run_rejected_trigger(void *context) {
+    ring_t *ring = context;
+    for (int call = 0; call < CALLS_PER_RUN; call++) {
+        fsm_trigger(ring->def, ring->fsms, IGNORED_TRIGGER);
+    }
+}
+
+static void run_do_activity(void *context) {
+    ring_t *ring = context;
+    for (int call = 0; call < CALLS_PER_RUN; call++) {
+        fsm_do_activity(ring->def, ring->fsms);
+    }
+}
+
+static void run_do_activities(void *context) {
+    ring_t *ring = context;
+    fsm_do_activities(ring->def, ring->fsms, ring->count);
+}
+
+static ring_t ring_init(fsm_activity_t activity, size_t count) {
+    ring_t ring = {fsm_def_init(STATE_COUNT, TRIGGER_COUNT, A_STATE),
+                   malloc(count * sizeof(fsm_t)), count};
+    for (int state = A_STATE; state < STATE_COUNT; state++) {
+        int next = state + 1 < STATE_COUNT ? state + 1 : A_STATE;
+        fsm_on(ring.def, state, NEXT_TRIGGER, next);
+        fsm_set_activity(ring.def, state, activity);
+    }
+    for (size_t index = 0; index < count; index++) {
+        fsm_init(ring.fsms + index, ring.def, NULL);
+    }
+    return ring;
+}
+
+static void ring_term(ring_t *ring) {
+    free(ring->fsms);
+    fsm_def_term(ring->def);
+}
+
+int main(int argc, char *argv[]) {
+    bench_t *bench = bench_init("fsm", argc, argv);
+    if (!bench) {
+        return EXIT_FAILURE;
+    }
+
+    ring_t ring = ring_init(count_activity, 1);
+    bench_run(bench, "fsm/trigger", run_trigger, &ring, CALLS_PER_RUN);
+    bench_run(bench, "fsm/trigger_rejected", run_rejected_trigger, &ring,
+              CALLS_PER_RUN);
+    bench_run(bench, "fsm/do_activity", run_do_activity, &ring, CALLS_PER_RUN);
+    ring_term(&ring);
+
+    ring = ring_init(advance_activity, 1);
+    bench_run(bench, "fsm/do_activity_transition", run_do_activity, &ring,
+              CALLS_PER_RUN);
+    ring_term(&ring);
+
+    ring = ring_init(advance_activity, INSTANCE_COUNT);
+    bench_run(bench, "fsm/instances_100k", run_do_activities, &ring, INSTANCE_COUNT);
+    ring_term(&ring);
+
+    return bench_term(bench);
+}
@@ -1,33 +1,49 @@
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "fsm.h"
 
+#define FSM_QUEUE_CAPACITY 16
+
 typedef struct fsm_state_s {
     fsm_activity_t activity;
-    void *context;
+    fsm_activity_t enter;
+    fsm_activity_t exit;
 } fsm_state_data_t;
 
-typedef struct fsm_s {
-    int current_state;
+typedef struct fsm_def_s {
+    int start_state;
     int state_count;
     int trigger_count;
     int *transitions;
     fsm_state_data_t *states;
-} fsm_t;
+} fsm_def_t;
+
+/**
+ * One run to completion. Lives on the stack of the outermost fsm_trigger or
+ * fsm_do_activity, so instances only carry a pointer to it.
+ */
+typedef struct fsm_run_s {
+    int queue[FSM_QUEUE_CAPACITY]; // Ring of pending triggers.
+    int queue_head;
+    int queue_count;
+    uint64_t entered;  // States entered so far, one bit each.
+    fsm_error_t error; // First problem of this run.
+} fsm_run_t;
 
 // -----------------------------------------------------------------------------
 // Initialization
 // -----------------------------------------------------------------------------
 
-static fsm_t *_root_fsm_init(size_t state_count, size_t trigger_count,
-                             int start_state) {
-    fsm_t *fsm         = malloc(sizeof(fsm_t));
-    fsm->state_count   = state_count;
-    fsm->trigger_count = trigger_count;
-    fsm->current_state = start_state;
-    return fsm;
+static fsm_def_t *_root_def_init(size_t state_count, size_t trigger_count,
+                                 int start_state) {
+    fsm_def_t *def     = malloc(sizeof(fsm_def_t));
+    def->state_count   = state_count;
+    def->trigger_count = trigger_count;
+    def->start_state   = start_state;
+    return def;
 }
 
 static int *_transition_table_init(size_t state_count, size_t trigger_count) {
@@ -36,15 +52,24 @@ static int *_transition_table_init(size_t state_count, size_t trigger_count) {
 }
 
 static fsm_state_data_t *_states_init(size_t state_count) {
-    fsm_state_data_t *states = malloc(sizeof(fsm_state_data_t) * state_count);
+    fsm_state_data_t *states = calloc(state_count, sizeof(fsm_state_data_t));
     return states;
 }
 
-fsm_t *fsm_init(size_t state_count, size_t trigger_count, int start_state) {
-    fsm_t *fsm       = _root_fsm_init(state_count, trigger_count, start_state);
-    fsm->transitions = _transition_table_init(state_count, trigger_count);
-    fsm->states      = _states_init(state_count);
-    return fsm;
+fsm_def_t *fsm_def_init(size_t state_count, size_t trigger_count, int start_state) {
+    if (state_count > FSM_STATE_MAX) {
+        return NULL;
+    }
+    fsm_def_t *def   = _root_def_init(state_count, trigger_count, start_state);
+    def->transitions = _transition_table_init(state_count, trigger_count);
+    def->states      = _states_init(state_count);
+    return def;
+}
+
+void fsm_init(fsm_t *fsm, fsm_def_t const *def, void *context) {
+    fsm->context = context;
+    fsm->run     = NULL;
+    fsm->state   = def->start_state;
 }
 
 // -----------------------------------------------------------------------------
@@ -55,57 +80,161 @@ static void _states_term(fsm_state_data_t *states) { free(states); }
 
 static void _transition_table_term(int *transitions) { free(transitions); }
 
-static void _root_fsm_term(fsm_t *fsm) { free(fsm); }
+static void _root_def_term(fsm_def_t *def) { free(def); }
 
-void fsm_term(fsm_t *fsm) {
-    if (!fsm) {
+void fsm_def_term(fsm_def_t *def) {
+    if (!def) {
         return;
     }
-    _states_term(fsm->states);
-    _transition_table_term(fsm->transitions);
-    _root_fsm_term(fsm);
+    _states_term(def->states);
+    _transition_table_term(def->transitions);
+    _root_def_term(def);
 }
 
 // -----------------------------------------------------------------------------
 // Transitions
 // -----------------------------------------------------------------------------
 
-void fsm_on(fsm_t *fsm, int from, int trigger, int to) {
-    *(fsm->transitions + (from * fsm->trigger_count) + trigger) = to;
+void fsm_on(fsm_def_t *def, int from, int trigger, int to) {
+    *(def->transitions + (from * def->trigger_count) + trigger) = to;
 }
 
 // -----------------------------------------------------------------------------
 // Activities
 // -----------------------------------------------------------------------------
 
-void fsm_set_activity(fsm_t *fsm, int state, fsm_activity_t activity, void *context) {
-    fsm_state_data_t *state_data = (fsm->states + state);
-    state_data->activity         = activity;
-    state_data->context          = context;
+void fsm_set_activity(fsm_def_t *def, int state, fsm_activity_t activity) {
+    def->states[state].activity = activity;
 }
 
-void fsm_do_activity(fsm_t *fsm) {
-    fsm_activity_t activity = *(fsm->states + fsm->current_state)->activity;
-    if (!activity)
-        return;
-    void *context = (fsm->states + fsm->current_state)->context;
-    activity(fsm, context);
+void fsm_set_enter_action(fsm_def_t *def, int state, fsm_activity_t action) {
+    def->states[state].enter = action;
+}
+
+void fsm_set_exit_action(fsm_def_t *def, int state, fsm_activity_t action) {
+    def->states[state].exit = action;
+}
+
+// -----------------------------------------------------------------------------
+// Run-to-completion
+// -----------------------------------------------------------------------------
+
+static void _run_init(fsm_run_t *run) {
+    // The queue itself is only read behind `queue_count`.
+    run->queue_head  = 0;
+    run->queue_count = 0;
+    run->entered     = 0;
+    run->error       = FSM_OK;
+}
+
+static void _fail(fsm_run_t *run, fsm_error_t error) {
+    if (run->error == FSM_OK) {
+        run->error = error;
+    }
+}
+
+static bool _queue_push(fsm_run_t *run, int trigger) {
+    if (run->queue_count == FSM_QUEUE_CAPACITY) {
+        return false;
+    }
+    run->queue[(run->queue_head + run->queue_count++) % FSM_QUEUE_CAPACITY] = trigger;
+    return true;
+}
+
+static int _queue_pop(fsm_run_t *run) {
+    int trigger     = run->queue[run->queue_head];
+    run->queue_head = (run->queue_head + 1) % FSM_QUEUE_CAPACITY;
+    run->queue_count--;
+    return trigger;
+}
+
+/**
+ * Handle queued triggers one transition at a time until none are left.
+ *
+ * Must be entered with `fsm->run` set to `run`; clears it.
+ */
+static fsm_error_t _run_to_completion(fsm_def_t const *def, fsm_t *fsm,
+                                      fsm_run_t *run) {
+    while (run->queue_count) {
+        int trigger    = _queue_pop(run);
+        int next_state =
+            *(def->transitions + (fsm->state * def->trigger_count) + trigger);
+        if (!next_state) {
+            continue;
+        }
+
+        uint64_t next_bit = (uint64_t)1 << next_state;
+        if (run->entered & next_bit) {
+            _fail(run, FSM_CYCLE);
+            break;
+        }
+        run->entered |= next_bit;
+
+        fsm_activity_t exit = def->states[fsm->state].exit;
+        if (exit) {
+            exit(def, fsm);
+        }
+        fsm->state = next_state;
+        fsm_activity_t enter = def->states[next_state].enter;
+        if (enter) {
+            enter(def, fsm);
+        }
+    }
+
+    fsm->run = NULL;
+    return run->error;
+}
+
+fsm_error_t fsm_do_activity(fsm_def_t const *def, fsm_t *fsm) {
+    assert(!fsm->run && "fsm_do_activity called from an action");
+
+    fsm_activity_t activity = def->states[fsm->state].activity;
+    if (!activity) {
+        return FSM_OK;
+    }
+
+    fsm_run_t run;
+    _run_init(&run);
+    fsm->run = &run;
+    activity(def, fsm);
+    return _run_to_completion(def, fsm, &run);
+}
+
+fsm_error_t fsm_do_activities(fsm_def_t const *def, fsm_t *fsms, size_t count) {
+    fsm_error_t error = FSM_OK;
+    for (size_t index = 0; index < count; index++) {
+        fsm_error_t result = fsm_do_activity(def, fsms + index);
+        if (error == FSM_OK) {
+            error = result;
+        }
+    }
+    return error;
 }
 
 // -----------------------------------------------------------------------------
 // Trigger
 // -----------------------------------------------------------------------------
 
-void fsm_trigger(fsm_t *fsm, int trigger) {
-    int next_state =
-        *(fsm->transitions + (fsm->current_state * fsm->trigger_count) + trigger);
-    if (next_state) {
-        fsm->current_state = next_state;
-    };
+fsm_error_t fsm_trigger(fsm_def_t const *def, fsm_t *fsm, int trigger) {
+    if (fsm->run) {
+        if (!_queue_push(fsm->run, trigger)) {
+            _fail(fsm->run, FSM_QUEUE_FULL);
+            return FSM_QUEUE_FULL;
+        }
+        return FSM_OK;
+    }
+
+    fsm_run_t run;
+    _run_init(&run);
+    fsm->run = &run;
+    _queue_push(&run, trigger);
+    return _run_to_completion(def, fsm, &run);
 }
 
 // -----------------------------------------------------------------------------
 // Queries
 // -----------------------------------------------------------------------------
 
-int fsm_state(fsm_t *fsm) { return fsm->current_state; }
+int fsm_state(fsm_t const *fsm) { return fsm->state; }
+
+void fsm_restore(fsm_t *fsm, int state) { fsm->state = state; }
@@ -3,15 +3,107 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+/**
+ * State machines are split in two: a definition (transitions and actions),
+ * built once and then only read, and any number of small instances that each
+ * hold a current state and a context. Instances are plain values; keep as many
+ * as needed in an array, all sharing one definition.
+ */
+typedef struct fsm_def_s fsm_def_t;
 typedef struct fsm_s fsm_t;
-typedef void (*fsm_activity_t)(fsm_t *fsm, void *context);
 
-fsm_t *fsm_init(size_t state_count, size_t trigger_count, int start_state);
-void fsm_term(fsm_t *fsm);
+/**
+ * Activities and actions get the definition, to fire triggers with, and the
+ * instance, whose `context` was given to `fsm_init`.
+ */
+typedef void (*fsm_activity_t)(fsm_def_t const *def, fsm_t *fsm);
 
-void fsm_on(fsm_t *fsm, int from, int trigger, int to);
-void fsm_set_activity(fsm_t *fsm, int state, fsm_activity_t activity,
-                      void *context);
-void fsm_do_activity(fsm_t *fsm);
-void fsm_trigger(fsm_t *fsm, int trigger);
-int fsm_state(fsm_t *fsm);
+/**
+ * Problems found while running triggers to completion.
+ */
+typedef enum {
+  FSM_OK,
+  FSM_QUEUE_FULL, // A trigger was dropped.
+  FSM_CYCLE,      // A chain re-entered a state; the rest of it was dropped.
+} fsm_error_t;
+
+/** Most states a definition can have. */
+#define FSM_STATE_MAX 64
+
+/**
+ * A state machine instance.
+ */
+struct fsm_s {
+  void *context;
+  struct fsm_run_s *run; // Set while dispatching; see fsm_trigger.
+  int state;
+};
+
+// -----------------------------------------------------------------------------
+// Definitions
+// -----------------------------------------------------------------------------
+
+/**
+ * Initialize a definition with no transitions or actions.
+ *
+ * \returns NULL if there are more than FSM_STATE_MAX states.
+ */
+fsm_def_t *fsm_def_init(size_t state_count, size_t trigger_count, int start_state);
+void fsm_def_term(fsm_def_t *def);
+
+void fsm_on(fsm_def_t *def, int from, int trigger, int to);
+void fsm_set_activity(fsm_def_t *def, int state, fsm_activity_t activity);
+
+/**
+ * Run `action` whenever `state` is entered.
+ *
+ * Entry actions may fire triggers; transient states (do one thing, move on) are
+ * just states with an entry action that fires the next trigger. The start
+ * state is never entered, only started in.
+ */
+void fsm_set_enter_action(fsm_def_t *def, int state, fsm_activity_t action);
+
+/**
+ * Run `action` whenever `state` is left.
+ */
+void fsm_set_exit_action(fsm_def_t *def, int state, fsm_activity_t action);
+
+// -----------------------------------------------------------------------------
+// Instances
+// -----------------------------------------------------------------------------
+
+/**
+ * Initialize an instance of `def` in its start state. Instances own nothing,
+ * so there is no matching term.
+ */
+void fsm_init(fsm_t *fsm, fsm_def_t const *def, void *context);
+
+/**
+ * Run the current state's activity, then any transitions it triggered.
+ */
+fsm_error_t fsm_do_activity(fsm_def_t const *def, fsm_t *fsm);
+
+/**
+ * Run the activity of each of `count` instances of `def`, in order.
+ *
+ * \returns the first error any instance reported.
+ */
+fsm_error_t fsm_do_activities(fsm_def_t const *def, fsm_t *fsms, size_t count);
+
+/**
+ * Fire `trigger`, run to completion.
+ *
+ * Triggers fired from inside an activity or action are queued (up to a small
+ * bound) and handled one at a time once it returns, so every action runs to
+ * completion before the next transition starts. A chain of immediate
+ * transitions therefore resolves within this one call, unless it enters a
+ * state twice; that cycle is cut off and reported.
+ */
+fsm_error_t fsm_trigger(fsm_def_t const *def, fsm_t *fsm, int trigger);
+int fsm_state(fsm_t const *fsm);
+
+/**
+ * Put an instance straight back into a `state` it was in before, running no
+ * actions; for rewinding whatever the instance drives to a saved point.
+ */
+void fsm_restore(fsm_t *fsm, int state);
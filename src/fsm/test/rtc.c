@@ -0,0 +1,110 @@
+/**
+ * FSM Run-to-Completion Test.
+ *
+ * A chain of transient states resolves within one trigger, with exit and enter
+ * actions in order; a chain that loops back is cut off and reported, and a
+ * flood of triggers from one action overflows the queue. Instances sharing a
+ * definition keep their own state.
+ */
+
+#include <string.h>
+
+#include "fsm/fsm.h"
+
+#include "test.h"
+
+#define TEST_NAME "rtc"
+#include "test/expect.h"
+
+// --- Action log, one letter per action: "e1" enters ONE, "x1" exits it
+
+static char trace[64];
+
+static void log_action(char kind, int state) {
+    size_t length = strlen(trace);
+    if (length + 2 < sizeof(trace)) {
+        trace[length]     = kind;
+        trace[length + 1] = (char)('0' + state);
+    }
+}
+
+static void exit_action(fsm_def_t const *def, fsm_t *fsm) {
+    (void)def;
+    log_action('x', fsm_state(fsm));
+}
+
+static void enter_and_next(fsm_def_t const *def, fsm_t *fsm) {
+    log_action('e', fsm_state(fsm));
+    fsm_trigger(def, fsm, NEXT);
+}
+
+static void enter_and_flood(fsm_def_t const *def, fsm_t *fsm) {
+    log_action('e', fsm_state(fsm));
+    for (int index = 0; index < 64; index++) {
+        fsm_trigger(def, fsm, PREV);
+    }
+}
+
+static fsm_def_t *chain_init(void) {
+    fsm_def_t *def = fsm_def_init(STATE_COUNT, TRIGGER_COUNT, START);
+    fsm_on(def, START, NEXT, ONE);
+    fsm_on(def, ONE, NEXT, TWO);
+    fsm_on(def, TWO, NEXT, STOP);
+    for (int state = START; state < STATE_COUNT; state++) {
+        fsm_set_exit_action(def, state, exit_action);
+    }
+    fsm_set_enter_action(def, ONE, enter_and_next);
+    fsm_set_enter_action(def, TWO, enter_and_next);
+    return def;
+}
+
+int main(void) {
+    fsm_def_t *def;
+    fsm_t fsm;
+
+    // --- Transient states resolve within a single trigger
+    def = chain_init();
+    fsm_init(&fsm, def, NULL);
+    trace[0]   = '\0';
+    int result = fsm_trigger(def, &fsm, NEXT);
+    expect(result == FSM_OK, "chain reported an error");
+    expect(fsm_state(&fsm) == STOP, "chain did not reach STOP");
+    expect(strcmp(trace, "x1e2x2e3x3") == 0, "actions out of order");
+
+    // --- Instances share the definition, not the state
+    fsm_t fsms[3];
+    for (int index = 0; index < 3; index++) {
+        fsm_init(fsms + index, def, NULL);
+    }
+    fsm_trigger(def, fsms + 1, NEXT);
+    expect(fsm_state(fsms) == START && fsm_state(fsms + 2) == START,
+           "trigger leaked into another instance");
+    expect(fsm_state(fsms + 1) == STOP, "shared instance did not run");
+    fsm_def_term(def);
+
+    // --- A chain that comes back to a state is cut off
+    def = chain_init();
+    fsm_on(def, TWO, NEXT, ONE);
+    fsm_init(&fsm, def, NULL);
+    result = fsm_trigger(def, &fsm, NEXT);
+    expect(result == FSM_CYCLE, "cycle not reported");
+    expect(fsm_state(&fsm) == TWO, "cycle not cut off before re-entry");
+
+    // The error is not carried over to the next chain.
+    fsm_on(def, TWO, PREV, STOP);
+    result = fsm_trigger(def, &fsm, PREV);
+    expect(result == FSM_OK, "error carried over to the next chain");
+    expect(fsm_state(&fsm) == STOP, "next chain did not run");
+    fsm_def_term(def);
+
+    // --- Too many triggers from one action overflow the queue
+    def = chain_init();
+    fsm_set_enter_action(def, ONE, enter_and_flood);
+    fsm_init(&fsm, def, NULL);
+    result = fsm_trigger(def, &fsm, NEXT);
+    expect(result == FSM_QUEUE_FULL, "overflow not reported");
+    expect(fsm_state(&fsm) == ONE, "PREV has no transition out of ONE");
+    fsm_def_term(def);
+
+    return expect_finish(NULL);
+}
@@ -7,55 +7,57 @@
 
 static int counter = 0;
 
-void start_activity(fsm_t *fsm, void *ctx) {
-    int *c = (int *)ctx;
+void start_activity(fsm_def_t const *def, fsm_t *fsm) {
+    int *c = (int *)fsm->context;
     *c += 1;
-    fsm_trigger(fsm, NEXT);
+    fsm_trigger(def, fsm, NEXT);
 }
-void one_activity(fsm_t *fsm, void *ctx) {
-    int *c = (int *)ctx;
+void one_activity(fsm_def_t const *def, fsm_t *fsm) {
+    int *c = (int *)fsm->context;
     *c += 1;
-    fsm_trigger(fsm, NEXT);
+    fsm_trigger(def, fsm, NEXT);
 }
-void two_activity(fsm_t *fsm, void *ctx) {
-    int *c = (int *)ctx;
+void two_activity(fsm_def_t const *def, fsm_t *fsm) {
+    int *c = (int *)fsm->context;
     *c += 1;
     printf("Counter is %d\n", *c);
-    fsm_trigger(fsm, NEXT);
+    fsm_trigger(def, fsm, NEXT);
 }
-void stop_activity(fsm_t *fsm, void *ctx) {
+void stop_activity(fsm_def_t const *def, fsm_t *fsm) {
+    (void)def;
     (void)fsm;
-    (void)ctx;
 }
 
 int main(void) {
     // init
-    fsm_t *fsm = fsm_init(STATE_COUNT, TRIGGER_COUNT, START);
+    fsm_def_t *def = fsm_def_init(STATE_COUNT, TRIGGER_COUNT, START);
 
     // activities
-    fsm_set_activity(fsm, START, start_activity, &counter);
-    fsm_set_activity(fsm, ONE, one_activity, &counter);
-    fsm_set_activity(fsm, TWO, two_activity, &counter);
-    fsm_set_activity(fsm, STOP, stop_activity, NULL);
+    fsm_set_activity(def, START, start_activity);
+    fsm_set_activity(def, ONE, one_activity);
+    fsm_set_activity(def, TWO, two_activity);
+    fsm_set_activity(def, STOP, stop_activity);
 
     // start
-    fsm_on(fsm, START, NEXT, ONE);
-    fsm_on(fsm, START, PREV, NOT_ALLOWED);
+    fsm_on(def, START, NEXT, ONE);
+    fsm_on(def, START, PREV, NOT_ALLOWED);
 
     // one
-    fsm_on(fsm, ONE, NEXT, TWO);
-    fsm_on(fsm, ONE, PREV, START);
+    fsm_on(def, ONE, NEXT, TWO);
+    fsm_on(def, ONE, PREV, START);
 
     // two
-    fsm_on(fsm, TWO, NEXT, STOP);
-    fsm_on(fsm, TWO, PREV, ONE);
+    fsm_on(def, TWO, NEXT, STOP);
+    fsm_on(def, TWO, PREV, ONE);
 
     // stop
     // NONE
 
-    while (fsm_state(fsm) != STOP) {
-        fsm_do_activity(fsm);
+    fsm_t fsm;
+    fsm_init(&fsm, def, &counter);
+    while (fsm_state(&fsm) != STOP) {
+        fsm_do_activity(def, &fsm);
     }
 
-    fsm_term(fsm);
+    fsm_def_term(def);
 }
@@ -1,3 +1,4 @@
+#include <stdatomic.h>
 #include <string.h>
 
 #include "SDL_keyboard.h"
@@ -6,17 +7,69 @@
 #include "actions.h"
 #include "alloc.h"
 
+// Key events taken from SDL's queue per call.
+#define EVENT_BATCH_SIZE 32
+
+// Action events waiting for their tick (a power of two). When full, key events
+// wait in SDL's queue instead, until there is room.
+#define PENDING_CAPACITY 256
+
 typedef action_t scancode_to_action_map_t[SDL_NUM_SCANCODES];
 typedef bool binary_action_state_table_t[ACTION_COUNT];
 
 typedef struct action_table_s {
     action_table_cfg_t action_to_scancode_map;
     scancode_to_action_map_t scancode_to_action_map;
-    binary_action_state_table_t binary_action_state_table;
+    binary_action_state_table_t binary_action_state_table; // Down, as of now.
+
+    // --- Events pumped but not yet applied: a ring filled by the pump and drained
+    // by the advance, which may run on different threads
+    action_event_t pending[PENDING_CAPACITY];
+    atomic_size_t pending_head; // Events ever pumped.
+    atomic_size_t pending_tail; // Events ever applied.
+
+    // --- What events did since the last advance
+    action_states_t states;
 } action_table_t;
 
+/**
+ * Keep only events the game reacts to in SDL's queue; the rest arrive in floods
+ * (mouse motion, text input, key repeat) and would only be skipped later.
+ */
+static int filter_event(void *userdata, SDL_Event *event) {
+    (void)userdata;
+    switch (event->type) {
+    case SDL_KEYDOWN:
+        return !event->key.repeat;
+    case SDL_TEXTEDITING:
+    case SDL_TEXTINPUT:
+    case SDL_MOUSEMOTION:
+    case SDL_MOUSEBUTTONDOWN:
+    case SDL_MOUSEBUTTONUP:
+    case SDL_MOUSEWHEEL:
+    case SDL_FINGERDOWN:
+    case SDL_FINGERUP:
+    case SDL_FINGERMOTION:
+    case SDL_MULTIGESTURE:
+    case SDL_JOYAXISMOTION:
+    case SDL_JOYBALLMOTION:
+    case SDL_JOYHATMOTION:
+    case SDL_CONTROLLERAXISMOTION:
+    case SDL_SENSORUPDATE:
+        return 0;
+    default:
+        return 1;
+    }
+}
+
 action_table_t *action_table_init(action_table_cfg_t config) {
     action_table_t *table = new (action_table_t);
+    if (!table) {
+        return NULL;
+    }
+    memset(table, 0, sizeof *table);
+    atomic_init(&table->pending_head, 0);
+    atomic_init(&table->pending_tail, 0);
 
     // --- Initialize Primary Table
     memcpy(table->action_to_scancode_map, config, sizeof(action_table_cfg_t));
@@ -26,6 +79,7 @@ action_table_t *action_table_init(action_table_cfg_t config) {
         table->scancode_to_action_map[table->action_to_scancode_map[action]] = action;
     }
 
+    SDL_SetEventFilter(filter_event, NULL);
     return table;
 }
 
@@ -33,6 +87,7 @@ void action_table_term(action_table_t *table) {
     if (!table) {
         return;
     }
+    SDL_SetEventFilter(NULL, NULL);
     delete (table);
 }
 
@@ -41,14 +96,73 @@ action_t action_table_get_scancode_action(action_table_t *table,
     return table->scancode_to_action_map[scancode];
 }
 
-bool *action_table_get_binary_states(action_table_t *table) {
-    // Polling is done in app layer.
-    uint8_t const *kb = SDL_GetKeyboardState(NULL);
+// -----------------------------------------------------------------------------
+// Action Events
+// -----------------------------------------------------------------------------
 
-    for (size_t action = 0; action < ACTION_COUNT; action++) {
-        table->binary_action_state_table[action] =
-            kb[table->action_to_scancode_map[action]];
+/**
+ * Apply one action event to the table's states.
+ */
+static void apply(action_table_t *table, action_event_t const *event) {
+    action_states_t *states = &table->states;
+
+    table->binary_action_state_table[event->action] = event->is_pressed;
+    if (event->is_pressed) {
+        states->pressed[event->action] = true;
+        states->held[event->action]    = true;
+    } else {
+        states->released[event->action] = true;
     }
+}
 
-    return table->binary_action_state_table;
+void action_table_pump(action_table_t *table) {
+    if (!SDL_WasInit(SDL_INIT_EVENTS)) {
+        return;
+    }
+    SDL_PumpEvents();
+
+    SDL_Event events[EVENT_BATCH_SIZE];
+    int count;
+    do {
+        // Take no more than there is room for; the advance frees it concurrently.
+        size_t head = atomic_load_explicit(&table->pending_head, memory_order_relaxed);
+        size_t tail = atomic_load_explicit(&table->pending_tail, memory_order_acquire);
+        size_t room = PENDING_CAPACITY - (head - tail);
+        if (room > EVENT_BATCH_SIZE) {
+            room = EVENT_BATCH_SIZE;
+        }
+
+        count = SDL_PeepEvents(events, room, SDL_GETEVENT, SDL_KEYDOWN, SDL_KEYUP);
+        for (int index = 0; index < count; index++) {
+            SDL_KeyboardEvent const *key = &events[index].key;
+            action_t action = table->scancode_to_action_map[key->keysym.scancode];
+            if (action != NULL_ACTION) {
+                table->pending[head++ % PENDING_CAPACITY] = (action_event_t){
+                    action, key->type == SDL_KEYDOWN, key->timestamp};
+            }
+        }
+        atomic_store_explicit(&table->pending_head, head, memory_order_release);
+    } while (count == EVENT_BATCH_SIZE);
+}
+
+void action_table_advance(action_table_t *table, uint32_t until,
+                          action_states_t *states) {
+    size_t const head =
+        atomic_load_explicit(&table->pending_head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&table->pending_tail, memory_order_relaxed);
+    for (; tail != head; tail++) {
+        action_event_t const *event = &table->pending[tail % PENDING_CAPACITY];
+        if (!SDL_TICKS_PASSED(until, event->timestamp)) {
+            break;
+        }
+        apply(table, event);
+    }
+    atomic_store_explicit(&table->pending_tail, tail, memory_order_release);
+
+    // Whatever is still down stays held into the next tick.
+    *states       = table->states;
+    table->states = (action_states_t){0};
+    for (action_t action = 0; action < ACTION_COUNT; action++) {
+        states->held[action] |= table->binary_action_state_table[action];
+    }
 }
@@ -1,4 +1,7 @@
+#pragma once
+
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "SDL.h"
 #include "SDL_scancode.h"
@@ -19,18 +22,67 @@ typedef enum {
   CANCEL,
   PAUSE,
   QUIT,
+  PROFILE,
   ACTION_COUNT,
 } action_t;
 
+/**
+ * An action going down or up, and when.
+ */
+typedef struct {
+  action_t action;
+  bool is_pressed;    // Pressed, or else released.
+  uint32_t timestamp; // When, in SDL_GetTicks milliseconds.
+} action_event_t;
+
+/**
+ * What every action did over one tick.
+ *
+ * An action pressed and released within one tick is still held for it, so
+ * short taps are never lost.
+ */
+typedef struct {
+  bool held[ACTION_COUNT];     // Down at any point in the tick.
+  bool pressed[ACTION_COUNT];  // Went down during the tick.
+  bool released[ACTION_COUNT]; // Went up during the tick.
+} action_states_t;
+
 typedef struct action_table_s action_table_t;
 
 typedef SDL_Scancode action_table_cfg_t[ACTION_COUNT];
 
+/**
+ * Initialize an action table, and filter out of SDL's event queue every event
+ * type the game has no use for (mouse, touch, text, controllers, key repeat).
+ *
+ * \sa action_table_term
+ */
 action_table_t *action_table_init(action_table_cfg_t config);
 
+/**
+ * Terminate an action table, removing its event filter.
+ */
 void action_table_term(action_table_t *table);
 
 action_t action_table_get_scancode_action(action_table_t *table,
                                           SDL_Scancode scancode);
 
-bool *action_table_get_binary_states(action_table_t *table);
+/**
+ * Take key presses and releases waiting in SDL's event queue, in batches, as
+ * timestamped action events. Unmapped keys are dropped; keys beyond the room
+ * left for events not yet applied stay queued in SDL.
+ *
+ * Pumps SDL's events, so must be called on the thread that set video up. Does
+ * nothing unless SDL's event subsystem is running.
+ */
+void action_table_pump(action_table_t *table);
+
+/**
+ * Advance the table to time `until` (SDL_GetTicks milliseconds): apply every
+ * action event pumped up to then, in order, and report what each action did
+ * since the last call. Later events wait for a later call.
+ *
+ * May run on another thread than the pump, concurrently; one of each at most.
+ */
+void action_table_advance(action_table_t *table, uint32_t until,
+                          action_states_t *states);
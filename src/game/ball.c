@@ -6,6 +6,7 @@
 #include "ball.h"
 #include "entity.h"
 #include "log.h"
+#include "rng.h"
 
 // --- Size Ratio (Larger value means smaller size)
 //     (40 ~= (640 > 480) -> 640/40 = size 16 ball)
@@ -13,20 +14,13 @@
 
 // --- Velocity Scale (How fast does the ball move?)
 #define BALL_VELOCITY_START 300
+#define BALL_VELOCITY_MAX   16384 // Well inside Q16.16 range.
 
 /** Contains speed data for a ball. */
 typedef struct ball_data_s {
     unsigned short speed;
 } ball_data_t;
 
-/**
- * Move ball along velocity vector.
- */
-static void update(entity_t *ball, float delta) {
-    ball->transform.x += (int)(ball->vx * delta);
-    ball->transform.y += (int)(ball->vy * delta);
-}
-
 /**
  * Get the difference between ball and paddle vertical position.
  *
@@ -34,8 +28,15 @@ static void update(entity_t *ball, float delta) {
  * paddle.
  */
 double get_normalized_vertical_difference(entity_t *self, entity_t *collider) {
-    double vertical_difference   = (double)(self->transform.y - collider->transform.y);
-    double normalized_difference = vertical_difference / collider->transform.h;
+    entity_store_t *store = self->store;
+    fixed_t self_y        = store->y[self->index];
+    fixed_t collider_y    = store->y[collider->index];
+
+    // Sub-pixel, as contact leaves the ball exactly where it touched; whole
+    // pixels sent dead-centre hits back level, to bounce between still paddles
+    // for ever.
+    double vertical_difference   = (double)(self_y - collider_y);
+    double normalized_difference = vertical_difference / store->h[collider->index];
     return normalized_difference;
 }
 
@@ -67,10 +68,13 @@ static void get_collision_vector(entity_t *ball, entity_t *collider, double *vx,
  */
 static void collide_with_paddle(entity_t *self, entity_t *paddle, aabb_edge_t edge) {
     double vx, vy;
-    ball_data_t *data = self->data;
+    ball_data_t *data = entity_get_behaviour(self)->data;
 
     // Bump speed 10% compounding.
     data->speed *= 1.1;
+    if (data->speed > BALL_VELOCITY_MAX) {
+        data->speed = BALL_VELOCITY_MAX;
+    }
 
     // Get new vector based on ball-to-paddle strike location.
     get_collision_vector(self, paddle, &vx, &vy);
@@ -141,13 +145,12 @@ static void out_of_bounds(entity_t *self, aabb_edge_t edge) {
  * rotation.
  *
  */
-static void get_clamped_stochastic_vector(double *vx, double *vy) {
-    double degrees = 80 * ((double)rand() / (double)RAND_MAX - 0.5) +
-                     (10 * ((double)rand() / (double)RAND_MAX));
+static void get_clamped_stochastic_vector(rng_t *rng, double *vx, double *vy) {
+    double degrees = 80 * (rng_next_double(rng) - 0.5) + (10 * rng_next_double(rng));
     double radians = degrees * M_PI / 180;
 
-    int x_dir = ((float)rand() / (float)RAND_MAX) < 0.5 ? -1 : 1;
-    int y_dir = ((float)rand() / (float)RAND_MAX) < 0.5 ? -1 : 1;
+    int x_dir = rng_next_double(rng) < 0.5 ? -1 : 1;
+    int y_dir = rng_next_double(rng) < 0.5 ? -1 : 1;
 
     *vx = cos(radians) * x_dir;
     *vy = sin(radians) * y_dir;
@@ -156,46 +159,55 @@ static void get_clamped_stochastic_vector(double *vx, double *vy) {
 /**
  * Configure a pre-allocated ball.
  */
-void ball_configure(entity_t *ball, aabb_t *field) {
+void ball_configure(entity_t *ball, aabb_t *field, rng_t *rng) {
     // --- Position
     int field_center_x = (field->x + field->w) / 2;
     int field_center_y = (field->y + field->h) / 2;
-    aabb_set_center_position(&ball->transform, field_center_x, field_center_y);
+    aabb_t transform;
+    entity_get_transform(ball, &transform);
+    aabb_set_center_position(&transform, field_center_x, field_center_y);
 
     // --- Size
     int largest_field_axis = field->w >= field->h ? field->w : field->h;
     int scaled_size        = largest_field_axis / BALL_SIZE_RATIO;
-    ball->transform.w      = scaled_size;
-    ball->transform.h      = scaled_size;
+    transform.w            = scaled_size;
+    transform.h            = scaled_size;
+    entity_set_transform(ball, &transform);
 
     // --- Velocity
-    if (!ball->data) {
-        ball->data = new (ball_data_t);
-    }
-
-    ball_data_t *data = ball->data;
+    entity_behaviour_t *behaviour = entity_get_behaviour(ball);
+    ball_data_t *data             = behaviour->data;
     data->speed       = BALL_VELOCITY_START;
 
     double vx, vy;
-    get_clamped_stochastic_vector(&vx, &vy);
+    get_clamped_stochastic_vector(rng, &vx, &vy);
     entity_set_velocity(ball, (int)floor(vx * data->speed),
                         (int)floor(vy * data->speed));
 
+    // --- Interpolation
+    // Freshly placed; nothing to interpolate from.
+    entity_commit_transform(ball);
+
     // --- Polymorphic Properties
-    ball->update        = update;
-    ball->collide       = collide;
-    ball->out_of_bounds = out_of_bounds;
+    behaviour->collide       = collide;
+    behaviour->out_of_bounds = out_of_bounds;
 }
 
 /**
- * Allocate and configure ball.
- *
- * WARNING: This is not in use, and has no sister-function for termination.
+ * Add a ball to `store` and configure it.
  */
-entity_t *ball_init(aabb_t *field) {
-    entity_t *ball = entity_init();
-    ball_configure(ball, field);
-    return ball;
+entity_handle_t ball_init(entity_store_t *store, aabb_t *field, arena_t *arena,
+                          rng_t *rng) {
+    entity_handle_t handle = entity_spawn(store);
+    entity_t ball;
+    if (!entity_get(store, handle, &ball)) {
+        log_error("Cannot spawn ball: entity store is full");
+        return ENTITY_HANDLE_NULL;
+    }
+
+    entity_get_behaviour(&ball)->data = arena_new(arena, ball_data_t);
+    ball_configure(&ball, field, rng);
+    return handle;
 }
 
 /**
@@ -206,3 +218,13 @@ void ball_reverse_direction(entity_t *ball) {
     entity_get_velocity(ball, &vx, &vy);
     entity_set_velocity(ball, -vx, -vy);
 }
+
+unsigned short ball_get_speed(entity_t *ball) {
+    ball_data_t *data = entity_get_behaviour(ball)->data;
+    return data->speed;
+}
+
+void ball_set_speed(entity_t *ball, unsigned short speed) {
+    ball_data_t *data = entity_get_behaviour(ball)->data;
+    data->speed       = speed;
+}
@@ -1,18 +1,33 @@
 #pragma once
 
+#include "alloc.h"
 #include "entity.h"
+#include "rng.h"
 
 /**
- * Configure `ball` properties based on playing `field`.
+ * Configure `ball` properties based on playing `field`, serving in a direction
+ * drawn from `rng`.
  */
-void ball_configure(entity_t *ball, aabb_t *field);
+void ball_configure(entity_t *ball, aabb_t *field, rng_t *rng);
 
 /**
- * Initialize new ball.
+ * Initialize new ball in `store`, keeping its speed data in `arena`.
  */
-entity_t *ball_init(aabb_t *field);
+entity_handle_t ball_init(entity_store_t *store, aabb_t *field, arena_t *arena,
+                          rng_t *rng);
 
 /**
  * Reverse the current direction of the ball.
  */
 void ball_reverse_direction(entity_t *ball);
+
+/**
+ * Get the speed the ball moves at, in pixels per second.
+ */
+unsigned short ball_get_speed(entity_t *ball);
+
+/**
+ * Set the speed the ball moves at from its next bounce, e.g. when restoring
+ * a saved match.
+ */
+void ball_set_speed(entity_t *ball, unsigned short speed);
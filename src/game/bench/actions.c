@@ -0,0 +1,80 @@
+/**
+ * Action Table Benchmark.
+ *
+ * Advances the table through a tap of one key, queued as SDL events, as the
+ * game does once per tick, and maps raw scancodes to actions. One op is one
+ * call.
+ */
+
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include "bench/bench.h"
+#include "game/actions.h"
+
+#define CALLS_PER_RUN 256
+
+static action_table_cfg_t config = {
+    [MENU_UP] = SDL_SCANCODE_UP,     [MENU_DOWN] = SDL_SCANCODE_DOWN,
+    [MENU_LEFT] = SDL_SCANCODE_LEFT, [MENU_RIGHT] = SDL_SCANCODE_RIGHT,
+    [P1_UP] = SDL_SCANCODE_A,        [P1_DOWN] = SDL_SCANCODE_Z,
+    [P2_UP] = SDL_SCANCODE_K,        [P2_DOWN] = SDL_SCANCODE_M,
+    [CONFIRM] = SDL_SCANCODE_RETURN, [CANCEL] = SDL_SCANCODE_ESCAPE,
+    [PAUSE] = SDL_SCANCODE_P,        [QUIT] = SDL_SCANCODE_Q,
+    [PROFILE] = SDL_SCANCODE_F9,
+};
+
+static volatile unsigned long checksum = 0;
+
+// --- Cases
+
+static void push_key(Uint32 type, SDL_Scancode scancode) {
+    SDL_Event event           = {.type = type};
+    event.key.keysym.scancode = scancode;
+    SDL_PushEvent(&event);
+}
+
+static void run_advance(void *context) {
+    unsigned long sum = 0;
+    action_states_t states;
+    for (int call = 0; call < CALLS_PER_RUN; call++) {
+        push_key(SDL_KEYDOWN, config[P1_UP]);
+        push_key(SDL_KEYUP, config[P1_UP]);
+        action_table_pump(context);
+        action_table_advance(context, SDL_GetTicks(), &states);
+        sum += states.held[P1_UP];
+    }
+    checksum += sum;
+}
+
+static void run_scancode_action(void *context) {
+    unsigned long sum = 0;
+    for (int call = 0; call < CALLS_PER_RUN; call++) {
+        sum += action_table_get_scancode_action(context, config[call % ACTION_COUNT]);
+    }
+    checksum += sum;
+}
+
+int main(int argc, char *argv[]) {
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+        return EXIT_FAILURE;
+    }
+
+    bench_t *bench = bench_init("actions", argc, argv);
+    if (!bench) {
+        SDL_Quit();
+        return EXIT_FAILURE;
+    }
+
+    action_table_t *table = action_table_init(config);
+    bench_run(bench, "actions/advance", run_advance, table, CALLS_PER_RUN);
+    bench_run(bench, "actions/scancode_action", run_scancode_action, table,
+              CALLS_PER_RUN);
+    action_table_term(table);
+
+    int status = bench_term(bench);
+    SDL_Quit();
+    return status;
+}
@@ -0,0 +1,188 @@
+/**
+ * Collision Benchmark.
+ *
+ * Times `collision_process` at 10, 1k, 10k and 100k small entities scattered
+ * over a field sized for constant density, against the old all-pairs loop where
+ * that is still feasible. Entities stand still, so both must tell every entity
+ * about the same collisions in the same order. From 10k entities, the grid is
+ * also timed with its broadphase split over a job system of every core, which
+ * must agree with it exactly. One op is one tick.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "aabb.h"
+#include "alloc.h"
+#include "bench/bench.h"
+#include "game/collision.h"
+#include "game/entity.h"
+#include "jobs/jobs.h"
+
+#define ENTITY_SIZE        8
+#define CELL_SIZE          32
+#define FIELD_AREA_PER_BOX (32 * 32)
+#define BRUTE_FORCE_LIMIT  1000
+#define JOBS_THRESHOLD     10000
+#define TICK_DELTA         (1.0f / 60)
+
+/** Per-entity, order-sensitive digest of the collision callbacks it received. */
+static uint64_t *digests = NULL;
+
+/** Per-tick scratch, reset before every tick as a match resets its own. */
+static arena_t *scratch = NULL;
+
+/** One thread per core. */
+static job_system_t *core_jobs = NULL;
+
+static void collide(entity_t *self, entity_t *collider, aabb_edge_t edge) {
+    uint64_t *digest = &digests[self->index];
+    uint64_t event   = (uint64_t)collider->index << 3 ^ edge;
+    *digest          = (*digest ^ event) * 0x100000001B3ull;
+}
+
+/**
+ * Previous `collision_process`: every ordered pair, one test each.
+ */
+static void brute_force_process(entity_store_t *store) {
+    for (size_t subject_index = 0; subject_index < store->count; subject_index++) {
+        entity_t subject = {store, subject_index};
+        aabb_t subject_box;
+        entity_get_transform(&subject, &subject_box);
+
+        for (size_t collider_index = 0; collider_index < store->count;
+             collider_index++) {
+            if (subject_index == collider_index)
+                continue;
+            entity_t collider = {store, collider_index};
+            aabb_t collider_box;
+            entity_get_transform(&collider, &collider_box);
+
+            aabb_edge_t edge = aabb_get_intersection(&subject_box, &collider_box);
+            if (edge && store->behaviour[subject_index].collide) {
+                store->behaviour[subject_index].collide(&subject, &collider, edge);
+            }
+        }
+    }
+}
+
+static uint64_t digest_run(collision_grid_t *grid, entity_store_t *store,
+                           job_system_t *jobs) {
+    memset(digests, 0, store->count * sizeof(uint64_t));
+    if (grid) {
+        arena_reset(scratch);
+        collision_process(grid, store, scratch, jobs, TICK_DELTA);
+    } else {
+        brute_force_process(store);
+    }
+
+    uint64_t digest = 0;
+    for (size_t index = 0; index < store->count; index++) {
+        digest = (digest ^ digests[index]) * 0x100000001B3ull;
+    }
+    return digest;
+}
+
+typedef struct {
+    collision_grid_t *grid;
+    entity_store_t *store;
+    job_system_t *jobs;
+} collision_case_t;
+
+static void run_grid(void *context) {
+    collision_case_t *c = context;
+    arena_reset(scratch);
+    collision_process(c->grid, c->store, scratch, c->jobs, TICK_DELTA);
+}
+
+static void run_brute_force(void *context) {
+    collision_case_t *c = context;
+    brute_force_process(c->store);
+}
+
+static void bench_entity_count(bench_t *bench, size_t entity_count) {
+    int side     = (int)SDL_sqrt((double)entity_count * FIELD_AREA_PER_BOX);
+    aabb_t field = {0, 0, side, side};
+
+    entity_store_t *store = entity_store_init(entity_count);
+
+    srand(entity_count);
+    for (size_t index = 0; index < entity_count; index++) {
+        entity_t e;
+        entity_get(store, entity_spawn(store), &e);
+        aabb_t transform = {rand() % side, rand() % side, ENTITY_SIZE, ENTITY_SIZE};
+        entity_set_transform(&e, &transform);
+        entity_get_behaviour(&e)->collide = collide;
+    }
+
+    collision_grid_t *grid = collision_grid_init(&field, CELL_SIZE);
+    digests                = new_array(entity_count, uint64_t);
+
+    collision_case_t context = {grid, store, NULL};
+    char name[64];
+
+    // --- Grid
+    snprintf(name, sizeof name, "collision/grid/%zu", entity_count);
+    bench_run(bench, name, run_grid, &context, 1);
+    double grid_ns = bench_get_last_ns_per_op(bench);
+
+    // --- Grid, on every core
+    if (entity_count >= JOBS_THRESHOLD && core_jobs) {
+        collision_case_t parallel = {grid, store, core_jobs};
+        snprintf(name, sizeof name, "collision/jobs/%zu", entity_count);
+        bench_run(bench, name, run_grid, &parallel, 1);
+        printf("collision/%zu: %u threads %.1fx faster than one\n", entity_count,
+               job_system_get_thread_count(core_jobs),
+               grid_ns / bench_get_last_ns_per_op(bench));
+
+        if (digest_run(grid, store, core_jobs) != digest_run(grid, store, NULL)) {
+            fprintf(stderr, "collision/%zu: job system changed the collisions\n",
+                    entity_count);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // --- All pairs
+    if (entity_count <= BRUTE_FORCE_LIMIT) {
+        snprintf(name, sizeof name, "collision/brute/%zu", entity_count);
+        bench_run(bench, name, run_brute_force, &context, 1);
+        printf("collision/%zu: grid %.1fx faster than all-pairs\n", entity_count,
+               bench_get_last_ns_per_op(bench) / grid_ns);
+
+        uint64_t grid_digest  = digest_run(grid, store, NULL);
+        uint64_t brute_digest = digest_run(NULL, store, NULL);
+        if (grid_digest != brute_digest) {
+            fprintf(stderr, "collision/%zu: broadphase disagrees with all-pairs\n",
+                    entity_count);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    collision_grid_term(grid);
+    delete (digests);
+    entity_store_term(store);
+}
+
+int main(int argc, char *argv[]) {
+    bench_t *bench = bench_init("collision", argc, argv);
+    if (!bench || !(scratch = arena_init(0))) {
+        bench_term(bench);
+        return EXIT_FAILURE;
+    }
+    if (!(core_jobs = job_system_init(0))) {
+        fprintf(stderr, "Cannot initialize job system; timing one thread only\n");
+    }
+
+    bench_entity_count(bench, 10);
+    bench_entity_count(bench, 1000);
+    bench_entity_count(bench, 10000);
+    bench_entity_count(bench, 100000);
+
+    job_system_term(core_jobs);
+    arena_term(scratch);
+    return bench_term(bench);
+}
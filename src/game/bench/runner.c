@@ -0,0 +1,68 @@
+/**
+ * Match Runner Benchmark.
+ *
+ * Plays batches of unattended matches on 1, 2, 4 and one thread per core, and
+ * reports each pool's speedup over a single thread. One op is one match.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include "bench/bench.h"
+#include "game/runner.h"
+
+#define MATCHES_PER_RUN 16
+
+typedef struct {
+    runner_config_t config;
+    match_result_t results[MATCHES_PER_RUN];
+} batch_t;
+
+static void run_batch(void *context) {
+    batch_t *batch = context;
+    runner_run(&batch->config, batch->results);
+    batch->config.seed += MATCHES_PER_RUN; // New matches every call.
+}
+
+int main(int argc, char *argv[]) {
+    bench_t *bench = bench_init("runner", argc, argv);
+    if (!bench) {
+        return EXIT_FAILURE;
+    }
+
+    static batch_t batch = {
+        .config = {.match_count = MATCHES_PER_RUN,
+                   .field       = {0, 0, 640, 480},
+                   .tick_rate   = 60,
+                   .tick_limit  = 36000},
+    };
+
+    unsigned const core_count      = SDL_GetCPUCount();
+    unsigned const thread_counts[] = {1, 2, 4, core_count};
+    double single_thread_ns_per_op = 0;
+
+    for (size_t index = 0; index < SDL_arraysize(thread_counts); index++) {
+        unsigned thread_count = thread_counts[index];
+        if (index && thread_count <= thread_counts[index - 1]) {
+            continue;
+        }
+
+        char name[64];
+        snprintf(name, sizeof name, "runner/threads/%u", thread_count);
+        batch.config.seed         = 0;
+        batch.config.thread_count = thread_count;
+        bench_run(bench, name, run_batch, &batch, MATCHES_PER_RUN);
+
+        double ns_per_op = bench_get_last_ns_per_op(bench);
+        if (thread_count == 1) {
+            single_thread_ns_per_op = ns_per_op;
+        } else {
+            printf("runner/threads/%u: %.2fx a single thread (%u cores)\n",
+                   thread_count, single_thread_ns_per_op / ns_per_op, core_count);
+        }
+    }
+
+    return bench_term(bench);
+}
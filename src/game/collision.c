@@ -1,39 +1,551 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
 #include "collision.h"
 #include "log.h"
 
-void collision_process(size_t entity_count, entity_t *entity_pool[entity_count]) {
-    for (size_t subject_index = 0; subject_index < entity_count; subject_index++) {
-        entity_t *subject = entity_pool[subject_index];
-        for (size_t collider_index = 0; collider_index < entity_count;
-             collider_index++) {
-            if (subject_index == collider_index)
+// -----------------------------------------------------------------------------
+// Broadphase Grid
+// -----------------------------------------------------------------------------
+
+// Entities per chunk of broadphase work. Chunk boundaries, and so the order
+// chunk results are merged in, depend only on the entity count.
+#define SUBJECTS_PER_CHUNK 1024
+
+/** Inclusive range of grid cells covered by one entity. */
+typedef struct {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+} cell_range_t;
+
+/** Distance an entity travels over what is left of this tick. */
+typedef struct {
+    fixed_t dx;
+    fixed_t dy;
+} displacement_t;
+
+/** Two entities sharing a cell; `subject` has the lower index. */
+typedef struct {
+    int subject;
+    int collider;
+} pair_t;
+
+/**
+ * Broadphase output for one chunk of subjects, only ever touched by the thread
+ * working on that chunk.
+ */
+typedef struct {
+    // Higher-indexed candidates of the subject currently being processed.
+    int *candidates;
+    size_t candidate_count;
+    size_t candidate_capacity;
+
+    // Every pair found, by subject then collider.
+    pair_t *pairs;
+    size_t pair_count;
+    size_t pair_capacity;
+
+    bool is_out_of_memory; // Pairs were lost this tick.
+} chunk_t;
+
+typedef struct collision_grid_s {
+    aabb_t field;  // Q16.16, like entity positions.
+    int cell_size; // Q16.16.
+    int columns;
+    int rows;
+
+    // Entity indices grouped by cell; cell `c` owns [cell_starts[c], cell_starts[c+1]).
+    int *cell_starts;
+    int *cell_cursors;
+
+    // --- Per tick, in the caller's scratch arena
+    entity_store_t *store;
+    fixed_t step;
+    int *entries;
+    cell_range_t *ranges;
+
+    // --- Kept between ticks
+    chunk_t *chunks;
+    size_t chunk_capacity;
+} collision_grid_t;
+
+/**
+ * Convert a box in whole pixels into the Q16.16 units entities are stored in.
+ */
+static aabb_t to_fixed_box(aabb_t *box) {
+    return (aabb_t){fixed_from_int(box->x), fixed_from_int(box->y),
+                    fixed_from_int(box->w), fixed_from_int(box->h)};
+}
+
+static size_t get_chunk_count(size_t entity_count) {
+    return (entity_count + SUBJECTS_PER_CHUNK - 1) / SUBJECTS_PER_CHUNK;
+}
+
+collision_grid_t *collision_grid_init(aabb_t *field, int cell_size) {
+    collision_grid_t *grid = new (collision_grid_t);
+    if (!grid) {
+        return NULL;
+    }
+    grid->field     = to_fixed_box(field);
+    grid->cell_size = fixed_from_int(cell_size);
+    grid->columns   = (field->w + cell_size - 1) / cell_size;
+    grid->rows      = (field->h + cell_size - 1) / cell_size;
+
+    if (grid->columns < 1)
+        grid->columns = 1;
+    if (grid->rows < 1)
+        grid->rows = 1;
+
+    size_t cell_count  = grid->columns * grid->rows;
+    grid->cell_starts  = new_array(cell_count + 1, int);
+    grid->cell_cursors = new_array(cell_count, int);
+    grid->store        = NULL;
+    grid->step         = 0;
+    grid->entries      = NULL;
+    grid->ranges       = NULL;
+
+    grid->chunks         = NULL;
+    grid->chunk_capacity = 0;
+
+    if (!grid->cell_starts || !grid->cell_cursors) {
+        collision_grid_term(grid);
+        return NULL;
+    }
+    return grid;
+}
+
+void collision_grid_term(collision_grid_t *grid) {
+    if (!grid) {
+        return;
+    }
+    for (size_t chunk = 0; chunk < grid->chunk_capacity; chunk++) {
+        delete (grid->chunks[chunk].candidates);
+        delete (grid->chunks[chunk].pairs);
+    }
+    delete (grid->chunks);
+    delete (grid->cell_starts);
+    delete (grid->cell_cursors);
+    delete (grid);
+}
+
+/**
+ * Grow `buffer` to hold at least `required` elements of `size` bytes.
+ *
+ * \returns the grown buffer, or NULL if out of memory, leaving `buffer` and
+ *          `capacity` as they were.
+ */
+static void *reserve(void *buffer, size_t *capacity, size_t required, size_t size) {
+    if (required <= *capacity) {
+        return buffer;
+    }
+    void *grown = realloc(buffer, required * 2 * size);
+    if (grown) {
+        *capacity = required * 2;
+    }
+    return grown;
+}
+
+/**
+ * Make room for the output of `chunk_count` chunks, keeping what each chunk
+ * already reserved.
+ *
+ * \returns false if out of memory.
+ */
+static bool reserve_chunks(collision_grid_t *grid, size_t chunk_count) {
+    if (chunk_count <= grid->chunk_capacity) {
+        return true;
+    }
+    chunk_t *chunks = realloc(grid->chunks, chunk_count * sizeof(chunk_t));
+    if (!chunks) {
+        return false;
+    }
+    memset(&chunks[grid->chunk_capacity], 0,
+           (chunk_count - grid->chunk_capacity) * sizeof(chunk_t));
+    grid->chunks         = chunks;
+    grid->chunk_capacity = chunk_count;
+    return true;
+}
+
+static int clamp_cell(int cell, int count) {
+    return cell < 0 ? 0 : cell >= count ? count - 1 : cell;
+}
+
+static void get_cell_range(collision_grid_t *grid, int x, int y, int w, int h,
+                           cell_range_t *range) {
+    int left   = x - grid->field.x;
+    int top    = y - grid->field.y;
+    int right  = left + (w > 0 ? w - 1 : 0);
+    int bottom = top + (h > 0 ? h - 1 : 0);
+
+    // Division truncates towards zero; anything left of or above the field is
+    // clamped into the first column or row regardless.
+    range->x0 = clamp_cell(left / grid->cell_size, grid->columns);
+    range->y0 = clamp_cell(top / grid->cell_size, grid->rows);
+    range->x1 = clamp_cell(right / grid->cell_size, grid->columns);
+    range->y1 = clamp_cell(bottom / grid->cell_size, grid->rows);
+}
+
+/**
+ * Get how far entity `index` travels from `time` (0..FIXED_ONE) through this
+ * tick to its end, at its current velocity; exactly what
+ * `entity_store_integrate` would move it.
+ */
+static displacement_t get_displacement(collision_grid_t *grid, entity_store_t *store,
+                                       size_t index, fixed_t time) {
+    return (displacement_t){
+        entity_store_get_displacement(store->vx[index], grid->step, time),
+        entity_store_get_displacement(store->vy[index], grid->step, time),
+    };
+}
+
+/**
+ * Find the cells every entity in a chunk covers on its path this tick.
+ */
+static void find_ranges(void *context, size_t first, size_t count) {
+    collision_grid_t *grid = context;
+    entity_store_t *store  = grid->store;
+
+    for (size_t index = first; index < first + count; index++) {
+        displacement_t d = get_displacement(grid, store, index, store->elapsed[index]);
+
+        // Bounds of the box over the whole tick.
+        int x = d.dx < 0 ? store->x[index] + d.dx : store->x[index];
+        int y = d.dy < 0 ? store->y[index] + d.dy : store->y[index];
+        int w = store->w[index] + abs(d.dx);
+        int h = store->h[index] + abs(d.dy);
+
+        get_cell_range(grid, x, y, w, h, &grid->ranges[index]);
+    }
+}
+
+/**
+ * File every entity under each cell its path this tick covers (counting sort,
+ * so each cell lists its entities in ascending index order).
+ *
+ * Paths are found a chunk of entities per job; filing them is a tight pass
+ * over the results, done in index order on the calling thread.
+ *
+ * \returns false if out of memory.
+ */
+static bool grid_rebuild(collision_grid_t *grid, entity_store_t *store,
+                         arena_t *scratch, job_system_t *jobs, float delta) {
+    size_t entity_count = store->count;
+    int cell_count      = grid->columns * grid->rows;
+
+    grid->store  = store;
+    grid->step   = entity_store_get_step(delta);
+    grid->ranges = arena_new_array(scratch, entity_count, cell_range_t);
+    if (!grid->ranges) {
+        return false;
+    }
+    job_parallel_for(jobs, find_ranges, grid, entity_count, SUBJECTS_PER_CHUNK);
+
+    // --- Count entries per cell
+    memset(grid->cell_starts, 0, (cell_count + 1) * sizeof(int));
+    for (size_t index = 0; index < entity_count; index++) {
+        cell_range_t *range = &grid->ranges[index];
+        for (int y = range->y0; y <= range->y1; y++) {
+            for (int x = range->x0; x <= range->x1; x++) {
+                grid->cell_starts[y * grid->columns + x + 1]++;
+            }
+        }
+    }
+
+    // --- Prefix sum into cell offsets
+    for (int cell = 0; cell < cell_count; cell++) {
+        grid->cell_starts[cell + 1] += grid->cell_starts[cell];
+        grid->cell_cursors[cell] = grid->cell_starts[cell];
+    }
+
+    // --- Fill
+    grid->entries = arena_new_array(scratch, grid->cell_starts[cell_count], int);
+    if (!grid->entries) {
+        return false;
+    }
+    for (size_t index = 0; index < entity_count; index++) {
+        cell_range_t *range = &grid->ranges[index];
+        for (int y = range->y0; y <= range->y1; y++) {
+            for (int x = range->x0; x <= range->x1; x++) {
+                grid->entries[grid->cell_cursors[y * grid->columns + x]++] = index;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Collect, in ascending order, every higher-indexed entity sharing a cell with
+ * `subject`.
+ *
+ * Entities covering several cells may meet in more than one; a pair is only
+ * reported from the cell holding the top-left corner of their shared cells.
+ *
+ * \returns false if out of memory.
+ */
+static bool grid_collect_candidates(collision_grid_t *grid, chunk_t *chunk,
+                                    int subject) {
+    cell_range_t *rs       = &grid->ranges[subject];
+    chunk->candidate_count = 0;
+
+    for (int y = rs->y0; y <= rs->y1; y++) {
+        for (int x = rs->x0; x <= rs->x1; x++) {
+            int cell  = y * grid->columns + x;
+            int first = grid->cell_starts[cell];
+            int last  = grid->cell_starts[cell + 1];
+
+            for (int entry = first; entry < last; entry++) {
+                int other = grid->entries[entry];
+                if (other <= subject) {
+                    continue;
+                }
+
+                cell_range_t *ro = &grid->ranges[other];
+                int reference_x  = rs->x0 > ro->x0 ? rs->x0 : ro->x0;
+                int reference_y  = rs->y0 > ro->y0 ? rs->y0 : ro->y0;
+                if (reference_x != x || reference_y != y) {
+                    continue;
+                }
+
+                int *candidates =
+                    reserve(chunk->candidates, &chunk->candidate_capacity,
+                            chunk->candidate_count + 1, sizeof(int));
+                if (!candidates) {
+                    return false;
+                }
+                chunk->candidates                           = candidates;
+                chunk->candidates[chunk->candidate_count++] = other;
+            }
+        }
+    }
+
+    // Insertion sort; there are rarely more than a handful of candidates.
+    for (size_t i = 1; i < chunk->candidate_count; i++) {
+        int candidate = chunk->candidates[i];
+        size_t j      = i;
+        for (; j > 0 && chunk->candidates[j - 1] > candidate; j--) {
+            chunk->candidates[j] = chunk->candidates[j - 1];
+        }
+        chunk->candidates[j] = candidate;
+    }
+    return true;
+}
+
+/**
+ * List every candidate pair of the subjects in a chunk, stopping short (and
+ * flagging the chunk) if out of memory.
+ */
+static void collect_chunk(void *context, size_t first, size_t count) {
+    collision_grid_t *grid  = context;
+    chunk_t *chunk          = &grid->chunks[first / SUBJECTS_PER_CHUNK];
+    chunk->pair_count       = 0;
+    chunk->is_out_of_memory = false;
+
+    for (size_t subject = first; subject < first + count; subject++) {
+        if (!grid_collect_candidates(grid, chunk, subject)) {
+            chunk->is_out_of_memory = true;
+            return;
+        }
+        if (!chunk->candidate_count) {
+            continue;
+        }
+
+        pair_t *pairs = reserve(chunk->pairs, &chunk->pair_capacity,
+                                chunk->pair_count + chunk->candidate_count,
+                                sizeof(pair_t));
+        if (!pairs) {
+            chunk->is_out_of_memory = true;
+            return;
+        }
+        chunk->pairs = pairs;
+        for (size_t candidate = 0; candidate < chunk->candidate_count; candidate++) {
+            chunk->pairs[chunk->pair_count++] =
+                (pair_t){subject, chunk->candidates[candidate]};
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Collision Processing
+// -----------------------------------------------------------------------------
+
+/**
+ * Get the bounding box of entity `index` straight from the store's columns.
+ */
+static void get_box(entity_store_t *store, size_t index, aabb_t *box) {
+    box->x = store->x[index];
+    box->y = store->y[index];
+    box->w = store->w[index];
+    box->h = store->h[index];
+}
+
+/**
+ * Check whether entity `index` was despawned, possibly by an earlier contact's
+ * behaviour this tick.
+ */
+static bool is_despawned(entity_store_t *store, size_t index) {
+    return store->slots[store->row_slots[index]].is_pending;
+}
+
+/**
+ * Move entity `index` `fraction` (0..FIXED_ONE) of the way along `d`.
+ */
+static void advance(entity_store_t *store, size_t index, displacement_t d,
+                    fixed_t fraction) {
+    // Truncate towards zero, so boxes stop short of contact rather than overlap.
+    store->x[index] += (fixed_t)((int64_t)d.dx * fraction / FIXED_ONE);
+    store->y[index] += (fixed_t)((int64_t)d.dy * fraction / FIXED_ONE);
+}
+
+/**
+ * Move entity `index` on to `time` (0..FIXED_ONE) through this tick, at its
+ * current velocity, if an earlier contact left it behind.
+ */
+static void catch_up(collision_grid_t *grid, entity_store_t *store, size_t index,
+                     fixed_t time) {
+    fixed_t elapsed = store->elapsed[index];
+    if (elapsed >= time) {
+        return;
+    }
+    displacement_t d = get_displacement(grid, store, index, elapsed);
+    advance(store, index, d, time - elapsed);
+    store->elapsed[index] = time;
+}
+
+/**
+ * Find how `subject` and `collider` touch this tick, if at all.
+ *
+ * Both are first brought to the same point in the tick, as an earlier contact
+ * may have stopped either of them part of the way. Boxes then overlapping
+ * collide where they stand. Otherwise both are swept along what is left of
+ * their movement, at their velocity as it is now, and on contact are moved to
+ * where they first touch; the rest of the tick is left to
+ * `entity_store_integrate`.
+ */
+static bool find_contact(collision_grid_t *grid, entity_store_t *store,
+                         size_t subject_index, size_t collider_index,
+                         aabb_edge_t *subject_edge, aabb_edge_t *collider_edge) {
+    fixed_t const subject_elapsed  = store->elapsed[subject_index];
+    fixed_t const collider_elapsed = store->elapsed[collider_index];
+    fixed_t const time =
+        subject_elapsed > collider_elapsed ? subject_elapsed : collider_elapsed;
+    catch_up(grid, store, subject_index, time);
+    catch_up(grid, store, collider_index, time);
+
+    aabb_t subject_box, collider_box;
+    get_box(store, subject_index, &subject_box);
+    get_box(store, collider_index, &collider_box);
+
+    if (aabb_get_mutual_intersection(&subject_box, &collider_box, subject_edge,
+                                     collider_edge)) {
+        return true;
+    }
+
+    displacement_t ds = get_displacement(grid, store, subject_index, time);
+    displacement_t dc = get_displacement(grid, store, collider_index, time);
+    if (!ds.dx && !ds.dy && !dc.dx && !dc.dy) {
+        return false;
+    }
+
+    aabb_contact_t contact;
+    if (!aabb_get_swept_intersection(&subject_box, ds.dx, ds.dy, &collider_box,
+                                     dc.dx, dc.dy, &contact)) {
+        return false;
+    }
+
+    // `contact.time` is a fraction of what was left of the tick.
+    fixed_t const contact_time =
+        time + (fixed_t)((int64_t)contact.time * (FIXED_ONE - time) / FIXED_ONE);
+    advance(store, subject_index, ds, contact.time);
+    advance(store, collider_index, dc, contact.time);
+    store->elapsed[subject_index]  = contact_time;
+    store->elapsed[collider_index] = contact_time;
+
+    *subject_edge  = contact.a_edge;
+    *collider_edge = contact.b_edge;
+    return true;
+}
+
+bool collision_process(collision_grid_t *grid, entity_store_t *store,
+                       arena_t *scratch, job_system_t *jobs, float delta) {
+    size_t chunk_count = get_chunk_count(store->count);
+
+    // --- Broadphase, a chunk of subjects at a time
+    if (!reserve_chunks(grid, chunk_count) ||
+        !grid_rebuild(grid, store, scratch, jobs, delta)) {
+        log_error("Out of memory for the collision grid; skipping collisions");
+        return false;
+    }
+    job_parallel_for(jobs, collect_chunk, grid, store->count, SUBJECTS_PER_CHUNK);
+    for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+        if (grid->chunks[chunk].is_out_of_memory) {
+            log_error("Out of memory for collision pairs; skipping collisions");
+            return false;
+        }
+    }
+
+    // --- Narrowphase
+    // Contacts move entities and behaviours may change their velocity, so pairs
+    // are resolved one after another, in subject order, each swept as things
+    // stand after the last.
+    for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+        pair_t *pairs = grid->chunks[chunk].pairs;
+        for (size_t pair = 0; pair < grid->chunks[chunk].pair_count; pair++) {
+            size_t subject_index  = pairs[pair].subject;
+            size_t collider_index = pairs[pair].collider;
+            if (is_despawned(store, subject_index) ||
+                is_despawned(store, collider_index)) {
+                continue;
+            }
+
+            aabb_edge_t subject_edge, collider_edge;
+            if (!find_contact(grid, store, subject_index, collider_index, &subject_edge,
+                              &collider_edge)) {
                 continue;
-            entity_t *collider = entity_pool[collider_index];
-            aabb_edge_t intersection =
-                aabb_get_intersection(&subject->transform, &collider->transform);
-            if (intersection && subject->collide) {
-                subject->collide(subject, collider, intersection);
-            }
-        }
-    }
-}
-
-void collision_out_of_bounds_process(size_t entity_count,
-                                     entity_t *entity_pool[entity_count],
-                                     aabb_t *field) {
-    aabb_t *subject_box;
-    for (size_t subject_index = 0; subject_index < entity_count; subject_index++) {
-        entity_t *subject = entity_pool[subject_index];
-        subject_box       = &subject->transform;
-        if (subject->out_of_bounds) {
-            if (aabb_is_beyond_edge(subject_box, field, AABB_TOP_EDGE)) {
-                subject->out_of_bounds(subject, AABB_TOP_EDGE);
-            } else if (aabb_is_beyond_edge(subject_box, field, AABB_BOTTOM_EDGE)) {
-                subject->out_of_bounds(subject, AABB_BOTTOM_EDGE);
-            } else if (aabb_is_beyond_edge(subject_box, field, AABB_LEFT_EDGE)) {
-                subject->out_of_bounds(subject, AABB_LEFT_EDGE);
-            } else if (aabb_is_beyond_edge(subject_box, field, AABB_RIGHT_EDGE)) {
-                subject->out_of_bounds(subject, AABB_RIGHT_EDGE);
+            }
+
+            // Behaviour is cold; only pairs that actually touch reach it.
+            entity_t subject                       = {store, subject_index};
+            entity_t collider                      = {store, collider_index};
+            entity_behaviour_t *subject_behaviour  = &store->behaviour[subject_index];
+            entity_behaviour_t *collider_behaviour = &store->behaviour[collider_index];
+
+            if (subject_behaviour->collide) {
+                subject_behaviour->collide(&subject, &collider, subject_edge);
+            }
+            if (collider_behaviour->collide && !is_despawned(store, subject_index)) {
+                collider_behaviour->collide(&collider, &subject, collider_edge);
+            }
+        }
+    }
+    return true;
+}
+
+void collision_out_of_bounds_process(entity_store_t *store, aabb_t *field) {
+    // Entities are tested a chunk at a time by the batch kernel.
+    enum { CHUNK_SIZE = 256 };
+    aabb_edge_t edges[CHUNK_SIZE];
+
+    aabb_t bounds = to_fixed_box(field);
+
+    for (size_t first = 0; first < store->count; first += CHUNK_SIZE) {
+        size_t count = store->count - first;
+        if (count > CHUNK_SIZE) {
+            count = CHUNK_SIZE;
+        }
+
+        aabb_columns_t boxes = {&store->x[first], &store->y[first], &store->w[first],
+                                &store->h[first]};
+        aabb_get_beyond_edges(&bounds, &boxes, count, edges);
+
+        for (size_t offset = 0; offset < count; offset++) {
+            entity_behaviour_t *behaviour = &store->behaviour[first + offset];
+            if (edges[offset] && behaviour->out_of_bounds) {
+                behaviour->out_of_bounds(&(entity_t){store, first + offset},
+                                         edges[offset]);
             }
         }
     }
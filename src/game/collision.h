@@ -1,14 +1,56 @@
+#pragma once
+
+#include "alloc.h"
 #include "entity.h"
+#include "jobs/jobs.h"
+
+typedef struct collision_grid_s collision_grid_t;
+
+/**
+ * Initialize a uniform-grid broadphase over `field`, with square cells.
+ *
+ * Entities outside `field` are filed under the nearest border cells, so they are
+ * still tested, just less selectively.
+ *
+ * \param field Area the grid covers.
+ * \param cell_size Cell width and height; roughly the size of a typical entity.
+ * \returns collision_grid_t handle, or NULL if out of memory.
+ * \sa collision_grid_term
+ */
+collision_grid_t *collision_grid_init(aabb_t *field, int cell_size);
+
+/**
+ * Terminate broadphase grid.
+ */
+void collision_grid_term(collision_grid_t *grid);
 
 /**
- * Process collisions between all given entities.
+ * Process collisions between all entities in `store` over a tick of `delta`.
+ *
+ * The grid is rebuilt from where entities travel this tick, and only entities
+ * sharing a cell reach the narrowphase. Each pair is tested once: boxes already
+ * overlapping collide in place; otherwise moving boxes are swept, so fast ones
+ * cannot tunnel through thin ones, and are moved to their point of contact.
+ * Both entities are told about the collision, each in ascending order of the
+ * other's index.
+ *
+ * Entities stopped at a contact have only moved that part of the tick; call
+ * `entity_store_integrate` next to move everything on to its end.
+ *
+ * The broadphase runs a chunk of entities per job on `jobs`, and the pairs it
+ * finds are resolved in the same order on any number of threads.
+ *
+ * Per-tick working memory comes from `scratch`, which must not be reset before
+ * this returns.
+ *
+ * \param jobs Job system, or NULL to do everything on the calling thread.
+ * \returns false if out of memory, in which case nothing was moved or told of
+ *          a collision.
  */
-void collision_process(size_t entity_count,
-                       entity_t *entity_pool[entity_count]);
+bool collision_process(collision_grid_t *grid, entity_store_t *store,
+                       arena_t *scratch, job_system_t *jobs, float delta);
 
 /**
- * Process field-edge collisions for all given entities and field.
+ * Process field-edge collisions for every entity in `store` against `field`.
  */
-void collision_out_of_bounds_process(size_t entity_count,
-                                     entity_t *entity_pool[entity_count],
-                                     aabb_t *field);
+void collision_out_of_bounds_process(entity_store_t *store, aabb_t *field);
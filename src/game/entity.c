@@ -1,40 +1,368 @@
+#include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "aabb.h"
 #include "alloc.h"
 #include "entity.h"
 
+// -----------------------------------------------------------------------------
+// Entity Store
+// -----------------------------------------------------------------------------
+
+#define GENERATION_MASK ((1u << (32 - ENTITY_INDEX_BITS)) - 1)
+
+// Rows each integration job moves; too few for a thread to wait for are moved
+// by the caller alone.
+#define ROWS_PER_JOB 4096
+
+static entity_handle_t make_handle(uint32_t slot, uint32_t generation) {
+    return generation << ENTITY_INDEX_BITS | slot;
+}
+
+static uint32_t get_handle_slot(entity_handle_t handle) {
+    return handle & (ENTITY_CAPACITY_MAX - 1);
+}
+
+static uint32_t get_handle_generation(entity_handle_t handle) {
+    return handle >> ENTITY_INDEX_BITS;
+}
+
+/**
+ * Create an empty entity pool with room for exactly `capacity` entities.
+ *
+ * Everything is allocated here; nothing is allocated per entity.
+ *
+ * \param capacity At most ENTITY_CAPACITY_MAX.
+ * \returns NULL if out of memory or `capacity` is out of range.
+ */
+entity_store_t *entity_store_init(size_t capacity) {
+    if (!capacity || capacity > ENTITY_CAPACITY_MAX) {
+        return NULL;
+    }
+
+    entity_store_t *store = new_clean(1, entity_store_t);
+    if (!store) {
+        return NULL;
+    }
+
+    store->capacity   = capacity;
+    store->x          = new_array(capacity, fixed_t);
+    store->y          = new_array(capacity, fixed_t);
+    store->w          = new_array(capacity, fixed_t);
+    store->h          = new_array(capacity, fixed_t);
+    store->vx         = new_array(capacity, fixed_t);
+    store->vy         = new_array(capacity, fixed_t);
+    store->previous_x = new_array(capacity, fixed_t);
+    store->previous_y = new_array(capacity, fixed_t);
+    store->elapsed    = new_array(capacity, fixed_t);
+    store->behaviour  = new_array(capacity, entity_behaviour_t);
+    store->row_slots  = new_array(capacity, uint32_t);
+    store->slots      = new_array(capacity, entity_slot_t);
+    store->pending    = new_array(capacity, uint32_t);
+
+    if (!store->x || !store->y || !store->w || !store->h || !store->vx || !store->vy ||
+        !store->previous_x || !store->previous_y || !store->elapsed ||
+        !store->behaviour || !store->row_slots || !store->slots || !store->pending) {
+        entity_store_term(store);
+        return NULL;
+    }
+
+    // --- Free list, in slot order, so the first entities get the first slots
+    for (uint32_t slot = 0; slot < capacity; slot++) {
+        store->slots[slot] = (entity_slot_t){1, slot + 1, false};
+    }
+    store->free_slot = 0;
+
+    return store;
+}
+
+/**
+ * Destroy an entity store, and every entity in it.
+ */
+void entity_store_term(entity_store_t *store) {
+    if (!store) {
+        return;
+    }
+
+    // Despawned entities were destroyed already, and have no behaviour left.
+    for (size_t index = 0; index < store->count; index++) {
+        entity_t entity = {store, index};
+        if (store->behaviour[index].destroy) {
+            store->behaviour[index].destroy(&entity);
+        }
+    }
+
+    delete (store->x);
+    delete (store->y);
+    delete (store->w);
+    delete (store->h);
+    delete (store->vx);
+    delete (store->vy);
+    delete (store->previous_x);
+    delete (store->previous_y);
+    delete (store->elapsed);
+    delete (store->behaviour);
+    delete (store->row_slots);
+    delete (store->slots);
+    delete (store->pending);
+    delete (store);
+}
+
 /**
- * Create a new entity.
+ * Copy row `from` over row `to`, keeping its slot pointing at it.
  */
-entity_t *entity_init(void) {
-    entity_t *e = new (entity_t);
-    return e;
+static void move_row(entity_store_t *store, size_t from, size_t to) {
+    store->x[to]          = store->x[from];
+    store->y[to]          = store->y[from];
+    store->w[to]          = store->w[from];
+    store->h[to]          = store->h[from];
+    store->vx[to]         = store->vx[from];
+    store->vy[to]         = store->vy[from];
+    store->previous_x[to] = store->previous_x[from];
+    store->previous_y[to] = store->previous_y[from];
+    store->elapsed[to]    = store->elapsed[from];
+    store->behaviour[to]  = store->behaviour[from];
+    store->row_slots[to]  = store->row_slots[from];
+
+    store->slots[store->row_slots[to]].index = to;
 }
 
 /**
- * Destroy an existing entity.
+ * Free the rows of every entity despawned since the last collection.
+ *
+ * Each freed row is filled from the last row, keeping rows packed, so views
+ * (`entity_t`) taken before this call may no longer refer to the same entity.
+ * Call between ticks; never from inside a sweep over the store.
  */
-void entity_term(entity_t *e) {
-    if (e->destroy)
-        e->destroy(e);
-    free(e);
+void entity_store_collect(entity_store_t *store) {
+    for (size_t pending = 0; pending < store->pending_count; pending++) {
+        uint32_t slot = store->pending[pending];
+        size_t last   = --store->count;
+
+        if (store->slots[slot].index != last) {
+            move_row(store, last, store->slots[slot].index);
+        }
+
+        store->slots[slot].index      = store->free_slot;
+        store->slots[slot].is_pending = false;
+        store->free_slot              = slot;
+    }
+    store->pending_count = 0;
 }
 
 /**
- * Get the velocity of a given entity.
+ * Get the Q16.16 multiplier that turns velocity into displacement over `delta`.
+ *
+ * Anything predicting where entities will be after integration must use it.
+ */
+fixed_t entity_store_get_step(float delta) { return fixed_from_float(delta); }
+
+/**
+ * Get how far `velocity` carries an entity over what is left of a tick of
+ * `step`, once `elapsed` (0..FIXED_ONE) of it has gone by.
+ *
+ * Integration moves entities exactly this far; collision sweeps them along it.
+ */
+fixed_t entity_store_get_displacement(fixed_t velocity, fixed_t step, fixed_t elapsed) {
+    return fixed_mul(fixed_mul(velocity, step), FIXED_ONE - elapsed);
+}
+
+typedef struct {
+    entity_store_t *store;
+    fixed_t step;
+} integration_t;
+
+static void integrate_rows(void *context, size_t first, size_t count) {
+    integration_t *integration = context;
+    fixed_t step               = integration->step;
+    fixed_t *x                 = integration->store->x;
+    fixed_t *y                 = integration->store->y;
+    fixed_t *vx                = integration->store->vx;
+    fixed_t *vy                = integration->store->vy;
+    fixed_t *elapsed           = integration->store->elapsed;
+
+    for (size_t index = first; index < first + count; index++) {
+        x[index] += entity_store_get_displacement(vx[index], step, elapsed[index]);
+        y[index] += entity_store_get_displacement(vy[index], step, elapsed[index]);
+        elapsed[index] = 0;
+    }
+}
+
+/**
+ * Move every entity along its velocity vector for the rest of the tick.
+ *
+ * Entities a collision already moved part of the way, up to their point of
+ * contact, only cover what is left of the tick, at their velocity after the
+ * collision. Every entity then starts the next tick afresh.
+ *
+ * Rows are independent, so they are moved a block at a time on `jobs`, or all
+ * on the calling thread if `jobs` is NULL.
+ */
+void entity_store_integrate(entity_store_t *store, job_system_t *jobs, float delta) {
+    integration_t integration = {store, entity_store_get_step(delta)};
+    job_parallel_for(jobs, integrate_rows, &integration, store->count, ROWS_PER_JOB);
+}
+
+/**
+ * Record every current position as the starting point for interpolation.
+ */
+void entity_store_commit_transforms(entity_store_t *store) {
+    memcpy(store->previous_x, store->x, store->count * sizeof(fixed_t));
+    memcpy(store->previous_y, store->y, store->count * sizeof(fixed_t));
+}
+
+// -----------------------------------------------------------------------------
+// Entity
+// -----------------------------------------------------------------------------
+
+/**
+ * Spawn a new, zeroed entity in `store`.
+ *
+ * \returns ENTITY_HANDLE_NULL if the pool is full.
+ */
+entity_handle_t entity_spawn(entity_store_t *store) {
+    if (store->free_slot == store->capacity) {
+        return ENTITY_HANDLE_NULL;
+    }
+
+    uint32_t slot    = store->free_slot;
+    size_t index     = store->count++;
+    store->free_slot = store->slots[slot].index;
+
+    store->slots[slot].index = index;
+    store->row_slots[index]  = slot;
+    store->x[index]          = 0;
+    store->y[index]          = 0;
+    store->w[index]          = 0;
+    store->h[index]          = 0;
+    store->vx[index]         = 0;
+    store->vy[index]         = 0;
+    store->previous_x[index] = 0;
+    store->previous_y[index] = 0;
+    store->elapsed[index]    = 0;
+    store->behaviour[index]  = (entity_behaviour_t){0};
+
+    return make_handle(slot, store->slots[slot].generation);
+}
+
+/**
+ * Despawn an entity, destroying it now and invalidating every handle to it.
+ *
+ * Its row stays in the store, inert (no behaviour, size or velocity, and
+ * skipped by collision processing), until the next `entity_store_collect`, so
+ * despawning is safe from inside a sweep such as a collision callback.
+ *
+ * \returns `false` if `handle` is stale.
+ */
+bool entity_despawn(entity_store_t *store, entity_handle_t handle) {
+    if (!entity_is_alive(store, handle)) {
+        return false;
+    }
+
+    uint32_t slot                 = get_handle_slot(handle);
+    entity_t entity               = {store, store->slots[slot].index};
+    entity_behaviour_t *behaviour = entity_get_behaviour(&entity);
+    if (behaviour->destroy) {
+        behaviour->destroy(&entity);
+    }
+    *behaviour = (entity_behaviour_t){0};
+
+    size_t index          = entity.index;
+    store->w[index]       = 0;
+    store->h[index]       = 0;
+    store->vx[index]      = 0;
+    store->vy[index]      = 0;
+    store->elapsed[index] = 0;
+
+    // Generation 0 is never used, so no live handle is ever ENTITY_HANDLE_NULL.
+    entity_slot_t *entry = &store->slots[slot];
+    entry->generation    = (entry->generation + 1) & GENERATION_MASK;
+    entry->generation    = entry->generation ? entry->generation : 1;
+    entry->is_pending    = true;
+
+    store->pending[store->pending_count++] = slot;
+    return true;
+}
+
+/**
+ * Check whether `handle` still refers to a spawned entity.
+ */
+bool entity_is_alive(entity_store_t *store, entity_handle_t handle) {
+    uint32_t slot = get_handle_slot(handle);
+    return handle != ENTITY_HANDLE_NULL && slot < store->capacity &&
+           store->slots[slot].generation == get_handle_generation(handle);
+}
+
+/**
+ * Get a view of the entity `handle` refers to.
+ *
+ * \returns `false`, leaving `entity` untouched, if `handle` is stale.
+ */
+bool entity_get(entity_store_t *store, entity_handle_t handle, entity_t *entity) {
+    if (!entity_is_alive(store, handle)) {
+        return false;
+    }
+    *entity = (entity_t){store, store->slots[get_handle_slot(handle)].index};
+    return true;
+}
+
+/**
+ * Get a handle to the entity `entity` views.
+ *
+ * \returns ENTITY_HANDLE_NULL if the entity was despawned.
+ */
+entity_handle_t entity_get_handle(entity_t *e) {
+    entity_slot_t *entry = &e->store->slots[e->store->row_slots[e->index]];
+    if (entry->is_pending) {
+        return ENTITY_HANDLE_NULL;
+    }
+    return make_handle(e->store->row_slots[e->index], entry->generation);
+}
+
+/**
+ * Get the bounding box of a given entity, floored onto whole pixels.
+ */
+void entity_get_transform(entity_t *e, aabb_t *transform) {
+    entity_store_t *s = e->store;
+    transform->x      = fixed_to_int(s->x[e->index]);
+    transform->y      = fixed_to_int(s->y[e->index]);
+    transform->w      = fixed_to_int(s->w[e->index]);
+    transform->h      = fixed_to_int(s->h[e->index]);
+}
+
+/**
+ * Set the bounding box of a given entity, in whole pixels.
+ */
+void entity_set_transform(entity_t *e, aabb_t *transform) {
+    entity_store_t *s = e->store;
+    s->x[e->index]    = fixed_from_int(transform->x);
+    s->y[e->index]    = fixed_from_int(transform->y);
+    s->w[e->index]    = fixed_from_int(transform->w);
+    s->h[e->index]    = fixed_from_int(transform->h);
+}
+
+/**
+ * Get the behaviour (callbacks and data) of a given entity.
+ */
+entity_behaviour_t *entity_get_behaviour(entity_t *e) {
+    return &e->store->behaviour[e->index];
+}
+
+/**
+ * Get the velocity of a given entity, in whole pixels per second.
  */
 void entity_get_velocity(entity_t *e, int *vx, int *vy) {
-    *vx = e->vx;
-    *vy = e->vy;
+    *vx = fixed_to_int(e->store->vx[e->index]);
+    *vy = fixed_to_int(e->store->vy[e->index]);
 }
 
 /**
- * Set the velocity of a given entity.
+ * Set the velocity of a given entity, in whole pixels per second.
  */
 void entity_set_velocity(entity_t *e, int vx, int vy) {
-    e->vx = vx;
-    e->vy = vy;
+    e->store->vx[e->index] = fixed_from_int(vx);
+    e->store->vy[e->index] = fixed_from_int(vy);
 }
 
 /**
@@ -43,20 +371,54 @@ void entity_set_velocity(entity_t *e, int vx, int vy) {
  * Can be composed to "bounce" and entity off of something.
  */
 void entity_set_direction(entity_t *e, direction_t dir) {
+    fixed_t *vx = &e->store->vx[e->index];
+    fixed_t *vy = &e->store->vy[e->index];
+
     switch (dir) {
     case DIR_LEFT:
-        e->vx = -abs(e->vx);
+        *vx = -abs(*vx);
         break;
     case DIR_UP:
-        e->vy = -abs(e->vy);
+        *vy = -abs(*vy);
         break;
     case DIR_RIGHT:
-        e->vx = abs(e->vx);
+        *vx = abs(*vx);
         break;
     case DIR_DOWN:
-        e->vy = abs(e->vy);
+        *vy = abs(*vy);
         break;
     default:
         break;
     }
 }
+
+/**
+ * Record the current transform as the starting point for interpolation.
+ *
+ * Called after any teleport so the entity does not visibly streak across the
+ * field; `entity_store_commit_transforms` does the same for everything at the
+ * start of every tick.
+ */
+void entity_commit_transform(entity_t *e) {
+    entity_store_t *s       = e->store;
+    s->previous_x[e->index] = s->x[e->index];
+    s->previous_y[e->index] = s->y[e->index];
+}
+
+/**
+ * Get the transform `alpha` (0..1) of the way from the previous to current tick.
+ *
+ * Kept sub-pixel, for drawing only.
+ */
+void entity_get_interpolated_transform(entity_t *e, float alpha, faabb_t *transform) {
+    entity_store_t *s = e->store;
+    float from_x      = fixed_to_float(s->previous_x[e->index]);
+    float from_y      = fixed_to_float(s->previous_y[e->index]);
+    float to_x        = fixed_to_float(s->x[e->index]);
+    float to_y        = fixed_to_float(s->y[e->index]);
+
+    transform->x = from_x + (to_x - from_x) * alpha;
+    transform->y = from_y + (to_y - from_y) * alpha;
+    transform->w = fixed_to_float(s->w[e->index]);
+    transform->h = fixed_to_float(s->h[e->index]);
+}
@@ -1,27 +1,120 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #include "aabb.h"
+#include "fixed.h"
+#include "jobs/jobs.h"
 
 typedef enum { DIR_LEFT, DIR_UP, DIR_RIGHT, DIR_DOWN } direction_t;
 
+typedef struct entity_store_s entity_store_t;
+
+/**
+ * Generational entity handle: slot in the low `ENTITY_INDEX_BITS` bits, the
+ * slot's generation above them.
+ *
+ * Despawning bumps the slot's generation, so handles to a despawned entity are
+ * detected as stale even after the slot is reused (until the generation wraps,
+ * 4095 reuses later).
+ */
+typedef uint32_t entity_handle_t;
+
+#define ENTITY_HANDLE_NULL  0
+#define ENTITY_INDEX_BITS   20
+#define ENTITY_CAPACITY_MAX ((size_t)1 << ENTITY_INDEX_BITS)
+
+/**
+ * View of one entity (row) in an entity store.
+ *
+ * Cheap to copy, but only valid until the next `entity_store_collect`, which
+ * may move rows; hold an `entity_handle_t` for anything longer.
+ */
 typedef struct entity_s {
-  aabb_t transform;
-  int vx;
-  int vy;
-  void (*update)(struct entity_s *self, float delta);
-  void (*destroy)(struct entity_s *self);
-  void (*collide)(struct entity_s *self, struct entity_s *collider,
-                  aabb_edge_t edge);
-  void (*out_of_bounds)(struct entity_s *self, aabb_edge_t edge);
-  void *data;
+  entity_store_t *store;
+  size_t index;
 } entity_t;
 
-entity_t *entity_init(void);
-void entity_term(entity_t *entity);
+/** Per-entity behaviour; only touched when something happens to the entity. */
+typedef struct {
+  void (*destroy)(entity_t *self);
+  void (*collide)(entity_t *self, entity_t *collider, aabb_edge_t edge);
+  void (*out_of_bounds)(entity_t *self, aabb_edge_t edge);
+  void *data;
+} entity_behaviour_t;
+
+/**
+ * Pool slot: where a handle's entity lives, or the next free slot.
+ */
+typedef struct {
+  uint32_t generation;
+  uint32_t index;  // Row while spawned (or pending); next free slot otherwise.
+  bool is_pending; // Despawned, but its row is not collected yet.
+} entity_slot_t;
+
+/**
+ * Fixed-capacity, structure-of-arrays entity pool.
+ *
+ * Everything swept every tick lives in parallel arrays indexed by row, packed
+ * into [0, count); behaviour lives in a separate cold table. Positions and
+ * sizes are Q16.16 pixels, velocities Q16.16 pixels per second.
+ *
+ * Handles reach rows through a slot table with a free list, so spawning and
+ * despawning never allocate.
+ */
+struct entity_store_s {
+  size_t count;
+  size_t capacity;
+
+  // --- Hot
+  fixed_t *x;
+  fixed_t *y;
+  fixed_t *w;
+  fixed_t *h;
+  fixed_t *vx;
+  fixed_t *vy;
+  fixed_t *previous_x; // Position at the start of the current tick.
+  fixed_t *previous_y;
+  fixed_t *elapsed; // Part of the current tick (Q16.16) moved through by collisions.
+
+  // --- Cold
+  entity_behaviour_t *behaviour;
+
+  // --- Pool
+  uint32_t *row_slots; // Slot of each row.
+  entity_slot_t *slots;
+  uint32_t free_slot; // Head of the free list; `capacity` when the pool is full.
+  uint32_t *pending;  // Despawned slots whose rows `entity_store_collect` frees.
+  size_t pending_count;
+};
+
+entity_store_t *entity_store_init(size_t capacity);
+void entity_store_term(entity_store_t *store);
+void entity_store_collect(entity_store_t *store);
+
+fixed_t entity_store_get_step(float delta);
+fixed_t entity_store_get_displacement(fixed_t velocity, fixed_t step, fixed_t elapsed);
+void entity_store_integrate(entity_store_t *store, job_system_t *jobs, float delta);
+void entity_store_commit_transforms(entity_store_t *store);
+
+entity_handle_t entity_spawn(entity_store_t *store);
+bool entity_despawn(entity_store_t *store, entity_handle_t handle);
+bool entity_is_alive(entity_store_t *store, entity_handle_t handle);
+bool entity_get(entity_store_t *store, entity_handle_t handle, entity_t *entity);
+entity_handle_t entity_get_handle(entity_t *entity);
+
+void entity_get_transform(entity_t *entity, aabb_t *transform);
+void entity_set_transform(entity_t *entity, aabb_t *transform);
+
+entity_behaviour_t *entity_get_behaviour(entity_t *entity);
 
 void entity_get_velocity(entity_t *entity, int *vx, int *vy);
 void entity_set_velocity(entity_t *entity, int vx, int vy);
 
 void entity_set_direction(entity_t *e, direction_t dir);
+
+void entity_commit_transform(entity_t *entity);
+void entity_get_interpolated_transform(entity_t *entity, float alpha,
+                                       faabb_t *transform);
@@ -2,6 +2,8 @@
 
 #include <log.h>
 #include <stddef.h>
+#include <string.h>
+#include <time.h>
 
 #include "SDL_events.h"
 #include "SDL_scancode.h"
@@ -12,14 +14,15 @@
 #include "aabb.h"
 #include "actions.h"
 #include "alloc.h"
-#include "ball.h"
-#include "collision.h"
 #include "entity.h"
-#include "field.h"
-#include "fsm/fsm.h"
 #include "game.h"
-#include "paddle.h"
+#include "jobs/jobs.h"
+#include "match.h"
+#include "net/link.h"
 #include "player.h"
+#include "profile/profile.h"
+#include "replay.h"
+#include "rollback.h"
 
 // -----------------------------------------------------------------------------
 // Core Data Types
@@ -30,21 +33,27 @@
  */
 typedef struct game_s {
     app_t *app;
+    arena_t *arena;     // Game lifetime; holds the game itself.
+    job_system_t *jobs; // Shared by every tick of the match.
 } game_t;
 
 // -----------------------------------------------------------------------------
 // Game Components
 // -----------------------------------------------------------------------------
 
-static player_t player_1     = {0}; // Players do not need configuration.
-static player_t player_2     = {0}; // Just init to zero and away we go!
-static entity_t ball         = {0};
-static entity_t left_paddle  = {0};
-static entity_t right_paddle = {0};
-static aabb_t field          = {0};
+// The match being played and shown
+static match_t *match = NULL;
 
-static size_t const entity_count = 3;
-static entity_t *entity_pool[3]  = {&ball, &left_paddle, &right_paddle};
+// Records the match's input, if asked to
+static replay_recorder_t *recorder = NULL;
+
+// Against a peer: the link to it, and the session that owns the match
+static link_t *peer_link      = NULL;
+static rollback_t *session    = NULL;
+static bool is_quit_requested = false; // Sent to the peer as input.
+
+// Game Arena (game instance)
+static size_t const game_arena_size = 1024;
 
 // Input Configuration
 static action_table_cfg_t action_table_config = {
@@ -54,438 +63,622 @@ static action_table_cfg_t action_table_config = {
     [P2_UP] = SDL_SCANCODE_K,        [P2_DOWN] = SDL_SCANCODE_M,
     [CONFIRM] = SDL_SCANCODE_RETURN, [CANCEL] = SDL_SCANCODE_ESCAPE,
     [PAUSE] = SDL_SCANCODE_P,        [QUIT] = SDL_SCANCODE_Q,
+    [PROFILE] = SDL_SCANCODE_F9,
 };
 
 // Action Table (Input Map Instance)
 static action_table_t *action_table;
 
-// State Machine Handle
-fsm_t *fsm;
-
-// State Options
-enum game_state_enum {
-    STATE_GUARD,
-    START_STATE,
-    RESET_STATE,
-    COUNTDOWN_STATE,
-    FIELD_SETUP_STATE,
-    PLAYING_STATE,
-    PAUSE_STATE,
-    GAME_OVER_STATE,
-    TERM_STATE,
-    STATE_COUNT,
-};
+// -----------------------------------------------------------------------------
+// Frame Snapshots
+// -----------------------------------------------------------------------------
 
-// Trigger Options
-enum game_trigger_enum {
-    INIT_DONE_TRIGGER,
-    QUIT_GAME_TRIGGER,
-    GAME_OVER_TRIGGER,
-    NEXT_TRIGGER,
-    PAUSE_TRIGGER,
-    CONFIRM_TRIGGER,
-    CANCEL_TRIGGER,
-    TRIGGER_COUNT,
-};
+/** Entities frames draw, in the order snapshots keep them. */
+enum { SHOWN_BALL, SHOWN_LEFT_PADDLE, SHOWN_RIGHT_PADDLE, SHOWN_COUNT };
 
 /**
- * Configure game-state transition table.
+ * Everything a frame draws, as the latest tick left it. Frames draw from this
+ * alone, so ticks can run on a thread of their own meanwhile.
  */
-static void configure_fsm(void) {
-    fsm = fsm_init(STATE_COUNT, TRIGGER_COUNT, START_STATE);
-
-    // Start
-    fsm_on(fsm, START_STATE, CONFIRM_TRIGGER, FIELD_SETUP_STATE);
-    fsm_on(fsm, START_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
-
-    // Reset
-    fsm_on(fsm, RESET_STATE, NEXT_TRIGGER, FIELD_SETUP_STATE);
-    fsm_on(fsm, RESET_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
-
-    // Field Setup
-    fsm_on(fsm, FIELD_SETUP_STATE, NEXT_TRIGGER, COUNTDOWN_STATE);
-    fsm_on(fsm, FIELD_SETUP_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
-
-    // Countdown
-    fsm_on(fsm, COUNTDOWN_STATE, NEXT_TRIGGER, PLAYING_STATE);
-    fsm_on(fsm, COUNTDOWN_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
-
-    // Playing
-    fsm_on(fsm, PLAYING_STATE, PAUSE_TRIGGER, PAUSE_STATE);
-    fsm_on(fsm, PLAYING_STATE, NEXT_TRIGGER, FIELD_SETUP_STATE);
-    fsm_on(fsm, PLAYING_STATE, GAME_OVER_TRIGGER, GAME_OVER_STATE);
-    fsm_on(fsm, PLAYING_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
-
-    // Pause State
-    fsm_on(fsm, PAUSE_STATE, PAUSE_TRIGGER, PLAYING_STATE);
-    fsm_on(fsm, PAUSE_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
-
-    // Game Over
-    fsm_on(fsm, GAME_OVER_STATE, CONFIRM_TRIGGER, RESET_STATE);
-    fsm_on(fsm, GAME_OVER_STATE, CANCEL_TRIGGER, TERM_STATE);
-    fsm_on(fsm, GAME_OVER_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
-
-    // Terminating (Loop-back only)
-    fsm_on(fsm, TERM_STATE, NEXT_TRIGGER, TERM_STATE);
-}
+typedef struct {
+    bool has_match; // None yet, while waiting for the peer.
+    match_state_t state;
+    aabb_t field;
+    unsigned short score_1;
+    unsigned short score_2;
+    unsigned char countdown;   // Seconds left to count down.
+    float pulse_alpha;         // Opacity of the state's flashing text.
+    faabb_t from[SHOWN_COUNT]; // Entity transforms as of the previous tick,
+    faabb_t to[SHOWN_COUNT];   // and as of this one.
+} frame_snapshot_t;
+
+// -----------------------------------------------------------------------------
+// Retained Text
+// -----------------------------------------------------------------------------
+
+/** Score text, re-formatted only when the score it shows changes. */
+typedef struct {
+    video_text_t *text;
+    int score;
+} score_label_t;
+
+static score_label_t p1_score_label = {0};
+static score_label_t p2_score_label = {0};
+
+static video_text_t *start_text     = NULL;
+static video_text_t *countdown_text = NULL;
+static video_text_t *pause_text     = NULL;
+static video_text_t *game_over_text = NULL;
+static video_text_t *waiting_text   = NULL;
 
 /**
- * Draw all entities of given game instance.
+ * Draw the snapshot's entities from `first` on, `alpha` of the way into the
+ * tick.
  */
-static void draw_entities(video_t *video, size_t entity_count,
-                          entity_t *entity_pool[entity_count]) {
+static void draw_entities(video_t *video, frame_snapshot_t const *snapshot, int first,
+                          float alpha) {
     video_set_color(video, 255, 255, 255, 255);
-    for (size_t entity_num = 0; entity_num < entity_count; entity_num++) {
-        entity_t *e = entity_pool[entity_num];
-        video_draw_region(video, &e->transform);
+    for (int index = first; index < SHOWN_COUNT; index++) {
+        faabb_t const *from = &snapshot->from[index];
+        faabb_t const *to   = &snapshot->to[index];
+        faabb_t transform   = {
+            .x = from->x + (to->x - from->x) * alpha,
+            .y = from->y + (to->y - from->y) * alpha,
+            .w = to->w,
+            .h = to->h,
+        };
+        video_draw_region_f(video, &transform);
     }
 }
 
-static void draw_scores(video_t *video) {
+static void score_label_update(video_t *video, score_label_t *label,
+                               unsigned short score) {
     static uint8_t SCORE_STRING_LENGTH = 5; // 5 digits + sentinel
-    char p1_score_str[SCORE_STRING_LENGTH + 1];
-    char p2_score_str[SCORE_STRING_LENGTH + 1];
+
+    if (label->score == score) {
+        return;
+    }
 
     // TODO: Abstract into itoa-like func for players
-    snprintf(p1_score_str, SCORE_STRING_LENGTH, "%hu", player_get_score(&player_1));
-    snprintf(p2_score_str, SCORE_STRING_LENGTH, "%hu", player_get_score(&player_2));
+    char score_str[SCORE_STRING_LENGTH + 1];
+    snprintf(score_str, SCORE_STRING_LENGTH, "%hu", score);
+    video_text_set_string(video, label->text, score_str);
+    label->score = score;
+}
+
+static void draw_scores(video_t *video, frame_snapshot_t const *snapshot) {
+    aabb_t const *field = &snapshot->field;
+
+    score_label_update(video, &p1_score_label, snapshot->score_1);
+    score_label_update(video, &p2_score_label, snapshot->score_2);
 
-    video_draw_text(video, p1_score_str, (field.x + field.w) / 2 - 48, 16);
-    video_draw_text(video, p2_score_str, (field.x + field.w) / 2 + 48, 16);
+    video_text_draw(video, p1_score_label.text, (field->x + field->w) / 2 - 48, 16);
+    video_text_draw(video, p2_score_label.text, (field->x + field->w) / 2 + 48, 16);
 }
 
-static void draw_dimmer(video_t *video) {
+static void draw_dimmer(video_t *video, frame_snapshot_t const *snapshot) {
+    aabb_t field = snapshot->field;
     video_set_color(video, 0, 0, 0, 160);
     video_draw_region(video, &field);
 }
 
-static void check_goal_conditions(void) {
+static void draw_centered_text(video_t *video, frame_snapshot_t const *snapshot,
+                               video_text_t *text) {
+    aabb_t const *field = &snapshot->field;
+    video_text_draw(video, text, field->x + (field->w / 2), field->y + (field->h / 2));
+}
 
-    static unsigned char const winning_score = 5;
+// -----------------------------------------------------------------------------
+// Cached Layers
+// -----------------------------------------------------------------------------
 
-    // Is the ball in the left goal?
-    if (field_is_subject_in_left_goal(&field, &ball.transform)) {
-        // player 2 gets the point
-        player_inc_score(&player_2);
-        // Did player 2 win?
-        if (player_get_score(&player_2) >= winning_score) {
-            fsm_trigger(fsm, GAME_OVER_TRIGGER);
-        } else {
-            fsm_trigger(fsm, NEXT_TRIGGER);
+/** What the dimmed scene was last drawn from. */
+typedef struct {
+    match_state_t state;
+    unsigned short score_1;
+    unsigned short score_2;
+    faabb_t shown[SHOWN_COUNT];
+} dimmed_scene_t;
+
+// The scene under the text of dimmed states, drawn once while it stands still
+static video_layer_t *dimmed_layer = NULL;
+static dimmed_scene_t dimmed_scene = {0};
+
+static bool is_same_scene(dimmed_scene_t const *a, dimmed_scene_t const *b) {
+    if (a->state != b->state || a->score_1 != b->score_1 || a->score_2 != b->score_2) {
+        return false;
+    }
+    for (int index = 0; index < SHOWN_COUNT; index++) {
+        faabb_t const *rect_a = &a->shown[index];
+        faabb_t const *rect_b = &b->shown[index];
+        if (rect_a->x != rect_b->x || rect_a->y != rect_b->y ||
+            rect_a->w != rect_b->w || rect_a->h != rect_b->h) {
+            return false;
         }
     }
+    return true;
+}
+
+/**
+ * Draw the dimmed scene under a state's text: entities from `first` on, scores
+ * if asked for, and the dimmer over the field.
+ *
+ * Nothing moves in dimmed states, so the scene is drawn into a layer and only
+ * copied after that, until the snapshot shows something different. Entities
+ * are drawn where the latest tick left them.
+ */
+static void draw_dimmed_scene(video_t *video, frame_snapshot_t const *snapshot,
+                              int first, bool has_scores) {
+    dimmed_scene_t scene = {
+        .state   = snapshot->state,
+        .score_1 = snapshot->score_1,
+        .score_2 = snapshot->score_2,
+    };
+    memcpy(scene.shown, snapshot->to, sizeof scene.shown);
+    if (!is_same_scene(&scene, &dimmed_scene)) {
+        video_layer_invalidate(dimmed_layer);
+        dimmed_scene = scene;
+    }
 
-    // Is the ball in the right goal?
-    else if (field_is_subject_in_right_goal(&field, &ball.transform)) {
-        // player 1 gets the point
-        player_inc_score(&player_1);
-        // Did player 1 win?
-        if (player_get_score(&player_1) >= winning_score) {
-            fsm_trigger(fsm, GAME_OVER_TRIGGER);
-        } else {
-            fsm_trigger(fsm, NEXT_TRIGGER);
+    if (video_layer_begin(video, dimmed_layer)) {
+        draw_entities(video, snapshot, first, 1.0f);
+        if (has_scores) {
+            draw_scores(video, snapshot);
         }
+        draw_dimmer(video, snapshot);
+        video_layer_end(video, dimmed_layer);
     }
+    video_layer_draw(video, dimmed_layer);
 }
 
-static void handle_player_actions(void) {
-    // --- Input
-    bool *actions = action_table_get_binary_states(action_table);
+// -----------------------------------------------------------------------------
+// State Actors
+// -----------------------------------------------------------------------------
+
+/** Flashing text opacity, bouncing between two bounds. */
+typedef struct {
+    float alpha;
+    float direction;
+} pulse_t;
+
+static pulse_t start_pulse     = {100, 301};
+static pulse_t pause_pulse     = {100, 301};
+static pulse_t game_over_pulse = {100, 301};
 
-    bool p1_up   = actions[P1_UP];
-    bool p1_down = actions[P1_DOWN];
-    bool p2_up   = actions[P2_UP];
-    bool p2_down = actions[P2_DOWN];
+static void pulse_update(pulse_t *pulse, float delta) {
+    static float const speed = 301;
 
-    entity_set_velocity(&left_paddle, 0, (p1_down - p1_up) * 400);
-    entity_set_velocity(&right_paddle, 0, (p2_down - p2_up) * 400);
+    // Bounce Effect
+    if (pulse->alpha <= 60) {
+        pulse->direction = speed;
+    } else if (pulse->alpha >= 236) {
+        pulse->direction = -speed;
+    }
+    // Animation Driver
+    pulse->alpha += pulse->direction * delta;
+    pulse->alpha = SDL_clamp(pulse->alpha, 0, 255);
 }
 
 // -----------------------------------------------------------------------------
-// Core Processing Blocks
+// Core Drawing Blocks
 // -----------------------------------------------------------------------------
 
 /**
- * Place the ball and transition
+ * Draw a frame of one state from `snapshot`, `alpha` of the way into its tick.
  */
-static void do_field_setup_state(app_t *app, float delta) {
-    (void)app;
-    (void)delta;
-    ball_configure(&ball, &field);
-    fsm_trigger(fsm, NEXT_TRIGGER);
+typedef void (*state_draw_t)(video_t *video, frame_snapshot_t const *snapshot,
+                             float alpha);
+
+static void draw_countdown_state(video_t *video, frame_snapshot_t const *snapshot,
+                                 float alpha) {
+    static char map[4][4] = {"GO!", "1", "2", "3"};
+
+    (void)alpha;
+    video_clear(video);
+    draw_dimmed_scene(video, snapshot, SHOWN_LEFT_PADDLE, true);
+    video_text_set_string(video, countdown_text, map[snapshot->countdown]);
+    draw_centered_text(video, snapshot, countdown_text);
+    video_render(video);
 }
 
-/**
- * Count down from 3 to 0.
- */
-static void do_countdown_state(app_t *app, float delta) {
-    (void)delta;
-
-    // --- State Actors
-    static bool is_active                = false;
-    static unsigned long long prev_ticks = 0;
-    static unsigned long long curr_ticks = 0;
-
-    static unsigned char counter = 3;
-    static char map[4][4]        = {"GO!", "1", "2", "3"};
-
-    // --- Animation Update
-    curr_ticks = SDL_GetTicks64();
-
-    if (!is_active) {
-        prev_ticks = SDL_GetTicks64();
-        is_active  = true;
-    }
-
-    if (curr_ticks - prev_ticks >= 600) {
-        prev_ticks = curr_ticks;
-        if (counter == 0) {
-            counter   = 3;
-            is_active = false;
-            fsm_trigger(fsm, NEXT_TRIGGER);
-            return;
-        } else {
-            counter -= 1;
-        }
-    }
+static void draw_playing_state(video_t *video, frame_snapshot_t const *snapshot,
+                               float alpha) {
+    video_clear(video);
+    draw_entities(video, snapshot, SHOWN_BALL, alpha);
+    draw_scores(video, snapshot);
+    video_render(video);
+}
 
-    // --- Rendering
-    video_clear(app->video);
-    draw_scores(app->video);
-    draw_entities(app->video, 2, (entity_t *[2]){&left_paddle, &right_paddle});
-    draw_dimmer(app->video);
-    video_draw_text_with_color(app->video, map[counter], field.x + (field.w / 2),
-                               field.y + (field.h / 2), 255, 255, 255, 240);
-    video_render(app->video);
+static void draw_start_state(video_t *video, frame_snapshot_t const *snapshot,
+                             float alpha) {
+    (void)alpha;
+    video_clear(video);
+    video_text_set_color(start_text, 255, 255, 255, snapshot->pulse_alpha);
+    draw_centered_text(video, snapshot, start_text);
+    video_render(video);
 }
 
-/**
- * Processing block when STATE == PLAYING
- */
-static void do_playing_state(app_t *app, float delta) {
+static void draw_pause_state(video_t *video, frame_snapshot_t const *snapshot,
+                             float alpha) {
+    (void)alpha;
+    // Clear Renderer
+    video_clear(video);
+    // Entities, Scores and Shaded Field Blend
+    draw_dimmed_scene(video, snapshot, SHOWN_BALL, true);
+    // Draw Flashing Pause Text
+    video_text_set_color(pause_text, 255, 255, 255, snapshot->pulse_alpha);
+    draw_centered_text(video, snapshot, pause_text);
 
-    // --- Input
-    handle_player_actions();
+    // Finalize
+    video_render(video);
+}
 
-    // --- Update
+static void draw_waiting(video_t *video) {
+    int width, height;
+    video_get_window_size(video, &width, &height);
+    video_clear(video);
+    video_text_draw(video, waiting_text, width / 2, height / 2);
+    video_render(video);
+}
 
-    // Collision
-    collision_process(entity_count, entity_pool);
-    collision_out_of_bounds_process(entity_count, entity_pool, &field);
+static void draw_game_over_state(video_t *video, frame_snapshot_t const *snapshot,
+                                 float alpha) {
+    (void)alpha;
+    video_clear(video);
 
-    // Entity Updates
-    for (size_t entity_index = 0; entity_index < entity_count; entity_index++) {
-        entity_t *e = entity_pool[entity_index];
-        e->update(e, delta);
-    }
+    draw_dimmed_scene(video, snapshot, SHOWN_LEFT_PADDLE, false);
+    video_text_set_color(game_over_text, 255, 255, 255, snapshot->pulse_alpha);
+    draw_centered_text(video, snapshot, game_over_text);
+    video_render(video);
+}
 
-    // Goal Polling
-    check_goal_conditions();
+// Per-state presentation. Transient states are never current between ticks.
 
-    // --- Output
-    video_clear(app->video);
-    draw_entities(app->video, 3, (entity_t *[3]){&ball, &left_paddle, &right_paddle});
-    draw_scores(app->video);
-    video_render(app->video);
-}
+static pulse_t *const state_pulses[STATE_COUNT] = {
+    [START_STATE]     = &start_pulse,
+    [PAUSE_STATE]     = &pause_pulse,
+    [GAME_OVER_STATE] = &game_over_pulse,
+};
 
-void do_start_state(app_t *app, float delta) {
+static state_draw_t const state_draws[STATE_COUNT] = {
+    [START_STATE]     = draw_start_state,
+    [COUNTDOWN_STATE] = draw_countdown_state,
+    [PLAYING_STATE]   = draw_playing_state,
+    [PAUSE_STATE]     = draw_pause_state,
+    [GAME_OVER_STATE] = draw_game_over_state,
+};
 
-    // --- State Actors
-    static unsigned short const speed = 301;
-    static unsigned char alpha        = 100;
-    static float alpha_direction      = speed;
+// -----------------------------------------------------------------------------
+// Game-App Infrastructure
+// -----------------------------------------------------------------------------
 
-    // --- Animation Update
-    // Bounce Effect
-    if (alpha <= 60) {
-        alpha_direction = speed;
-    } else if (alpha >= 236) {
-        alpha_direction = -speed;
+/**
+ * Stop the app once the match has terminated.
+ */
+static void stop_when_terminated(app_t *app) {
+    // Against a peer, the session decides when the match is over.
+    if (session || match_get_state(match) != TERM_STATE) {
+        return;
     }
-    // Animation Driver
-    alpha += alpha_direction * delta;
 
-    // --- Rendering
-    video_clear(app->video);
-    video_draw_text_with_color(app->video, "Press Enter", field.x + (field.w / 2),
-                               field.y + (field.h / 2), 255, 255, 255, alpha);
-    video_render(app->video);
+    // A headless run simulates exactly one match.
+    if (app->is_headless) {
+        log_info("Match over: %hu - %hu", player_get_score(&match->player_1),
+                 player_get_score(&match->player_2));
+    }
+    app_stop(app);
 }
 
-static void do_reset_state(app_t *app, float delta) {
+/**
+ * Fire `trigger` at the match on the player's behalf, recording it first.
+ */
+static void fire_trigger(match_trigger_t trigger) {
+    // Against a peer, the match only changes on input both peers simulate, and
+    // quitting is the only trigger shared that way.
+    if (session) {
+        is_quit_requested |= trigger == QUIT_GAME_TRIGGER;
+        return;
+    }
+    if (recorder) {
+        replay_record_trigger(recorder, match, trigger);
+    }
+    match_trigger(match, trigger);
+}
+
+/**
+ * Handle incoming game events one at a time.
+ *
+ * Keys are not among them: each tick takes those itself (see take_actions).
+ */
+static void handle_event(app_t *app, SDL_Event *event) {
     (void)app;
-    (void)delta;
-    player_1.score = 0;
-    player_2.score = 0;
-    fsm_trigger(fsm, NEXT_TRIGGER);
+
+    // Some renderers lose what was drawn into textures.
+    if (event->type == SDL_RENDER_TARGETS_RESET) {
+        video_layer_invalidate(dimmed_layer);
+    }
 }
 
-static void do_pause_state(app_t *app, float delta) {
+/**
+ * Take what the keys did up to the time this tick simulates, so presses land on
+ * the tick they happened in, and fire the triggers pressed.
+ */
+static void take_actions(app_t *app, action_states_t *actions) {
+    // Ticking apart from frames, keys are pumped by frames; see handle_frame.
+    if (!app->is_sim_threaded) {
+        action_table_pump(action_table);
+    }
+    action_table_advance(action_table, app->tick_time, actions);
 
-    // --- State Actors
-    static unsigned short const speed = 301;
-    static unsigned char alpha        = 100;
-    static float alpha_direction      = speed;
+    if (actions->pressed[CONFIRM]) {
+        fire_trigger(CONFIRM_TRIGGER);
+    }
+    if (actions->pressed[PAUSE]) {
+        fire_trigger(PAUSE_TRIGGER);
+    }
+    if (actions->pressed[QUIT]) {
+        fire_trigger(QUIT_GAME_TRIGGER);
+    }
+    if (actions->pressed[PROFILE]) {
+        profile_set_enabled(!profile_is_enabled());
+        log_info("Profiling %s", profile_is_enabled() ? "on" : "off");
+    }
+}
 
-    // --- Animation Update
-    // Bounce Effect
-    if (alpha <= 60) {
-        alpha_direction = speed;
-    } else if (alpha >= 236) {
-        alpha_direction = -speed;
+/**
+ * Leave what the match looks like after this tick for frames to draw.
+ */
+static void publish_snapshot(app_t *app) {
+    frame_snapshot_t *snapshot = app_get_tick_snapshot(app);
+    if (!snapshot || !(snapshot->has_match = match != NULL)) {
+        return;
     }
-    // Animation Driver
-    alpha += alpha_direction * delta;
+    match_state_t const state = match_get_state(match);
+    pulse_t const *pulse      = state_pulses[state];
+
+    snapshot->state       = state;
+    snapshot->field       = match->field;
+    snapshot->score_1     = player_get_score(&match->player_1);
+    snapshot->score_2     = player_get_score(&match->player_2);
+    snapshot->countdown   = match->countdown.counter;
+    snapshot->pulse_alpha = pulse ? pulse->alpha : 255;
+
+    entity_handle_t const shown[SHOWN_COUNT] = {
+        [SHOWN_BALL]         = match->ball,
+        [SHOWN_LEFT_PADDLE]  = match->left_paddle,
+        [SHOWN_RIGHT_PADDLE] = match->right_paddle,
+    };
+    for (int index = 0; index < SHOWN_COUNT; index++) {
+        entity_t entity = match_get_entity(match, shown[index]);
+        entity_get_interpolated_transform(&entity, 0, &snapshot->from[index]);
+        entity_get_interpolated_transform(&entity, 1, &snapshot->to[index]);
+    }
+}
 
-    // --- Extra Rendering
-    // --- Rendering
-    // Clear Renderer
-    video_clear(app->video);
-    // Entities
-    draw_entities(app->video, 3, (entity_t *[3]){&ball, &left_paddle, &right_paddle});
-    draw_scores(app->video);
-    // Shaded Field Blend
-    draw_dimmer(app->video);
-    // Draw Flashing Pause Text
-    video_draw_text_with_color(app->video, "Paused", field.x + (field.w / 2),
-                               field.y + (field.h / 2), 255, 255, 255, alpha);
+/**
+ * Execute one simulation step against the peer, on both players' keys.
+ */
+static void handle_session_tick(app_t *app, float delta) {
+    action_states_t actions;
+    take_actions(app, &actions);
+
+    bool const *held = actions.held;
+    unsigned input   = is_quit_requested ? ROLLBACK_QUIT : 0;
+    if (held[P1_UP] || held[P2_UP]) {
+        input |= ROLLBACK_UP;
+    }
+    if (held[P1_DOWN] || held[P2_DOWN]) {
+        input |= ROLLBACK_DOWN;
+    }
 
-    // Finalize
-    video_render(app->video);
+    rollback_status_t status = rollback_tick(session, input, SDL_GetTicks64());
+    if ((match = rollback_get_match(session))) {
+        profile_set_tag(match_get_state_name(match_get_state(match)));
+        pulse_t *pulse = state_pulses[match_get_state(match)];
+        if (pulse) {
+            pulse_update(pulse, delta);
+        }
+    }
+    publish_snapshot(app);
+
+    if (status == ROLLBACK_FINISHED || status == ROLLBACK_DISCONNECTED) {
+        rollback_stats_t stats;
+        rollback_get_stats(session, &stats);
+        log_info("Match %s: %hu - %hu; %lu rollbacks (%lu ticks, at most %lu), "
+                 "%lu ticks guessed, %lu waited",
+                 status == ROLLBACK_FINISHED ? "over" : "abandoned",
+                 player_get_score(&match->player_1),
+                 player_get_score(&match->player_2), stats.rollback_count,
+                 stats.resimulated, stats.max_depth, stats.predicted_ticks,
+                 stats.stall_count);
+        app_stop(app);
+    }
 }
 
-void do_game_over_state(app_t *app, float delta) {
-    // --- State Actors
-    static unsigned short const speed = 301;
-    static unsigned char alpha        = 100;
-    static float alpha_direction      = speed;
+/**
+ * Execute one simulation step of the current game state.
+ */
+static void handle_tick(app_t *app, float delta) {
+    if (session) {
+        handle_session_tick(app, delta);
+        return;
+    }
 
-    // --- Animation Update
-    // Bounce Effect
-    if (alpha <= 60) {
-        alpha_direction = speed;
-    } else if (alpha >= 236) {
-        alpha_direction = -speed;
+    profile_set_tag(match_get_state_name(match_get_state(match)));
+
+    action_states_t actions;
+    take_actions(app, &actions);
+    if (recorder) {
+        replay_record_actions(recorder, match, actions.held);
     }
-    // Animation Driver
-    alpha += alpha_direction * delta;
+    match_tick(match, actions.held, delta);
 
-    // --- Rendering
-    video_clear(app->video);
+    pulse_t *pulse = state_pulses[match_get_state(match)];
+    if (pulse) {
+        pulse_update(pulse, delta);
+    }
+    publish_snapshot(app);
 
-    draw_entities(app->video, 2, (entity_t *[2]){&left_paddle, &right_paddle});
-    draw_dimmer(app->video);
-    video_draw_text_with_color(app->video, "Game Over", field.x + (field.w / 2),
-                               field.y + (field.h / 2), 255, 255, 255, alpha);
-    video_render(app->video);
+    stop_when_terminated(app);
 }
 
-// -----------------------------------------------------------------------------
-// Game-App Infrastructure
-// -----------------------------------------------------------------------------
-
 /**
- * Handle incoming game events one at a time.
+ * Draw the latest snapshot, `alpha` of the way between its two ticks.
+ *
+ * Keys are taken here too, on the thread SDL's events belong to, whichever
+ * thread the ticks applying them run on.
  */
-static void handle_event(app_t *app, SDL_Event *event) {
-    (void)app;
+static void handle_frame(app_t *app, float alpha) {
+    action_table_pump(action_table);
 
-    if (event->type == SDL_KEYDOWN) {
-        SDL_Scancode scancode = event->key.keysym.scancode;
-        action_t action = action_table_get_scancode_action(action_table, scancode);
-        switch (action) {
-        case CONFIRM:
-            fsm_trigger(fsm, CONFIRM_TRIGGER);
-            break;
-        case PAUSE:
-            fsm_trigger(fsm, PAUSE_TRIGGER);
-            break;
-        case QUIT:
-            fsm_trigger(fsm, QUIT_GAME_TRIGGER);
-            break;
-        default:
-            break;
-        }
+    frame_snapshot_t const *snapshot = app_get_frame_snapshot(app);
+    if (!snapshot) {
+        return; // Nothing simulated yet.
+    }
+    if (!snapshot->has_match) {
+        draw_waiting(app->video);
+        return;
     }
+    profile_set_tag(match_get_state_name(snapshot->state));
 
-    return;
+    state_draw_t draw = state_draws[snapshot->state];
+    if (draw) {
+        draw(app->video, snapshot, alpha);
+    }
 }
 
 /**
- * Execute game processing blocks based on current game state.
+ * Begin processing of the main game loop.
  */
-static void handle_frame(app_t *app, float delta) {
-
-    switch (fsm_state(fsm)) {
-    case START_STATE: // Start State
-        do_start_state(app, delta);
-        break;
-    case RESET_STATE:
-        do_reset_state(app, delta);
-        break;
-    case FIELD_SETUP_STATE:
-        do_field_setup_state(app, delta);
-        break;
-    case COUNTDOWN_STATE:
-        do_countdown_state(app, delta);
-        break;
-    case PLAYING_STATE:
-        do_playing_state(app, delta);
-        break;
-    case PAUSE_STATE:
-        do_pause_state(app, delta);
-        break;
-    case GAME_OVER_STATE:
-        do_game_over_state(app, delta);
-        break;
-    case TERM_STATE: // Stop State
-        app_stop(app);
-        break;
-    // TODO:  Panic on unknown state!
-    default:
-        log_error("Reached unknown state (%d)", fsm_state(fsm));
-        break;
-    }
+void game_run(game_t *game) {
+    app_run(game->app, handle_tick, handle_frame, handle_event);
 }
 
 /**
- * Begin processing of the main game loop.
+ * Start a session with the peer; the match starts once the peer answers.
  */
-void game_run(game_t *game) { app_run(game->app, handle_frame, handle_event); }
+static bool start_session(game_t *game, game_config_t const *config, aabb_t field) {
+    // Both peers must step the match identically, so neither can vary the step.
+    if (!game->app->tick_rate) {
+        log_error("Cannot play a peer without a fixed tick rate");
+        return false;
+    }
+    if (config->record_path) {
+        log_error("Cannot record a match against a peer");
+        return false;
+    }
+    if (config->player != 1 && config->player != 2) {
+        log_error("Cannot play as player %d; only 1 or 2", config->player);
+        return false;
+    }
+    if (!(peer_link = link_init(config->peer))) {
+        return false;
+    }
+
+    rollback_config_t session_config = {
+        .player      = config->player,
+        .input_delay = config->input_delay,
+        .tick_rate   = game->app->tick_rate,
+        .field       = field,
+        .seed        = (uint64_t)time(NULL),
+        .jobs        = game->jobs,
+    };
+    if (!(session = rollback_init(peer_link, &session_config))) {
+        return false;
+    }
+    log_info("Waiting for %s:%hu as player %d", config->peer->remote_host,
+             config->peer->remote_port, config->player);
+    return true;
+}
 
 /**
  * Initialize game instance.
  */
-game_t *game_init(app_config_t *config) {
+game_t *game_init(app_config_t *app_config, game_config_t const *config) {
     log_debug("Initializing Game");
 
-    // --- Application Initializer
-    game_t *game = new (game_t);
+    // --- Game Arena
+    arena_t *arena = arena_init(game_arena_size);
+    if (!arena) {
+        return NULL;
+    }
+    game_t *game = arena_new(arena, game_t);
     game->app    = NULL;
+    game->arena  = arena;
+    game->jobs   = NULL;
 
-    if (!(game->app = app_init(config))) {
+    // --- Application Initializer
+    app_config->snapshot_size = sizeof(frame_snapshot_t);
+    if (!(game->app = app_init(app_config))) {
         game_term(game);
         return NULL;
     }
 
-    // --- Field Configuration
+    // --- Collision Configuration
+    aabb_kernel_select(aabb_kernel_detect());
+    log_debug("AABB batch kernel: %s", aabb_kernel_name(aabb_kernel_get()));
+
+    // --- Job System, one thread per core
+    if (!(game->jobs = job_system_init(0))) {
+        log_error("Cannot initialize job system");
+        game_term(game);
+        return NULL;
+    }
+    log_debug("Job threads: %u", job_system_get_thread_count(game->jobs));
+
+    // --- Match, over the whole window
     int window_width, window_height;
     video_get_window_size(game->app->video, &window_width, &window_height);
-    field.w = window_width;
-    field.h = window_height;
+    match_config_t match_config = {
+        .field         = {0, 0, window_width, window_height},
+        .seed          = (uint64_t)time(NULL),
+        .is_unattended = game->app->is_headless,
+        .jobs          = game->jobs,
+    };
+    if (config->peer) {
+        if (!start_session(game, config, match_config.field)) {
+            game_term(game);
+            return NULL;
+        }
+    } else if (!(match = match_init(&match_config))) {
+        log_error("Cannot initialize match");
+        game_term(game);
+        return NULL;
+    }
 
-    // --- Entity Configuration
-    ball_configure(&ball, &field);
-    paddle_configure(&left_paddle, &field, LEFT_PADDLE);
-    paddle_configure(&right_paddle, &field, RIGHT_PADDLE);
+    // --- Input Recording
+    if (config->record_path) {
+        // Ticks are replayed with a fixed step, so they must be recorded with one.
+        if (!game->app->tick_rate) {
+            log_error("Cannot record without a fixed tick rate");
+            game_term(game);
+            return NULL;
+        }
+        recorder = replay_recorder_init(config->record_path, &match_config,
+                                        game->app->tick_rate);
+        if (!recorder) {
+            game_term(game);
+            return NULL;
+        }
+        log_info("Recording input to %s", config->record_path);
+    }
+
+    // --- Retained Text
+    p1_score_label = (score_label_t){video_text_init(game->app->video, "0"), 0};
+    p2_score_label = (score_label_t){video_text_init(game->app->video, "0"), 0};
+    start_text     = video_text_init(game->app->video, "Press Enter");
+    countdown_text = video_text_init(game->app->video, "3");
+    pause_text     = video_text_init(game->app->video, "Paused");
+    game_over_text = video_text_init(game->app->video, "Game Over");
+    waiting_text   = video_text_init(game->app->video, "Waiting for Peer");
+    video_text_set_color(countdown_text, 255, 255, 255, 240);
+
+    // --- Cached Layers
+    dimmed_layer = video_layer_init(game->app->video, true);
 
     // --- Action Table
     action_table = action_table_init(action_table_config);
 
-    // --- FSM
-    configure_fsm();
-
     log_debug("Initialization Complete");
     return game;
 }
@@ -497,9 +690,24 @@ void game_term(game_t *game) {
     if (!game) {
         return;
     }
-    fsm_term(fsm);
     action_table_term(action_table);
+    replay_recorder_term(recorder, match);
+    if (session) {
+        rollback_term(session); // Owns the match.
+    } else {
+        match_term(match);
+    }
+    link_term(peer_link);
+    job_system_term(game->jobs);
+    video_text_term(p1_score_label.text);
+    video_text_term(p2_score_label.text);
+    video_text_term(start_text);
+    video_text_term(countdown_text);
+    video_text_term(pause_text);
+    video_text_term(game_over_text);
+    video_text_term(waiting_text);
+    video_layer_term(dimmed_layer);
     app_term(game->app);
 
-    delete (game);
+    arena_term(game->arena);
 }
@@ -1,9 +1,20 @@
 #pragma once
 
 #include "app/app.h"
+#include "net/link.h"
+
+/**
+ * Game Configuration Parameters.
+ */
+typedef struct {
+  char const *record_path;   // Record the match's input here (NULL: don't).
+  link_config_t const *peer; // Play against a peer over this (NULL: both here).
+  unsigned char player;      // 1 or 2: the paddle played here, against a peer.
+  unsigned char input_delay; // Ticks local input waits, against a peer.
+} game_config_t;
 
 typedef struct game_s game_t;
 
-game_t *game_init(app_config_t *config);
+game_t *game_init(app_config_t *app_config, game_config_t const *config);
 void game_term(game_t *game);
 void game_run(game_t *game);
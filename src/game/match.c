@@ -0,0 +1,444 @@
+#include <SDL2/SDL.h>
+
+#include <log.h>
+#include <stddef.h>
+
+#include "actions.h"
+#include "alloc.h"
+#include "ball.h"
+#include "collision.h"
+#include "entity.h"
+#include "field.h"
+#include "fsm/fsm.h"
+#include "match.h"
+#include "paddle.h"
+#include "player.h"
+#include "profile/profile.h"
+
+// Match Arena (match instance, ball data)
+static size_t const match_arena_size = 1024;
+
+// Per-tick scratch (collision working memory); grows if a tick needs more.
+static size_t const scratch_arena_size = 4 * 1024;
+
+// Entity Storage (ball, left paddle, right paddle, room to spare)
+static size_t const entity_capacity = 1024;
+
+// Collision Broadphase
+static int const collision_cell_size = 64;
+
+static unsigned char const winning_score = 5;
+
+// State Names (profiler tags)
+static char const *const state_names[STATE_COUNT] = {
+    [STATE_GUARD]       = "guard",
+    [START_STATE]       = "start",
+    [RESET_STATE]       = "reset",
+    [COUNTDOWN_STATE]   = "countdown",
+    [FIELD_SETUP_STATE] = "field_setup",
+    [PLAYING_STATE]     = "playing",
+    [PAUSE_STATE]       = "pause",
+    [GAME_OVER_STATE]   = "game_over",
+    [TERM_STATE]        = "term",
+};
+
+// State Machine: one definition, shared by every live match
+static fsm_def_t *fsm_def        = NULL;
+static unsigned fsm_def_users    = 0;
+static SDL_SpinLock fsm_def_lock = 0;
+
+// -----------------------------------------------------------------------------
+// Match Components
+// -----------------------------------------------------------------------------
+
+static void check_goal_conditions(match_t *match) {
+    entity_t ball_entity = match_get_entity(match, match->ball);
+    aabb_t ball_transform;
+    entity_get_transform(&ball_entity, &ball_transform);
+
+    // Is the ball in the left goal?
+    if (field_is_subject_in_left_goal(&match->field, &ball_transform)) {
+        // player 2 gets the point
+        player_inc_score(&match->player_2);
+        // Did player 2 win?
+        if (player_get_score(&match->player_2) >= winning_score) {
+            match_trigger(match, GAME_OVER_TRIGGER);
+        } else {
+            match_trigger(match, NEXT_TRIGGER);
+        }
+    }
+
+    // Is the ball in the right goal?
+    else if (field_is_subject_in_right_goal(&match->field, &ball_transform)) {
+        // player 1 gets the point
+        player_inc_score(&match->player_1);
+        // Did player 1 win?
+        if (player_get_score(&match->player_1) >= winning_score) {
+            match_trigger(match, GAME_OVER_TRIGGER);
+        } else {
+            match_trigger(match, NEXT_TRIGGER);
+        }
+    }
+}
+
+static void handle_player_actions(match_t *match, bool const *actions) {
+    // --- Input
+    bool p1_up   = actions && actions[P1_UP];
+    bool p1_down = actions && actions[P1_DOWN];
+    bool p2_up   = actions && actions[P2_UP];
+    bool p2_down = actions && actions[P2_DOWN];
+
+    entity_t left_paddle_entity  = match_get_entity(match, match->left_paddle);
+    entity_t right_paddle_entity = match_get_entity(match, match->right_paddle);
+    entity_set_velocity(&left_paddle_entity, 0, (p1_down - p1_up) * 400);
+    entity_set_velocity(&right_paddle_entity, 0, (p2_down - p2_up) * 400);
+}
+
+// -----------------------------------------------------------------------------
+// Enter Actions
+// -----------------------------------------------------------------------------
+
+// Transient states only have an enter action. The FSM runs their triggers to
+// completion, so a goal reaches the next countdown within the same tick.
+
+static void enter_reset_state(fsm_def_t const *def, fsm_t *fsm) {
+    match_t *match         = fsm->context;
+    match->player_1.score = 0;
+    match->player_2.score = 0;
+    fsm_trigger(def, fsm, NEXT_TRIGGER);
+}
+
+/**
+ * Place the ball and transition
+ */
+static void enter_field_setup_state(fsm_def_t const *def, fsm_t *fsm) {
+    match_t *match       = fsm->context;
+    entity_t ball_entity = match_get_entity(match, match->ball);
+    ball_configure(&ball_entity, &match->field, &match->rng);
+    fsm_trigger(def, fsm, NEXT_TRIGGER);
+}
+
+static void enter_countdown_state(fsm_def_t const *def, fsm_t *fsm) {
+    (void)def;
+    match_t *match           = fsm->context;
+    match->countdown.elapsed = 0;
+    match->countdown.counter = 3;
+}
+
+/**
+ * Configure match-state transition table.
+ */
+static fsm_def_t *configure_fsm(void) {
+    fsm_def_t *def = fsm_def_init(STATE_COUNT, TRIGGER_COUNT, START_STATE);
+    if (!def) {
+        return NULL;
+    }
+
+    // Start
+    fsm_on(def, START_STATE, CONFIRM_TRIGGER, FIELD_SETUP_STATE);
+    fsm_on(def, START_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
+
+    // Reset
+    fsm_on(def, RESET_STATE, NEXT_TRIGGER, FIELD_SETUP_STATE);
+    fsm_on(def, RESET_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
+    fsm_set_enter_action(def, RESET_STATE, enter_reset_state);
+
+    // Field Setup
+    fsm_on(def, FIELD_SETUP_STATE, NEXT_TRIGGER, COUNTDOWN_STATE);
+    fsm_on(def, FIELD_SETUP_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
+    fsm_set_enter_action(def, FIELD_SETUP_STATE, enter_field_setup_state);
+
+    // Countdown
+    fsm_on(def, COUNTDOWN_STATE, NEXT_TRIGGER, PLAYING_STATE);
+    fsm_on(def, COUNTDOWN_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
+    fsm_set_enter_action(def, COUNTDOWN_STATE, enter_countdown_state);
+
+    // Playing
+    fsm_on(def, PLAYING_STATE, PAUSE_TRIGGER, PAUSE_STATE);
+    fsm_on(def, PLAYING_STATE, NEXT_TRIGGER, FIELD_SETUP_STATE);
+    fsm_on(def, PLAYING_STATE, GAME_OVER_TRIGGER, GAME_OVER_STATE);
+    fsm_on(def, PLAYING_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
+
+    // Pause State
+    fsm_on(def, PAUSE_STATE, PAUSE_TRIGGER, PLAYING_STATE);
+    fsm_on(def, PAUSE_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
+
+    // Game Over
+    fsm_on(def, GAME_OVER_STATE, CONFIRM_TRIGGER, RESET_STATE);
+    fsm_on(def, GAME_OVER_STATE, CANCEL_TRIGGER, TERM_STATE);
+    fsm_on(def, GAME_OVER_STATE, QUIT_GAME_TRIGGER, TERM_STATE);
+
+    // Terminating (Loop-back only)
+    fsm_on(def, TERM_STATE, NEXT_TRIGGER, TERM_STATE);
+    return def;
+}
+
+static fsm_def_t const *fsm_def_acquire(void) {
+    SDL_AtomicLock(&fsm_def_lock);
+    if (!fsm_def_users && !(fsm_def = configure_fsm())) {
+        SDL_AtomicUnlock(&fsm_def_lock);
+        return NULL;
+    }
+    fsm_def_users++;
+    SDL_AtomicUnlock(&fsm_def_lock);
+    return fsm_def;
+}
+
+static void fsm_def_release(void) {
+    SDL_AtomicLock(&fsm_def_lock);
+    if (!--fsm_def_users) {
+        fsm_def_term(fsm_def);
+        fsm_def = NULL;
+    }
+    SDL_AtomicUnlock(&fsm_def_lock);
+}
+
+// -----------------------------------------------------------------------------
+// Core Processing Blocks
+// -----------------------------------------------------------------------------
+
+static void do_start_state(match_t *match, bool const *actions, float delta) {
+    (void)actions;
+    (void)delta;
+
+    // Nobody is there to press Enter.
+    if (match->is_unattended) {
+        match_trigger(match, CONFIRM_TRIGGER);
+    }
+}
+
+/**
+ * Count down from 3 to 0.
+ */
+static void do_countdown_state(match_t *match, bool const *actions, float delta) {
+    (void)actions;
+
+    static float const step_seconds = 0.6f;
+
+    // --- Animation Update
+    match->countdown.elapsed += delta;
+
+    if (match->countdown.elapsed >= step_seconds) {
+        match->countdown.elapsed -= step_seconds;
+        if (match->countdown.counter == 0) {
+            match_trigger(match, NEXT_TRIGGER);
+        } else {
+            match->countdown.counter -= 1;
+        }
+    }
+}
+
+/**
+ * Processing block when STATE == PLAYING
+ */
+static void do_playing_state(match_t *match, bool const *actions, float delta) {
+    // --- Input
+    profile_zone_t zone = profile_begin("player_actions");
+    handle_player_actions(match, actions);
+    profile_end(&zone);
+
+    // --- Update
+
+    // Collision
+    // Nothing may move unchecked; without memory to check, the tick stands still.
+    zone = profile_begin("collision");
+    bool const is_processed = collision_process(
+        match->collision_grid, match->entity_store, match->scratch, match->jobs, delta);
+    profile_end(&zone);
+    if (!is_processed) {
+        return;
+    }
+
+    // Entity Updates
+    // Whatever a contact left of the tick, at velocities collisions just set.
+    zone = profile_begin("entity_update");
+    entity_store_integrate(match->entity_store, match->jobs, delta);
+    profile_end(&zone);
+
+    // Bounds are checked where entities end up, bouncing them back next tick.
+    zone = profile_begin("out_of_bounds");
+    collision_out_of_bounds_process(match->entity_store, &match->field);
+    profile_end(&zone);
+
+    // Goal Polling
+    check_goal_conditions(match);
+}
+
+static void do_game_over_state(match_t *match, bool const *actions, float delta) {
+    (void)actions;
+    (void)delta;
+
+    // An unattended match is played exactly once.
+    if (match->is_unattended) {
+        match_trigger(match, CANCEL_TRIGGER);
+    }
+}
+
+// Per-state processing blocks. Transient states are never current between
+// ticks, and paused or finished matches stand still.
+
+typedef void (*state_processor_t)(match_t *match, bool const *actions, float delta);
+
+static state_processor_t const state_ticks[STATE_COUNT] = {
+    [START_STATE]     = do_start_state,
+    [COUNTDOWN_STATE] = do_countdown_state,
+    [PLAYING_STATE]   = do_playing_state,
+    [GAME_OVER_STATE] = do_game_over_state,
+};
+
+// -----------------------------------------------------------------------------
+// Match Interface
+// -----------------------------------------------------------------------------
+
+void match_tick(match_t *match, bool const *actions, float delta) {
+    arena_reset(match->scratch);
+
+    // Rows only move between ticks; then interpolation runs from wherever
+    // entities were before this tick.
+    entity_store_collect(match->entity_store);
+    entity_store_commit_transforms(match->entity_store);
+
+    state_processor_t tick = state_ticks[match_get_state(match)];
+    if (tick) {
+        tick(match, actions, delta);
+    }
+    match->tick_count++;
+}
+
+void match_trigger(match_t *match, match_trigger_t trigger) {
+    static char const *const error_names[] = {
+        [FSM_OK]         = "ok",
+        [FSM_QUEUE_FULL] = "trigger queue full",
+        [FSM_CYCLE]      = "transition cycle",
+    };
+
+    fsm_error_t error = fsm_trigger(fsm_def, &match->fsm, trigger);
+    if (error != FSM_OK) {
+        log_error("FSM %s (trigger %d, now in %s)", error_names[error], trigger,
+                  state_names[match_get_state(match)]);
+    }
+}
+
+match_state_t match_get_state(match_t const *match) { return fsm_state(&match->fsm); }
+
+void match_save(match_t *match, match_snapshot_t *snapshot) {
+    entity_store_t *store = match->entity_store;
+    entity_t ball         = match_get_entity(match, match->ball);
+
+    snapshot->state             = match_get_state(match);
+    snapshot->rng               = match->rng;
+    snapshot->player_1          = match->player_1;
+    snapshot->player_2          = match->player_2;
+    snapshot->countdown_elapsed = match->countdown.elapsed;
+    snapshot->countdown_counter = match->countdown.counter;
+    snapshot->tick_count        = match->tick_count;
+    snapshot->ball_speed        = ball_get_speed(&ball);
+    snapshot->entity_count      = store->count;
+
+    if (store->count > MATCH_SNAPSHOT_ENTITY_MAX) {
+        log_error("Cannot save %zu entities; saving the first %d", store->count,
+                  MATCH_SNAPSHOT_ENTITY_MAX);
+        snapshot->entity_count = MATCH_SNAPSHOT_ENTITY_MAX;
+    }
+    for (size_t index = 0; index < snapshot->entity_count; index++) {
+        snapshot->entities[index].x          = store->x[index];
+        snapshot->entities[index].y          = store->y[index];
+        snapshot->entities[index].w          = store->w[index];
+        snapshot->entities[index].h          = store->h[index];
+        snapshot->entities[index].vx         = store->vx[index];
+        snapshot->entities[index].vy         = store->vy[index];
+        snapshot->entities[index].previous_x = store->previous_x[index];
+        snapshot->entities[index].previous_y = store->previous_y[index];
+    }
+}
+
+void match_load(match_t *match, match_snapshot_t const *snapshot) {
+    entity_store_t *store = match->entity_store;
+    entity_t ball         = match_get_entity(match, match->ball);
+
+    fsm_restore(&match->fsm, snapshot->state);
+    match->rng               = snapshot->rng;
+    match->player_1          = snapshot->player_1;
+    match->player_2          = snapshot->player_2;
+    match->countdown.elapsed = snapshot->countdown_elapsed;
+    match->countdown.counter = snapshot->countdown_counter;
+    match->tick_count        = snapshot->tick_count;
+    ball_set_speed(&ball, snapshot->ball_speed);
+
+    for (size_t index = 0; index < snapshot->entity_count; index++) {
+        store->x[index]          = snapshot->entities[index].x;
+        store->y[index]          = snapshot->entities[index].y;
+        store->w[index]          = snapshot->entities[index].w;
+        store->h[index]          = snapshot->entities[index].h;
+        store->vx[index]         = snapshot->entities[index].vx;
+        store->vy[index]         = snapshot->entities[index].vy;
+        store->previous_x[index] = snapshot->entities[index].previous_x;
+        store->previous_y[index] = snapshot->entities[index].previous_y;
+    }
+}
+
+char const *match_get_state_name(match_state_t state) { return state_names[state]; }
+
+entity_t match_get_entity(match_t *match, entity_handle_t handle) {
+    entity_t entity = {match->entity_store, 0};
+    if (!entity_get(match->entity_store, handle, &entity)) {
+        log_error("Stale entity handle (%#x)", handle);
+    }
+    return entity;
+}
+
+// -----------------------------------------------------------------------------
+// Lifecycle
+// -----------------------------------------------------------------------------
+
+/**
+ * Initialize match instance.
+ */
+match_t *match_init(match_config_t const *config) {
+    // --- Match Arena
+    arena_t *arena = arena_init(match_arena_size);
+    if (!arena) {
+        return NULL;
+    }
+    match_t *match = arena_new(arena, match_t);
+    *match         = (match_t){.arena = arena, .field = config->field};
+
+    fsm_def_t const *def = fsm_def_acquire();
+    if (!def) {
+        arena_term(arena);
+        return NULL;
+    }
+    fsm_init(&match->fsm, def, match);
+    match->is_unattended = config->is_unattended;
+    match->jobs          = config->jobs;
+    rng_init(&match->rng, config->seed);
+
+    // --- Scratch, Collision and Entities
+    match->scratch        = arena_init(scratch_arena_size);
+    match->collision_grid = collision_grid_init(&match->field, collision_cell_size);
+    match->entity_store   = entity_store_init(entity_capacity);
+    if (!match->scratch || !match->collision_grid || !match->entity_store) {
+        match_term(match);
+        return NULL;
+    }
+
+    match->ball = ball_init(match->entity_store, &match->field, match->arena,
+                            &match->rng);
+    match->left_paddle  = paddle_init(match->entity_store, &match->field, LEFT_PADDLE);
+    match->right_paddle = paddle_init(match->entity_store, &match->field, RIGHT_PADDLE);
+    return match;
+}
+
+/**
+ * Terminate match instance.
+ */
+void match_term(match_t *match) {
+    if (!match) {
+        return;
+    }
+    entity_store_term(match->entity_store);
+    collision_grid_term(match->collision_grid);
+    arena_term(match->scratch);
+    fsm_def_release();
+    arena_term(match->arena);
+}
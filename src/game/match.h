@@ -0,0 +1,167 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aabb.h"
+#include "alloc.h"
+#include "collision.h"
+#include "entity.h"
+#include "fsm/fsm.h"
+#include "jobs/jobs.h"
+#include "player.h"
+#include "rng.h"
+
+/**
+ * Match states.
+ */
+typedef enum {
+  STATE_GUARD,
+  START_STATE,
+  RESET_STATE,
+  COUNTDOWN_STATE,
+  FIELD_SETUP_STATE,
+  PLAYING_STATE,
+  PAUSE_STATE,
+  GAME_OVER_STATE,
+  TERM_STATE,
+  STATE_COUNT,
+} match_state_t;
+
+/**
+ * Match triggers.
+ */
+typedef enum {
+  INIT_DONE_TRIGGER,
+  QUIT_GAME_TRIGGER,
+  GAME_OVER_TRIGGER,
+  NEXT_TRIGGER,
+  PAUSE_TRIGGER,
+  CONFIRM_TRIGGER,
+  CANCEL_TRIGGER,
+  TRIGGER_COUNT,
+} match_trigger_t;
+
+/**
+ * Match Configuration Parameters.
+ */
+typedef struct {
+  aabb_t field;       // Playing field, in pixels.
+  uint64_t seed;      // Seeds the match's own RNG.
+  bool is_unattended; // Nobody presses Enter: start at once, stop at game over.
+  job_system_t *jobs; // Splits each tick's heavy passes (NULL: none; not owned).
+} match_config_t;
+
+/**
+ * One match: everything a game of Pong simulates, and nothing it draws.
+ *
+ * Matches share no mutable state, so any number of them can be stepped at once
+ * on different threads. Initialize and terminate them from one thread at a
+ * time, though; they share a state machine definition.
+ *
+ * A match given a job system also splits collision and integration within each
+ * tick across that system's threads, with the same results as without.
+ */
+typedef struct match_s {
+  arena_t *arena;   // Match lifetime; holds the match itself.
+  arena_t *scratch; // Per-tick working memory, reset at the top of each tick.
+  rng_t rng;
+  fsm_t fsm;
+  job_system_t *jobs;
+  bool is_unattended;
+  aabb_t field;
+  player_t player_1;
+  player_t player_2;
+  entity_store_t *entity_store;
+  collision_grid_t *collision_grid;
+  entity_handle_t ball;
+  entity_handle_t left_paddle;
+  entity_handle_t right_paddle;
+  struct {
+    float elapsed;
+    unsigned char counter;
+  } countdown;              // Progress, in simulation time.
+  unsigned long tick_count; // Ticks simulated so far.
+} match_t;
+
+// Most entities a snapshot holds; a match has three.
+#define MATCH_SNAPSHOT_ENTITY_MAX 4
+
+/**
+ * Everything about a match that changes as it is played, to rewind it to.
+ *
+ * A match spawns every entity when initialized and never despawns one, so the
+ * entities' rows are saved but not the pool around them.
+ */
+typedef struct {
+  int state;
+  rng_t rng;
+  player_t player_1;
+  player_t player_2;
+  float countdown_elapsed;
+  unsigned char countdown_counter;
+  unsigned long tick_count;
+  unsigned short ball_speed;
+  size_t entity_count;
+  struct {
+    fixed_t x;
+    fixed_t y;
+    fixed_t w;
+    fixed_t h;
+    fixed_t vx;
+    fixed_t vy;
+    fixed_t previous_x;
+    fixed_t previous_y;
+  } entities[MATCH_SNAPSHOT_ENTITY_MAX];
+} match_snapshot_t;
+
+/**
+ * Initialize a match in its start state.
+ *
+ * \returns NULL if out of memory.
+ * \sa match_term
+ */
+match_t *match_init(match_config_t const *config);
+
+/**
+ * Terminate a match.
+ */
+void match_term(match_t *match);
+
+/**
+ * Advance the match by `delta` seconds.
+ *
+ * \param actions Binary action states held this tick (see actions.h), or NULL
+ *                if nobody is playing.
+ */
+void match_tick(match_t *match, bool const *actions, float delta);
+
+/**
+ * Fire `trigger` and run it to completion, logging anything dropped.
+ */
+void match_trigger(match_t *match, match_trigger_t trigger);
+
+match_state_t match_get_state(match_t const *match);
+
+/**
+ * Save the state of `match` between ticks.
+ *
+ * \sa match_load
+ */
+void match_save(match_t *match, match_snapshot_t *snapshot);
+
+/**
+ * Rewind (or fast-forward) `match` to a state saved from it, running no state
+ * machine actions.
+ */
+void match_load(match_t *match, match_snapshot_t const *snapshot);
+
+/**
+ * Get a name for `state`, fit for profiler tags and logs.
+ */
+char const *match_get_state_name(match_state_t state);
+
+/**
+ * Get a view of an entity the match keeps for its whole lifetime.
+ */
+entity_t match_get_entity(match_t *match, entity_handle_t handle);
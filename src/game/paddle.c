@@ -11,11 +11,6 @@
 #define PADDLE_MIN_WIDTH  8
 #define PADDLE_MIN_HEIGHT 128
 
-static void update(entity_t *paddle, float delta) {
-    paddle->transform.x += (int)(paddle->vx * delta);
-    paddle->transform.y += (int)(paddle->vy * delta);
-}
-
 static void out_of_bounds(entity_t *self, aabb_edge_t edge) {
     switch (edge) {
     case AABB_TOP_EDGE:
@@ -89,23 +84,37 @@ void paddle_configure(entity_t *paddle, aabb_t *field, paddle_identifier_t ident
     // --- Position
     int field_section_center_x = field_section.x + field_section.w / 2;
     int field_section_center_y = field_section.y + field_section.h / 2;
-    paddle->transform.x        = field_section_center_x;
-    paddle->transform.y        = field_section_center_y;
+
+    aabb_t transform;
+    transform.x = field_section_center_x;
+    transform.y = field_section_center_y;
 
     // --- Size
     // TODO: Scale with field.
-    paddle->transform.w = PADDLE_MIN_WIDTH;
-    paddle->transform.h = PADDLE_MIN_HEIGHT;
+    transform.w = PADDLE_MIN_WIDTH;
+    transform.h = PADDLE_MIN_HEIGHT;
+
+    entity_set_transform(paddle, &transform);
 
     // --- Velocity
     entity_set_velocity(paddle, 0, 0);
 
-    paddle->update        = update;
-    paddle->out_of_bounds = out_of_bounds;
+    // --- Interpolation
+    // Freshly placed; nothing to interpolate from.
+    entity_commit_transform(paddle);
+
+    entity_get_behaviour(paddle)->out_of_bounds = out_of_bounds;
 }
 
-entity_t *paddle_init(aabb_t *field, paddle_identifier_t identifier) {
-    entity_t *paddle = entity_init();
-    paddle_configure(paddle, field, identifier);
-    return paddle;
+entity_handle_t paddle_init(entity_store_t *store, aabb_t *field,
+                            paddle_identifier_t identifier) {
+    entity_handle_t handle = entity_spawn(store);
+    entity_t paddle;
+    if (!entity_get(store, handle, &paddle)) {
+        log_error("Cannot spawn paddle: entity store is full");
+        return ENTITY_HANDLE_NULL;
+    }
+
+    paddle_configure(&paddle, field, identifier);
+    return handle;
 }
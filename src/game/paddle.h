@@ -11,6 +11,7 @@ void paddle_configure(entity_t *paddle, aabb_t *field,
                       paddle_identifier_t identifier);
 
 /**
- * Initialize new paddle.
+ * Initialize new paddle in `store`.
  */
-entity_t *paddle_init(aabb_t *field, paddle_identifier_t identifier);
+entity_handle_t paddle_init(entity_store_t *store, aabb_t *field,
+                            paddle_identifier_t identifier);
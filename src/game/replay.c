@@ -0,0 +1,333 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "actions.h"
+#include "alloc.h"
+#include "replay.h"
+
+#define REPLAY_MAGIC   "PREC"
+#define REPLAY_VERSION 1
+
+#define HEADER_SIZE 33
+#define RECORD_SIZE 7
+
+#define UNATTENDED_FLAG 0x01
+
+_Static_assert(ACTION_COUNT <= 16, "actions must fit a 16-bit record value");
+
+/**
+ * One decoded record.
+ */
+typedef struct {
+    replay_record_type_t type;
+    uint32_t tick;
+    uint16_t value;
+} replay_record_t;
+
+typedef struct replay_recorder_s {
+    FILE *file;
+    uint16_t actions; // Last actions written.
+    bool is_failed;   // A write failed; nothing more is written.
+} replay_recorder_t;
+
+typedef struct replay_s {
+    match_config_t config;
+    unsigned short tick_rate;
+    replay_record_t *records;
+    size_t record_count; // Including the end record, always last.
+} replay_t;
+
+// -----------------------------------------------------------------------------
+// Encoding
+// -----------------------------------------------------------------------------
+
+static void put_u16(uint8_t *bytes, uint16_t value) {
+    bytes[0] = value;
+    bytes[1] = value >> 8;
+}
+
+static void put_u32(uint8_t *bytes, uint32_t value) {
+    put_u16(bytes, value);
+    put_u16(bytes + 2, value >> 16);
+}
+
+static void put_u64(uint8_t *bytes, uint64_t value) {
+    put_u32(bytes, value);
+    put_u32(bytes + 4, value >> 32);
+}
+
+static uint16_t get_u16(uint8_t const *bytes) { return bytes[0] | bytes[1] << 8; }
+
+static uint32_t get_u32(uint8_t const *bytes) {
+    return get_u16(bytes) | (uint32_t)get_u16(bytes + 2) << 16;
+}
+
+static uint64_t get_u64(uint8_t const *bytes) {
+    return get_u32(bytes) | (uint64_t)get_u32(bytes + 4) << 32;
+}
+
+static uint16_t pack_actions(bool const *actions) {
+    uint16_t bits = 0;
+    for (int action = 0; actions && action < ACTION_COUNT; action++) {
+        bits |= actions[action] << action;
+    }
+    return bits;
+}
+
+static void unpack_actions(uint16_t bits, bool *actions) {
+    for (int action = 0; action < ACTION_COUNT; action++) {
+        actions[action] = bits >> action & 1;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Recording
+// -----------------------------------------------------------------------------
+
+static void write_bytes(replay_recorder_t *recorder, uint8_t const *bytes,
+                        size_t size) {
+    if (recorder->is_failed) {
+        return;
+    }
+    if (fwrite(bytes, 1, size, recorder->file) != size) {
+        log_error("Cannot write replay; recording stopped");
+        recorder->is_failed = true;
+    }
+}
+
+static void write_record(replay_recorder_t *recorder, replay_record_type_t type,
+                         unsigned long tick, uint16_t value) {
+    uint8_t bytes[RECORD_SIZE];
+    bytes[0] = type;
+    put_u32(&bytes[1], tick);
+    put_u16(&bytes[5], value);
+    write_bytes(recorder, bytes, sizeof bytes);
+}
+
+replay_recorder_t *replay_recorder_init(char const *path, match_config_t const *config,
+                                        unsigned short tick_rate) {
+    replay_recorder_t *recorder = new (replay_recorder_t);
+    if (!recorder) {
+        return NULL;
+    }
+    if (!(recorder->file = fopen(path, "wb"))) {
+        log_error("Cannot open %s to record to", path);
+        delete (recorder);
+        return NULL;
+    }
+    recorder->actions   = 0;
+    recorder->is_failed = false;
+
+    uint8_t header[HEADER_SIZE];
+    memcpy(header, REPLAY_MAGIC, 4);
+    put_u16(&header[4], REPLAY_VERSION);
+    put_u16(&header[6], tick_rate);
+    put_u32(&header[8], config->field.x);
+    put_u32(&header[12], config->field.y);
+    put_u32(&header[16], config->field.w);
+    put_u32(&header[20], config->field.h);
+    put_u64(&header[24], config->seed);
+    header[32] = config->is_unattended ? UNATTENDED_FLAG : 0;
+    write_bytes(recorder, header, sizeof header);
+    return recorder;
+}
+
+void replay_record_actions(replay_recorder_t *recorder, match_t const *match,
+                           bool const *actions) {
+    uint16_t bits = pack_actions(actions);
+    if (bits != recorder->actions) {
+        write_record(recorder, REPLAY_ACTIONS, match->tick_count, bits);
+        recorder->actions = bits;
+    }
+}
+
+void replay_record_trigger(replay_recorder_t *recorder, match_t const *match,
+                           match_trigger_t trigger) {
+    write_record(recorder, REPLAY_TRIGGER, match->tick_count, trigger);
+}
+
+void replay_recorder_term(replay_recorder_t *recorder, match_t *match) {
+    if (!recorder) {
+        return;
+    }
+    write_record(recorder, REPLAY_END, match->tick_count,
+                 player_get_score(&match->player_1) << 8 |
+                     player_get_score(&match->player_2));
+    if (fclose(recorder->file) && !recorder->is_failed) {
+        log_error("Cannot finish writing replay");
+    }
+    delete (recorder);
+}
+
+// -----------------------------------------------------------------------------
+// Playback
+// -----------------------------------------------------------------------------
+
+/**
+ * Read the whole of a file into memory.
+ */
+static uint8_t *read_file(char const *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+
+    uint8_t *bytes  = NULL;
+    size_t capacity = 0;
+    *size           = 0;
+    do {
+        if (*size == capacity) {
+            capacity       = capacity ? capacity * 2 : 4096;
+            uint8_t *grown = realloc(bytes, capacity);
+            if (!grown) {
+                delete (bytes);
+                fclose(file);
+                return NULL;
+            }
+            bytes = grown;
+        }
+        *size += fread(bytes + *size, 1, capacity - *size, file);
+    } while (*size == capacity);
+
+    bool is_read = !ferror(file);
+    fclose(file);
+    if (!is_read) {
+        delete (bytes);
+        return NULL;
+    }
+    return bytes;
+}
+
+/**
+ * Decode the records following the header, checking every one is valid and
+ * that they end with the end record.
+ */
+static bool decode_records(replay_t *replay, uint8_t const *bytes, size_t size) {
+    replay->record_count = size / RECORD_SIZE;
+    if (size % RECORD_SIZE || !replay->record_count) {
+        return false;
+    }
+    if (!(replay->records = new_array(replay->record_count, replay_record_t))) {
+        return false;
+    }
+
+    uint32_t tick = 0;
+    for (size_t index = 0; index < replay->record_count; index++) {
+        uint8_t const *record = &bytes[index * RECORD_SIZE];
+        replay_record_t *out  = &replay->records[index];
+        out->type             = record[0];
+        out->tick             = get_u32(&record[1]);
+        out->value            = get_u16(&record[5]);
+
+        bool is_last  = index + 1 == replay->record_count;
+        bool is_valid = out->type <= REPLAY_END && out->tick >= tick &&
+                        (out->type == REPLAY_END) == is_last &&
+                        (out->type != REPLAY_TRIGGER || out->value < TRIGGER_COUNT);
+        if (!is_valid) {
+            return false;
+        }
+        tick = out->tick;
+    }
+    return true;
+}
+
+replay_t *replay_load(char const *path) {
+    size_t size;
+    uint8_t *bytes = read_file(path, &size);
+    if (!bytes) {
+        log_error("Cannot read replay %s", path);
+        return NULL;
+    }
+
+    replay_t *replay = new (replay_t);
+    if (!replay) {
+        delete (bytes);
+        return NULL;
+    }
+    replay->records = NULL;
+
+    if (size < HEADER_SIZE || memcmp(bytes, REPLAY_MAGIC, 4) ||
+        get_u16(&bytes[4]) != REPLAY_VERSION || !get_u16(&bytes[6])) {
+        log_error("%s is not a version %d replay", path, REPLAY_VERSION);
+        delete (bytes);
+        replay_term(replay);
+        return NULL;
+    }
+
+    aabb_t field      = {(int32_t)get_u32(&bytes[8]), (int32_t)get_u32(&bytes[12]),
+                         (int32_t)get_u32(&bytes[16]), (int32_t)get_u32(&bytes[20])};
+    replay->tick_rate = get_u16(&bytes[6]);
+    replay->config    = (match_config_t){
+        .field         = field,
+        .seed          = get_u64(&bytes[24]),
+        .is_unattended = bytes[32] & UNATTENDED_FLAG,
+    };
+
+    bool is_valid = decode_records(replay, bytes + HEADER_SIZE, size - HEADER_SIZE);
+    delete (bytes);
+    if (!is_valid) {
+        log_error("Replay %s is truncated or corrupt", path);
+        replay_term(replay);
+        return NULL;
+    }
+    return replay;
+}
+
+void replay_term(replay_t *replay) {
+    if (!replay) {
+        return;
+    }
+    delete (replay->records);
+    delete (replay);
+}
+
+bool replay_play(replay_t const *replay, match_result_t *result) {
+    *result        = (match_result_t){0};
+    match_t *match = match_init(&replay->config);
+    if (!match) {
+        return false;
+    }
+
+    replay_record_t const *end  = &replay->records[replay->record_count - 1];
+    replay_record_t const *next = replay->records;
+    float const tick_delta      = 1.0f / replay->tick_rate;
+    bool actions[ACTION_COUNT]  = {0};
+
+    while (true) {
+        // --- Input recorded before this tick
+        for (; next < end && next->tick == match->tick_count; next++) {
+            if (next->type == REPLAY_ACTIONS) {
+                unpack_actions(next->value, actions);
+            } else {
+                match_trigger(match, next->value);
+            }
+        }
+
+        if (match_get_state(match) == TERM_STATE || match->tick_count >= end->tick) {
+            break;
+        }
+        match_tick(match, actions, tick_delta);
+    }
+
+    result->score_1     = player_get_score(&match->player_1);
+    result->score_2     = player_get_score(&match->player_2);
+    result->tick_count  = match->tick_count;
+    result->is_finished = match_get_state(match) == TERM_STATE;
+    match_term(match);
+
+    unsigned short recorded_1 = end->value >> 8;
+    unsigned short recorded_2 = end->value & 0xff;
+    if (result->tick_count != end->tick || result->score_1 != recorded_1 ||
+        result->score_2 != recorded_2) {
+        log_error("Replay diverged: recorded %hu - %hu after %lu ticks, "
+                  "replayed %hu - %hu after %lu",
+                  recorded_1, recorded_2, (unsigned long)end->tick, result->score_1,
+                  result->score_2, result->tick_count);
+        return false;
+    }
+    return true;
+}
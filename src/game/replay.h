@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdbool.h>
+
+#include "match.h"
+#include "runner.h"
+
+/**
+ * Replay File Format.
+ *
+ * Everything is little-endian. A header describes the match:
+ *
+ *   magic "PREC", version (u16), tick rate (u16),
+ *   field x, y, w, h (i32 each), seed (u64), flags (u8: 1 = unattended)
+ *
+ * followed by 7-byte records, in the order they happened:
+ *
+ *   type (u8), tick (u32), value (u16)
+ *
+ * A record applies just before the match's tick number `tick` is simulated.
+ * Actions records hold every action held from then on, one bit per action_t;
+ * they are only written when that set changes. Trigger records hold a trigger
+ * fired from outside the match. The last record is always the end record, its
+ * tick being the number of ticks simulated and its value the final score
+ * (player 1 in the high byte).
+ */
+typedef enum {
+  REPLAY_ACTIONS,
+  REPLAY_TRIGGER,
+  REPLAY_END,
+} replay_record_type_t;
+
+typedef struct replay_recorder_s replay_recorder_t;
+typedef struct replay_s replay_t;
+
+/**
+ * Start recording a match played from `config` at `tick_rate` ticks per
+ * second to the file at `path`.
+ *
+ * \returns NULL if the file cannot be written, or out of memory.
+ * \sa replay_recorder_term
+ */
+replay_recorder_t *replay_recorder_init(char const *path, match_config_t const *config,
+                                        unsigned short tick_rate);
+
+/**
+ * Record the actions held for the match's next tick, if they changed.
+ */
+void replay_record_actions(replay_recorder_t *recorder, match_t const *match,
+                           bool const *actions);
+
+/**
+ * Record `trigger`, about to be fired at the match from outside.
+ */
+void replay_record_trigger(replay_recorder_t *recorder, match_t const *match,
+                           match_trigger_t trigger);
+
+/**
+ * Write the end record for `match` and close the file.
+ */
+void replay_recorder_term(replay_recorder_t *recorder, match_t *match);
+
+/**
+ * Load a recording made by a replay recorder.
+ *
+ * \returns NULL, having logged why, if the file cannot be read or is invalid.
+ * \sa replay_term
+ */
+replay_t *replay_load(char const *path);
+
+void replay_term(replay_t *replay);
+
+/**
+ * Play a loaded recording back into a fresh match as fast as possible, with
+ * no window and no frame pacing, and report how it ends.
+ *
+ * \returns false if out of memory, or (having logged both outcomes) if the
+ *          match did not end as recorded.
+ */
+bool replay_play(replay_t const *replay, match_result_t *result);
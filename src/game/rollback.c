@@ -0,0 +1,424 @@
+#include <limits.h>
+#include <string.h>
+
+#include <log.h>
+
+#include "actions.h"
+#include "alloc.h"
+#include "profile/profile.h"
+#include "rollback.h"
+
+// Ticks of input and snapshots kept, by tick modulo this. Must cover the
+// rollback window, plus how far ahead peers send input.
+#define HISTORY 64
+
+// Most inputs one packet carries; unacknowledged ones are sent again each tick.
+#define INPUTS_PER_PACKET 32
+
+// Silence from the peer, in milliseconds, after which it is given up on.
+#define DISCONNECT_MS 3000
+
+// Fewest ticks between two waits to fall back in step with the peer.
+#define TIME_SYNC_INTERVAL 8
+
+// Copies of the last packet sent, so a peer still finishing gets one.
+#define FINAL_PACKET_COPIES 4
+
+#define NO_TICK ULONG_MAX
+
+_Static_assert(HISTORY >= 2 * ROLLBACK_WINDOW + INPUTS_PER_PACKET,
+               "history must cover the rollback window and the peer's lead");
+_Static_assert(HISTORY > ROLLBACK_WINDOW + ROLLBACK_MAX_INPUT_DELAY,
+               "history must hold input delayed the most past the rollback window");
+
+typedef enum {
+    PACKET_SYNC = 1, // Player 1 proposes the match: seed, field.
+    PACKET_SYNC_ACK, // Player 2 has started it.
+    PACKET_INPUT,    // Inputs from one tick on, acknowledgement, time sync.
+} packet_type_t;
+
+typedef struct rollback_s {
+    link_t *link;
+    rollback_config_t config;
+    match_t *match; // NULL until the peers agree on how to start it.
+    rollback_status_t status;
+    uint64_t heard_ms; // When the peer was last heard from.
+    rollback_stats_t stats;
+
+    // --- Input, by tick % HISTORY
+    uint8_t local_inputs[HISTORY];
+    unsigned long local_end; // Local input is known for ticks [0, local_end).
+    uint8_t remote_inputs[HISTORY];
+    unsigned long remote_end; // The peer's input is known for [0, remote_end).
+    uint8_t guesses[HISTORY]; // Peer's input ticks from remote_end were run with.
+    unsigned long acked;      // The peer has our input for [0, acked).
+    unsigned long mispredicted; // Earliest tick run on a wrong guess, or NO_TICK.
+
+    // --- Time sync
+    unsigned long remote_tick; // The peer's tick when it last sent.
+    int remote_advantage;      // How many ticks ahead of us it thought it was.
+    unsigned long synced_tick; // Last tick waited out to keep in step.
+
+    // --- Ending
+    unsigned long end_tick; // Ticks run when the match ended (0: it has not).
+
+    match_snapshot_t snapshots[HISTORY]; // State before each tick.
+} rollback_t;
+
+// -----------------------------------------------------------------------------
+// Packets
+// -----------------------------------------------------------------------------
+
+static void put_u32(uint8_t *bytes, uint32_t value) {
+    for (int byte = 0; byte < 4; byte++) {
+        bytes[byte] = value >> (8 * byte);
+    }
+}
+
+static uint32_t get_u32(uint8_t const *bytes) {
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static void put_u64(uint8_t *bytes, uint64_t value) {
+    put_u32(bytes, value);
+    put_u32(bytes + 4, value >> 32);
+}
+
+static uint64_t get_u64(uint8_t const *bytes) {
+    return get_u32(bytes) | (uint64_t)get_u32(bytes + 4) << 32;
+}
+
+static void send_sync(rollback_t *session, uint64_t now_ms) {
+    uint8_t packet[25];
+    packet[0] = PACKET_SYNC;
+    put_u64(&packet[1], session->config.seed);
+    put_u32(&packet[9], session->config.field.x);
+    put_u32(&packet[13], session->config.field.y);
+    put_u32(&packet[17], session->config.field.w);
+    put_u32(&packet[21], session->config.field.h);
+    link_send(session->link, packet, sizeof packet, now_ms);
+}
+
+static void send_sync_ack(rollback_t *session, uint64_t now_ms) {
+    uint8_t packet[1] = {PACKET_SYNC_ACK};
+    link_send(session->link, packet, sizeof packet, now_ms);
+}
+
+/**
+ * Send every input the peer has not acknowledged (up to a packetful), what we
+ * have of its input, and where we are.
+ */
+static void send_input(rollback_t *session, uint64_t now_ms) {
+    unsigned long tick  = session->match->tick_count;
+    unsigned long first = session->acked;
+    if (session->local_end - first > HISTORY) {
+        first = session->local_end - HISTORY;
+    }
+    unsigned long count = session->local_end - first;
+    if (count > INPUTS_PER_PACKET) {
+        count = INPUTS_PER_PACKET;
+    }
+
+    long advantage = (long)tick - (long)session->remote_tick;
+    advantage      = advantage < INT8_MIN ? INT8_MIN : advantage;
+    advantage      = advantage > INT8_MAX ? INT8_MAX : advantage;
+
+    uint8_t packet[15 + INPUTS_PER_PACKET];
+    packet[0] = PACKET_INPUT;
+    put_u32(&packet[1], first);
+    packet[5] = count;
+    put_u32(&packet[6], session->remote_end);
+    put_u32(&packet[10], tick);
+    packet[14] = (uint8_t)(int8_t)advantage;
+    for (unsigned long index = 0; index < count; index++) {
+        packet[15 + index] = session->local_inputs[(first + index) % HISTORY];
+    }
+    link_send(session->link, packet, 15 + count, now_ms);
+}
+
+// -----------------------------------------------------------------------------
+// Simulation
+// -----------------------------------------------------------------------------
+
+static bool start_match(rollback_t *session, uint64_t seed, aabb_t field) {
+    session->match = match_init(&(match_config_t){
+        .field         = field,
+        .seed          = seed,
+        .is_unattended = true,
+        .jobs          = session->config.jobs,
+    });
+    if (!session->match) {
+        log_error("Cannot initialize networked match");
+        return false;
+    }
+
+    // The first ticks come before any input could have arrived.
+    memset(session->local_inputs, 0, sizeof session->local_inputs);
+    session->local_end = session->config.input_delay;
+    session->status    = ROLLBACK_RUNNING;
+    log_info("Connected; playing as player %d", session->config.player);
+    return true;
+}
+
+/**
+ * Run the match's next tick on both players' input, guessing the peer's if it
+ * has not arrived.
+ */
+static void simulate(rollback_t *session) {
+    match_t *match     = session->match;
+    unsigned long tick = match->tick_count;
+    size_t slot        = tick % HISTORY;
+
+    uint8_t remote;
+    if (tick < session->remote_end) {
+        remote = session->remote_inputs[slot];
+    } else {
+        remote = session->remote_end
+                     ? session->remote_inputs[(session->remote_end - 1) % HISTORY]
+                     : 0;
+        session->guesses[slot] = remote;
+    }
+    uint8_t local = session->local_inputs[slot];
+    uint8_t p1    = session->config.player == 1 ? local : remote;
+    uint8_t p2    = session->config.player == 1 ? remote : local;
+
+    bool actions[ACTION_COUNT] = {0};
+    actions[P1_UP]             = p1 & ROLLBACK_UP;
+    actions[P1_DOWN]           = p1 & ROLLBACK_DOWN;
+    actions[P2_UP]             = p2 & ROLLBACK_UP;
+    actions[P2_DOWN]           = p2 & ROLLBACK_DOWN;
+
+    match_save(match, &session->snapshots[slot]);
+    if ((p1 | p2) & ROLLBACK_QUIT) {
+        match_trigger(match, QUIT_GAME_TRIGGER);
+    }
+    match_tick(match, actions, 1.0f / session->config.tick_rate);
+
+    if (match_get_state(match) == TERM_STATE && !session->end_tick) {
+        session->end_tick = match->tick_count;
+    }
+}
+
+/**
+ * Rewind to the first tick run on a wrong guess, and run every tick since
+ * again with what is now known.
+ */
+static void roll_back(rollback_t *session) {
+    profile_zone_t zone = profile_begin("rollback");
+
+    match_t *match     = session->match;
+    unsigned long tick = match->tick_count;
+    unsigned long from = session->mispredicted;
+
+    match_load(match, &session->snapshots[from % HISTORY]);
+    if (session->end_tick > from) {
+        session->end_tick = 0;
+    }
+    while (match->tick_count < tick) {
+        simulate(session);
+    }
+
+    unsigned long depth = tick - from;
+    session->stats.rollback_count++;
+    session->stats.resimulated += depth;
+    if (depth > session->stats.max_depth) {
+        session->stats.max_depth = depth;
+    }
+    session->mispredicted = NO_TICK;
+    profile_end(&zone);
+}
+
+/**
+ * Should this tick be waited out rather than run?
+ */
+static bool should_wait(rollback_t *session) {
+    unsigned long tick = session->match->tick_count;
+
+    // Too far ahead of the peer's input to guess any more.
+    if (tick >= session->remote_end + ROLLBACK_WINDOW) {
+        return true;
+    }
+
+    // Both peers see the other behind by the one-way latency; any more than
+    // that on our side means we started (or ran) early. Wait, a tick at a time.
+    long advantage = (long)tick - (long)session->remote_tick;
+    if (advantage - session->remote_advantage >= 2 &&
+        tick - session->synced_tick >= TIME_SYNC_INTERVAL) {
+        session->synced_tick = tick;
+        return true;
+    }
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Receiving
+// -----------------------------------------------------------------------------
+
+static void receive_input(rollback_t *session, uint8_t const *packet, size_t size) {
+    if (size < 15 || size < 15u + packet[5]) {
+        return;
+    }
+    unsigned long first       = get_u32(&packet[1]);
+    unsigned long count       = packet[5];
+    unsigned long ack         = get_u32(&packet[6]);
+    unsigned long remote_tick = get_u32(&packet[10]);
+
+    if (ack > session->acked && ack <= session->local_end) {
+        session->acked = ack;
+    }
+    if (remote_tick >= session->remote_tick) {
+        session->remote_tick      = remote_tick;
+        session->remote_advantage = (int8_t)packet[14];
+    }
+
+    unsigned long tick = session->match->tick_count;
+    for (unsigned long index = 0; index < count; index++) {
+        unsigned long input_tick = first + index;
+        if (input_tick < session->remote_end) {
+            continue; // Had it already.
+        }
+        if (input_tick > session->remote_end ||
+            input_tick >= tick + HISTORY - ROLLBACK_WINDOW) {
+            break; // Earlier input went missing, or too far ahead to keep.
+        }
+
+        uint8_t input                                 = packet[15 + index];
+        session->remote_inputs[input_tick % HISTORY] = input;
+        session->remote_end++;
+
+        bool is_misguessed = input_tick < tick &&
+                             session->guesses[input_tick % HISTORY] != input;
+        if (is_misguessed && input_tick < session->mispredicted) {
+            session->mispredicted = input_tick;
+        }
+    }
+}
+
+static void receive_sync(rollback_t *session, uint8_t const *packet, size_t size,
+                         uint64_t now_ms) {
+    if (size < 25 || session->config.player != 2) {
+        return;
+    }
+    if (!session->match) {
+        aabb_t field = {(int32_t)get_u32(&packet[9]), (int32_t)get_u32(&packet[13]),
+                        (int32_t)get_u32(&packet[17]), (int32_t)get_u32(&packet[21])};
+        if (!start_match(session, get_u64(&packet[1]), field)) {
+            return;
+        }
+    }
+    // Acknowledge every proposal, in case an earlier acknowledgement was lost.
+    send_sync_ack(session, now_ms);
+}
+
+static void receive_all(rollback_t *session, uint64_t now_ms) {
+    uint8_t packet[LINK_PACKET_MAX];
+    size_t size;
+    while ((size = link_receive(session->link, packet, sizeof packet, now_ms))) {
+        session->heard_ms = now_ms;
+
+        switch (packet[0]) {
+        case PACKET_SYNC:
+            receive_sync(session, packet, size, now_ms);
+            break;
+        case PACKET_SYNC_ACK:
+        case PACKET_INPUT:
+            // Either means player 2 has started; so can player 1.
+            if (!session->match && session->config.player == 1 &&
+                !start_match(session, session->config.seed, session->config.field)) {
+                break;
+            }
+            if (packet[0] == PACKET_INPUT && session->match) {
+                receive_input(session, packet, size);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Session Interface
+// -----------------------------------------------------------------------------
+
+rollback_status_t rollback_tick(rollback_t *session, unsigned input, uint64_t now_ms) {
+    receive_all(session, now_ms);
+
+    if (session->status == ROLLBACK_CONNECTING) {
+        if (session->config.player == 1) {
+            send_sync(session, now_ms);
+        }
+        session->heard_ms = now_ms;
+        return session->status;
+    }
+    if (session->status != ROLLBACK_RUNNING) {
+        return session->status;
+    }
+
+    if (session->mispredicted < session->match->tick_count) {
+        roll_back(session);
+    }
+
+    if (should_wait(session)) {
+        session->stats.stall_count++;
+    } else {
+        session->local_inputs[session->local_end++ % HISTORY] = input;
+        if (session->match->tick_count >= session->remote_end) {
+            session->stats.predicted_ticks++;
+        }
+        simulate(session);
+    }
+
+    // --- Ending
+    unsigned long end = session->end_tick;
+    if (end && session->remote_end >= end && session->acked >= end) {
+        for (int copy = 0; copy < FINAL_PACKET_COPIES; copy++) {
+            send_input(session, now_ms);
+        }
+        session->status = ROLLBACK_FINISHED;
+        return session->status;
+    }
+    send_input(session, now_ms);
+
+    if (now_ms - session->heard_ms > DISCONNECT_MS) {
+        log_warn("Nothing heard from peer for %d ms", DISCONNECT_MS);
+        session->status = ROLLBACK_DISCONNECTED;
+    }
+    return session->status;
+}
+
+match_t *rollback_get_match(rollback_t *session) { return session->match; }
+
+void rollback_get_stats(rollback_t const *session, rollback_stats_t *stats) {
+    *stats = session->stats;
+}
+
+// -----------------------------------------------------------------------------
+// Lifecycle
+// -----------------------------------------------------------------------------
+
+rollback_t *rollback_init(link_t *link, rollback_config_t const *config) {
+    if (config->input_delay > ROLLBACK_MAX_INPUT_DELAY) {
+        log_error("Cannot delay input %d ticks; the most is %d", config->input_delay,
+                  ROLLBACK_MAX_INPUT_DELAY);
+        return NULL;
+    }
+    rollback_t *session = new (rollback_t);
+    if (!session) {
+        return NULL;
+    }
+    memset(session, 0, sizeof *session);
+    session->link         = link;
+    session->config       = *config;
+    session->status       = ROLLBACK_CONNECTING;
+    session->mispredicted = NO_TICK;
+    return session;
+}
+
+void rollback_term(rollback_t *session) {
+    if (!session) {
+        return;
+    }
+    match_term(session->match);
+    delete (session);
+}
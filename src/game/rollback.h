@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aabb.h"
+#include "jobs/jobs.h"
+#include "match.h"
+#include "net/link.h"
+
+// Most ticks the simulation runs ahead of the peer's confirmed input, guessing
+// the rest; beyond that it waits for the peer.
+#define ROLLBACK_WINDOW 16
+
+// Most ticks local input may wait before it applies.
+#define ROLLBACK_MAX_INPUT_DELAY ROLLBACK_WINDOW
+
+/**
+ * Buttons one player holds during a tick.
+ */
+typedef enum {
+  ROLLBACK_UP   = 1 << 0,
+  ROLLBACK_DOWN = 1 << 1,
+  ROLLBACK_QUIT = 1 << 2, // Ends the match for both players, on the same tick.
+} rollback_input_t;
+
+typedef enum {
+  ROLLBACK_CONNECTING,   // Agreeing with the peer on how to start the match.
+  ROLLBACK_RUNNING,      // Playing.
+  ROLLBACK_FINISHED,     // The match ended, on input both peers have.
+  ROLLBACK_DISCONNECTED, // The peer went silent.
+} rollback_status_t;
+
+/**
+ * Rollback Session Configuration Parameters.
+ */
+typedef struct {
+  unsigned char player;      // 1 or 2: the paddle this peer plays.
+  unsigned char input_delay; // Ticks local input waits before it applies.
+  unsigned short tick_rate;  // Simulation ticks per simulated second.
+  aabb_t field;              // Playing field (player 1's is used).
+  uint64_t seed;             // Seeds the match (player 1's is used).
+  job_system_t *jobs;        // Passed on to the match (not owned).
+} rollback_config_t;
+
+/**
+ * Running totals of how much work rollback has done.
+ */
+typedef struct {
+  unsigned long rollback_count;  // Times a guess was wrong and ticks were redone.
+  unsigned long resimulated;     // Ticks simulated again in total.
+  unsigned long max_depth;       // Most ticks redone at once.
+  unsigned long stall_count;     // Ticks waited out, for the peer or time sync.
+  unsigned long predicted_ticks; // Ticks first simulated on a guessed input.
+} rollback_stats_t;
+
+typedef struct rollback_s rollback_t;
+
+/**
+ * Start a two-player match with a peer over `link`.
+ *
+ * Each peer simulates the whole match. Local input is sent to the peer every
+ * tick and applied after `input_delay` ticks. The peer's input, which arrives
+ * later, is guessed (as whatever it held last) so the match never waits for
+ * it. When the real input turns out different, the match is restored to the
+ * tick it arrived for and every tick since simulated again, all before the
+ * current tick is shown. Both peers therefore see the same match, and local
+ * input shows after the input delay whatever the round trip.
+ *
+ * The match is created once the peers have agreed on the seed and field.
+ * Matches are unattended: they start at once and end at game over.
+ *
+ * \returns NULL if `input_delay` is over ROLLBACK_MAX_INPUT_DELAY, or if out of
+ *          memory.
+ * \sa rollback_term
+ */
+rollback_t *rollback_init(link_t *link, rollback_config_t const *config);
+
+void rollback_term(rollback_t *session);
+
+/**
+ * Advance the session by one tick of local time, holding `input`.
+ *
+ * Receives whatever the peer sent, rolls back if a guess was wrong, then
+ * simulates the next tick, unless too far ahead of the peer to guess any more,
+ * or ahead of it in time, in which case the tick is waited out.
+ *
+ * \param input Bitwise or of rollback_input_t.
+ * \param now_ms Current time, from any steady clock.
+ */
+rollback_status_t rollback_tick(rollback_t *session, unsigned input, uint64_t now_ms);
+
+/**
+ * Get the match being played, or NULL while still connecting.
+ */
+match_t *rollback_get_match(rollback_t *session);
+
+void rollback_get_stats(rollback_t const *session, rollback_stats_t *stats);
@@ -0,0 +1,94 @@
+#include <SDL2/SDL.h>
+
+#include <log.h>
+
+#include "aabb.h"
+#include "alloc.h"
+#include "match.h"
+#include "runner.h"
+
+/**
+ * Shared by every worker of one run.
+ */
+typedef struct {
+    runner_config_t const *config;
+    match_result_t *results;
+    SDL_atomic_t next_match; // Index of the next unclaimed match.
+} runner_t;
+
+/**
+ * Play one match to the end, or until it runs out of ticks.
+ */
+static match_result_t play_match(runner_config_t const *config, size_t index) {
+    match_result_t result = {0};
+
+    match_t *match = match_init(&(match_config_t){
+        .field         = config->field,
+        .seed          = config->seed + index,
+        .is_unattended = true,
+    });
+    if (!match) {
+        return result;
+    }
+
+    float const tick_delta = 1.0f / config->tick_rate;
+    while (match_get_state(match) != TERM_STATE) {
+        if (config->tick_limit && match->tick_count >= config->tick_limit) {
+            break;
+        }
+        match_tick(match, NULL, tick_delta);
+    }
+
+    result.score_1     = player_get_score(&match->player_1);
+    result.score_2     = player_get_score(&match->player_2);
+    result.tick_count  = match->tick_count;
+    result.is_finished = match_get_state(match) == TERM_STATE;
+    match_term(match);
+    return result;
+}
+
+/**
+ * Claim and play matches until none are left.
+ */
+static int run_worker(void *context) {
+    runner_t *runner = context;
+    size_t index;
+    while ((index = SDL_AtomicAdd(&runner->next_match, 1)) <
+           runner->config->match_count) {
+        runner->results[index] = play_match(runner->config, index);
+    }
+    return 0;
+}
+
+bool runner_run(runner_config_t const *config, match_result_t *results) {
+    runner_t runner = {.config = config, .results = results};
+    SDL_AtomicSet(&runner.next_match, 0);
+
+    unsigned thread_count = config->thread_count ? config->thread_count
+                                                 : (unsigned)SDL_GetCPUCount();
+    if (thread_count > config->match_count) {
+        thread_count = config->match_count ? config->match_count : 1;
+    }
+
+    // Kernel selection is global; settle it before any worker collides.
+    aabb_kernel_select(aabb_kernel_detect());
+
+    // --- Workers, the calling thread being the first
+    SDL_Thread **threads = new_array(thread_count, SDL_Thread *);
+    if (!threads) {
+        return false;
+    }
+    for (unsigned worker = 1; worker < thread_count; worker++) {
+        if (!(threads[worker] = SDL_CreateThread(run_worker, "runner", &runner))) {
+            log_warn("Cannot start runner worker %u: %s", worker, SDL_GetError());
+        }
+    }
+
+    run_worker(&runner);
+
+    for (unsigned worker = 1; worker < thread_count; worker++) {
+        SDL_WaitThread(threads[worker], NULL);
+    }
+    delete (threads);
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "aabb.h"
+
+/**
+ * Batch Runner Configuration Parameters.
+ */
+typedef struct {
+  size_t match_count;
+  unsigned thread_count;    // Worker threads (0: one per CPU core).
+  uint64_t seed;            // Match `i` is seeded with `seed + i`.
+  aabb_t field;             // Playing field of every match.
+  unsigned short tick_rate; // Simulation ticks per simulated second.
+  unsigned long tick_limit; // Give up on a match after this many ticks (0: never).
+} runner_config_t;
+
+/**
+ * Outcome of one unattended match.
+ */
+typedef struct {
+  unsigned short score_1;
+  unsigned short score_2;
+  unsigned long tick_count;
+  bool is_finished; // False if the match ran out of ticks or memory.
+} match_result_t;
+
+/**
+ * Play `config->match_count` independent unattended matches on a pool of
+ * worker threads, writing each outcome to the same index of `results`.
+ *
+ * Each match runs start to finish on one worker, so matches share nothing
+ * while they run. Results depend only on the seed, never on thread count.
+ *
+ * The calling thread works too, so a run proceeds (more slowly) even if no
+ * other worker can be started.
+ *
+ * \returns false if out of memory.
+ */
+bool runner_run(runner_config_t const *config, match_result_t *results);
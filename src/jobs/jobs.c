@@ -0,0 +1,332 @@
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#include <SDL2/SDL.h>
+
+#include <log.h>
+
+#include "alloc.h"
+#include "jobs.h"
+
+// Jobs one deque holds (a power of two); a thread whose deque is full works on
+// the job itself instead.
+#define DEQUE_CAPACITY 256
+
+// Fruitless searches for work a waiting thread makes before yielding its core.
+#define SPINS_BEFORE_YIELD 64
+
+/**
+ * Part of a parallel loop, split off by a thread for others to steal.
+ *
+ * Lives on the stack of the thread that split it, which does not return until
+ * `pending` drops to zero.
+ */
+typedef struct {
+    job_fn_t fn;
+    void *context;
+    size_t first;
+    size_t count;
+    size_t grain;
+    atomic_int *pending; // Jobs the splitting thread still waits on.
+} job_t;
+
+/**
+ * Bounded Chase-Lev deque.
+ *
+ * Only the owning thread moves `bottom`, pushing and popping jobs there; any
+ * thread may steal from `top`, which only ever grows. The owner and thieves
+ * only contend, through `top`, for the last job left.
+ */
+typedef struct {
+    atomic_llong top;
+    atomic_llong bottom;
+    job_t *_Atomic slots[DEQUE_CAPACITY];
+} deque_t;
+
+typedef struct {
+    job_system_t *jobs;
+    unsigned index;
+    SDL_Thread *thread; // NULL for the thread that made the system.
+    deque_t deque;
+} worker_t;
+
+typedef struct job_system_s {
+    unsigned thread_count;
+    worker_t *workers; // The first belongs to the thread that made the system.
+    SDL_sem *wakeup;   // Posted once for every job pushed.
+    atomic_bool is_stopping;
+} job_system_t;
+
+/** Worker the calling thread runs, if it was started by a job system. */
+static _Thread_local worker_t *current_worker = NULL;
+
+// -----------------------------------------------------------------------------
+// Deque
+// -----------------------------------------------------------------------------
+
+static void deque_init(deque_t *deque) {
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    for (size_t slot = 0; slot < DEQUE_CAPACITY; slot++) {
+        atomic_init(&deque->slots[slot], NULL);
+    }
+}
+
+/**
+ * Push `job` onto the bottom of the deque (owner only).
+ *
+ * \returns false if the deque is full.
+ */
+static bool deque_push(deque_t *deque, job_t *job) {
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long long top    = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (bottom - top >= DEQUE_CAPACITY) {
+        return false;
+    }
+
+    atomic_store_explicit(&deque->slots[bottom & (DEQUE_CAPACITY - 1)], job,
+                          memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_release);
+    return true;
+}
+
+/**
+ * Pop the most recently pushed job off the bottom of the deque (owner only).
+ */
+static job_t *deque_pop(deque_t *deque) {
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    job_t *job = atomic_load_explicit(&deque->slots[bottom & (DEQUE_CAPACITY - 1)],
+                                      memory_order_relaxed);
+    if (top == bottom) {
+        // The last job: whoever moves `top` past it first gets it.
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+            job = NULL;
+        }
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+/**
+ * Steal the oldest job off the top of the deque (any thread).
+ *
+ * \returns NULL if the deque is empty or another thread got there first.
+ */
+static job_t *deque_steal(deque_t *deque) {
+    long long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (top >= bottom) {
+        return NULL;
+    }
+
+    job_t *job = atomic_load_explicit(&deque->slots[top & (DEQUE_CAPACITY - 1)],
+                                      memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+                                                 memory_order_seq_cst,
+                                                 memory_order_relaxed)) {
+        return NULL;
+    }
+    return job;
+}
+
+// -----------------------------------------------------------------------------
+// Scheduling
+// -----------------------------------------------------------------------------
+
+static void run_range(worker_t *self, job_fn_t fn, void *context, size_t first,
+                      size_t count, size_t grain);
+
+/**
+ * Find a job: the newest of our own, else the oldest of the next thread's that
+ * has any.
+ */
+static job_t *find_job(worker_t *self) {
+    job_t *job = deque_pop(&self->deque);
+
+    job_system_t *jobs = self->jobs;
+    for (unsigned offset = 1; !job && offset < jobs->thread_count; offset++) {
+        worker_t *victim = &jobs->workers[(self->index + offset) % jobs->thread_count];
+        job              = deque_steal(&victim->deque);
+    }
+    return job;
+}
+
+static void run_job(worker_t *self, job_t *job) {
+    atomic_int *pending = job->pending;
+    run_range(self, job->fn, job->context, job->first, job->count, job->grain);
+
+    // The job is gone once its splitter sees this.
+    atomic_fetch_sub_explicit(pending, 1, memory_order_release);
+}
+
+/**
+ * Work on other jobs until `pending` drops to zero.
+ */
+static void wait_for(worker_t *self, atomic_int *pending) {
+    unsigned spins = 0;
+    while (atomic_load_explicit(pending, memory_order_acquire)) {
+        job_t *job = find_job(self);
+        if (job) {
+            run_job(self, job);
+            spins = 0;
+        } else if (++spins == SPINS_BEFORE_YIELD) {
+            SDL_Delay(0);
+            spins = 0;
+        }
+    }
+}
+
+/**
+ * Run items [first, first + count), splitting off the upper half for thieves
+ * until a single chunk is left.
+ */
+static void run_range(worker_t *self, job_fn_t fn, void *context, size_t first,
+                      size_t count, size_t grain) {
+    if (count <= grain) {
+        fn(context, first, count);
+        return;
+    }
+
+    size_t chunk_count = (count + grain - 1) / grain;
+    size_t lower_count = chunk_count / 2 * grain;
+
+    atomic_int pending;
+    atomic_init(&pending, 1);
+    job_t upper = {fn, context, first + lower_count, count - lower_count, grain,
+                   &pending};
+
+    bool is_pushed = deque_push(&self->deque, &upper);
+    if (is_pushed) {
+        SDL_SemPost(self->jobs->wakeup);
+    }
+
+    run_range(self, fn, context, first, lower_count, grain);
+
+    if (is_pushed) {
+        wait_for(self, &pending);
+    } else {
+        run_range(self, fn, context, upper.first, upper.count, grain);
+    }
+}
+
+/**
+ * Sleep until jobs are pushed, then steal until none are left.
+ */
+static int run_worker(void *context) {
+    worker_t *self = context;
+    current_worker = self;
+
+    while (true) {
+        SDL_SemWait(self->jobs->wakeup);
+        if (atomic_load(&self->jobs->is_stopping)) {
+            return 0;
+        }
+
+        job_t *job;
+        while ((job = find_job(self))) {
+            run_job(self, job);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Job System Interface
+// -----------------------------------------------------------------------------
+
+void job_parallel_for(job_system_t *jobs, job_fn_t fn, void *context, size_t count,
+                      size_t grain) {
+    if (!grain) {
+        grain = 1;
+    }
+
+    // Nobody to share with: the chunks, in order.
+    if (!jobs || jobs->thread_count == 1 || count <= grain) {
+        for (size_t first = 0; first < count; first += grain) {
+            fn(context, first, count - first < grain ? count - first : grain);
+        }
+        return;
+    }
+
+    worker_t *self = current_worker && current_worker->jobs == jobs ? current_worker
+                                                                   : &jobs->workers[0];
+    run_range(self, fn, context, 0, count, grain);
+}
+
+unsigned job_system_get_thread_count(job_system_t const *jobs) {
+    return jobs->thread_count;
+}
+
+// -----------------------------------------------------------------------------
+// Lifecycle
+// -----------------------------------------------------------------------------
+
+job_system_t *job_system_init(unsigned thread_count) {
+    if (!thread_count) {
+        thread_count = (unsigned)SDL_GetCPUCount();
+    }
+
+    job_system_t *jobs = new (job_system_t);
+    if (!jobs) {
+        return NULL;
+    }
+    jobs->thread_count = thread_count ? thread_count : 1;
+    jobs->workers      = new_array(jobs->thread_count, worker_t);
+    jobs->wakeup       = SDL_CreateSemaphore(0);
+    atomic_init(&jobs->is_stopping, false);
+
+    if (!jobs->workers || !jobs->wakeup) {
+        if (jobs->wakeup) {
+            SDL_DestroySemaphore(jobs->wakeup);
+        }
+        delete (jobs->workers);
+        delete (jobs);
+        return NULL;
+    }
+
+    for (unsigned index = 0; index < jobs->thread_count; index++) {
+        worker_t *worker = &jobs->workers[index];
+        worker->jobs     = jobs;
+        worker->index    = index;
+        worker->thread   = NULL;
+        deque_init(&worker->deque);
+    }
+
+    // --- Workers, the calling thread being the first
+    for (unsigned index = 1; index < jobs->thread_count; index++) {
+        worker_t *worker = &jobs->workers[index];
+        if (!(worker->thread = SDL_CreateThread(run_worker, "jobs", worker))) {
+            log_warn("Cannot start job worker %u: %s", index, SDL_GetError());
+        }
+    }
+    return jobs;
+}
+
+void job_system_term(job_system_t *jobs) {
+    if (!jobs) {
+        return;
+    }
+
+    atomic_store(&jobs->is_stopping, true);
+    for (unsigned index = 1; index < jobs->thread_count; index++) {
+        SDL_SemPost(jobs->wakeup);
+    }
+    for (unsigned index = 1; index < jobs->thread_count; index++) {
+        SDL_WaitThread(jobs->workers[index].thread, NULL);
+    }
+
+    SDL_DestroySemaphore(jobs->wakeup);
+    delete (jobs->workers);
+    delete (jobs);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stddef.h>
+
+typedef struct job_system_s job_system_t;
+
+/**
+ * Work on items [first, first + count) of a parallel loop.
+ *
+ * `first` is always a multiple of the loop's grain, so `first / grain` numbers
+ * the chunk, whichever thread happens to run it.
+ */
+typedef void (*job_fn_t)(void *context, size_t first, size_t count);
+
+/**
+ * Initialize a work-stealing job system of `thread_count` threads, the thread
+ * calling this being the first.
+ *
+ * Each thread owns a deque of jobs: it pushes and pops its own at the bottom,
+ * while idle threads steal from the top of others'. Threads with nothing left
+ * to steal sleep until new jobs are pushed.
+ *
+ * \param thread_count Threads, including the caller (0: one per CPU core).
+ * \returns NULL if out of memory.
+ * \sa job_system_term
+ */
+job_system_t *job_system_init(unsigned thread_count);
+
+/**
+ * Terminate a job system; no loop may still be running on it.
+ */
+void job_system_term(job_system_t *jobs);
+
+/**
+ * Get the number of threads running jobs, including the one that made them.
+ */
+unsigned job_system_get_thread_count(job_system_t const *jobs);
+
+/**
+ * Run `fn` over items [0, count) in chunks of `grain` items, and return once
+ * every chunk is done.
+ *
+ * Chunk boundaries depend only on `count` and `grain`, so work split by chunk
+ * and merged in chunk order gives the same result on any number of threads.
+ * Ranges are halved recursively: one half is pushed for thieves, the other
+ * worked on, and the thread then helps with whatever jobs remain until its
+ * half has been finished. Loops may nest.
+ *
+ * May be called from within a job, or by one other thread at a time (such as
+ * the one that initialized `jobs`).
+ *
+ * \param jobs Job system, or NULL to run every chunk in order on the caller.
+ */
+void job_parallel_for(job_system_t *jobs, job_fn_t fn, void *context, size_t count,
+                      size_t grain);
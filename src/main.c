@@ -1,12 +1,206 @@
+#include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include <SDL2/SDL.h>
-#include <SDL2/SDL_ttf.h>
 
+#include "aabb.h"
+#include "alloc.h"
 #include "app/app.h"
 #include "game/game.h"
+#include "game/replay.h"
+#include "game/rollback.h"
+#include "game/runner.h"
 
-int main(void) {
+/** Options for the game itself, or for replaying instead. */
+typedef struct {
+    char const *replay_path; // Replay this recording instead (NULL: don't).
+    game_config_t game;
+    link_config_t peer; // Used by the game if a remote host is given.
+} game_options_t;
+
+/**
+ * Split HOST:PORT (in place) into the peer's host and port.
+ */
+static bool parse_peer(char *address, link_config_t *peer) {
+    char *colon = strrchr(address, ':');
+    if (!colon || colon == address) {
+        return false;
+    }
+    *colon            = '\0';
+    peer->remote_host = address;
+    peer->remote_port = strtoul(colon + 1, NULL, 10);
+    return peer->remote_port != 0;
+}
+
+/**
+ * Apply command-line options to `config`.
+ *
+ *   --headless         Simulate without a window, as fast as possible.
+ *   --ticks N          Stop after N simulation ticks.
+ *   --tick-rate N      Simulate N ticks per simulated second.
+ *   --frame-rate N     Pace frames to N per second (0: unpaced; default: 60).
+ *   --vsync            Pace frames to the display instead, if the driver allows.
+ *   --single-thread    Tick on the main thread, between frames, instead of apart.
+ *   --profile PATH     Profile from launch; write a Chrome trace to PATH at exit.
+ *                      Without it, F9 still toggles profiling (to trace.json).
+ *   --matches N        Play N headless matches in parallel instead, and report.
+ *   --threads N        Run those matches on N threads (default: one per core).
+ *   --seed N           Seed the first of those matches with N (default: time).
+ *   --record PATH      Record the match's seed and input to PATH.
+ *   --replay PATH      Replay a recording instead, without a window, at full speed.
+ *   --peer HOST:PORT   Play against a peer at HOST:PORT, over UDP.
+ *   --port N           Receive from the peer on UDP port N (default: 7000).
+ *   --player N         Play as player 1 (default; proposes the match) or 2.
+ *   --input-delay N    Apply local input N ticks after it is sampled (default: 1,
+ *                      at most 16).
+ *   --net-latency MS   Hold every packet sent back by MS milliseconds.
+ *   --net-loss PCT     Drop PCT percent of packets sent.
+ */
+static bool parse_args(int argc, char *argv[], app_config_t *config,
+                       runner_config_t *runner_config, game_options_t *options) {
+    for (int index = 1; index < argc; index++) {
+        if (!strcmp(argv[index], "--headless")) {
+            config->is_headless = 1;
+        } else if (!strcmp(argv[index], "--ticks") && index + 1 < argc) {
+            config->tick_limit = strtoul(argv[++index], NULL, 10);
+        } else if (!strcmp(argv[index], "--tick-rate") && index + 1 < argc) {
+            config->tick_rate = strtoul(argv[++index], NULL, 10);
+        } else if (!strcmp(argv[index], "--frame-rate") && index + 1 < argc) {
+            config->frame_rate = strtoul(argv[++index], NULL, 10);
+        } else if (!strcmp(argv[index], "--vsync")) {
+            config->is_vsync = 1;
+        } else if (!strcmp(argv[index], "--single-thread")) {
+            config->is_sim_threaded = 0;
+        } else if (!strcmp(argv[index], "--profile") && index + 1 < argc) {
+            config->profile_path = argv[++index];
+        } else if (!strcmp(argv[index], "--matches") && index + 1 < argc) {
+            runner_config->match_count = strtoul(argv[++index], NULL, 10);
+        } else if (!strcmp(argv[index], "--threads") && index + 1 < argc) {
+            runner_config->thread_count = strtoul(argv[++index], NULL, 10);
+        } else if (!strcmp(argv[index], "--seed") && index + 1 < argc) {
+            runner_config->seed = strtoull(argv[++index], NULL, 10);
+        } else if (!strcmp(argv[index], "--record") && index + 1 < argc) {
+            options->game.record_path = argv[++index];
+        } else if (!strcmp(argv[index], "--replay") && index + 1 < argc) {
+            options->replay_path = argv[++index];
+        } else if (!strcmp(argv[index], "--peer") && index + 1 < argc &&
+                   parse_peer(argv[index + 1], &options->peer)) {
+            index++;
+        } else if (!strcmp(argv[index], "--port") && index + 1 < argc) {
+            options->peer.local_port = strtoul(argv[++index], NULL, 10);
+        } else if (!strcmp(argv[index], "--player") && index + 1 < argc) {
+            options->game.player = strtoul(argv[++index], NULL, 10);
+        } else if (!strcmp(argv[index], "--input-delay") && index + 1 < argc) {
+            unsigned long const delay = strtoul(argv[++index], NULL, 10);
+            if (delay > ROLLBACK_MAX_INPUT_DELAY) {
+                fprintf(stderr, "Cannot delay input %lu ticks; the most is %d\n", delay,
+                        ROLLBACK_MAX_INPUT_DELAY);
+                return false;
+            }
+            options->game.input_delay = delay;
+        } else if (!strcmp(argv[index], "--net-latency") && index + 1 < argc) {
+            options->peer.latency_ms = strtoul(argv[++index], NULL, 10);
+        } else if (!strcmp(argv[index], "--net-loss") && index + 1 < argc) {
+            options->peer.loss = strtof(argv[++index], NULL) / 100;
+        } else {
+            fprintf(stderr,
+                    "usage: %s [--headless] [--ticks N] [--tick-rate N] "
+                    "[--frame-rate N] [--vsync] [--single-thread] [--profile PATH] "
+                    "[--matches N [--threads N] [--seed N]] "
+                    "[--record PATH | --replay PATH] "
+                    "[--peer HOST:PORT [--port N] [--player N] [--input-delay N] "
+                    "[--net-latency MS] [--net-loss PCT]]\n",
+                    argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Batch matches without --ticks give up after this much simulated time; a ball
+// rallying flat between two idle paddles never scores.
+#define DEFAULT_MATCH_SECONDS 600
+
+/**
+ * Play a batch of headless matches and summarize them.
+ */
+static int run_matches(app_config_t *config, runner_config_t *runner_config) {
+    aabb_t field              = {0, 0, config->window_width, config->window_height};
+    runner_config->field      = field;
+    runner_config->tick_rate  = config->tick_rate ? config->tick_rate : 60;
+    runner_config->tick_limit = config->tick_limit ? config->tick_limit
+                                                   : runner_config->tick_rate *
+                                                         DEFAULT_MATCH_SECONDS;
+
+    match_result_t *results = new_array(runner_config->match_count, match_result_t);
+    if (!results) {
+        fprintf(stderr, "Cannot allocate results for %zu matches\n",
+                runner_config->match_count);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t const start = SDL_GetPerformanceCounter();
+    bool const is_run    = runner_run(runner_config, results);
+    double const seconds = (SDL_GetPerformanceCounter() - start) /
+                           (double)SDL_GetPerformanceFrequency();
+    if (!is_run) {
+        fprintf(stderr, "Cannot run matches\n");
+        delete (results);
+        return EXIT_FAILURE;
+    }
+
+    size_t wins_1                 = 0;
+    size_t wins_2                 = 0;
+    size_t unfinished             = 0;
+    unsigned long long tick_count = 0;
+    for (size_t index = 0; index < runner_config->match_count; index++) {
+        tick_count += results[index].tick_count;
+        if (!results[index].is_finished) {
+            unfinished++;
+        } else if (results[index].score_1 > results[index].score_2) {
+            wins_1++;
+        } else {
+            wins_2++;
+        }
+    }
+
+    printf("%zu matches in %.3f s (%.0f matches/s, %.0f ticks/s)\n",
+           runner_config->match_count, seconds, runner_config->match_count / seconds,
+           tick_count / seconds);
+    printf("player 1 won %zu, player 2 won %zu, %zu unfinished\n", wins_1, wins_2,
+           unfinished);
+    delete (results);
+    return EXIT_SUCCESS;
+}
+
+/**
+ * Replay a recorded match as fast as possible, and check it ends as it did.
+ */
+static int run_replay(char const *path) {
+    replay_t *replay = replay_load(path);
+    if (!replay) {
+        return EXIT_FAILURE;
+    }
+
+    aabb_kernel_select(aabb_kernel_detect());
+
+    match_result_t result;
+    uint64_t const start      = SDL_GetPerformanceCounter();
+    bool const is_as_recorded = replay_play(replay, &result);
+    double const seconds      = (SDL_GetPerformanceCounter() - start) /
+                           (double)SDL_GetPerformanceFrequency();
+    replay_term(replay);
+
+    printf("Replayed %lu ticks in %.3f ms (%.0f ticks/s): %hu - %hu\n",
+           result.tick_count, seconds * 1000, result.tick_count / seconds,
+           result.score_1, result.score_2);
+    return is_as_recorded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[]) {
     game_t *game = NULL;
 
     app_config_t config = {.window_is_fullscreen = 0,
@@ -14,9 +208,34 @@ int main(void) {
                            .window_height        = 480,
                            .window_position_x    = 128,
                            .window_position_y    = 128,
-                           .window_title         = "Pong"};
+                           .window_title         = "Pong",
+                           .frame_rate           = 60,
+                           .tick_rate            = 60,
+                           .max_ticks_per_frame  = 8,
+                           .is_sim_threaded      = 1};
+
+    runner_config_t runner_config = {.seed = time(NULL)};
+    game_options_t options        = {
+        .game = {.player = 1, .input_delay = 1},
+        .peer = {.local_port = 7000, .seed = time(NULL)},
+    };
 
-    if (!(game = game_init(&config))) {
+    if (!parse_args(argc, argv, &config, &runner_config, &options)) {
+        return EXIT_FAILURE;
+    }
+
+    if (options.replay_path) {
+        return run_replay(options.replay_path);
+    }
+
+    if (runner_config.match_count) {
+        return run_matches(&config, &runner_config);
+    }
+
+    if (options.peer.remote_host) {
+        options.game.peer = &options.peer;
+    }
+    if (!(game = game_init(&config, &options.game))) {
         return EXIT_FAILURE;
     }
 
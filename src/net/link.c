@@ -0,0 +1,151 @@
+#include <string.h>
+
+#include <SDL2/SDL_net.h>
+
+#include <log.h>
+
+#include "alloc.h"
+#include "link.h"
+#include "rng.h"
+
+// Packets one link can hold back for simulated latency (a power of two); any
+// more are sent at once.
+#define HELD_PACKET_CAPACITY 256
+
+/** A packet waiting out the simulated latency. */
+typedef struct {
+    uint64_t send_ms;
+    size_t size;
+    uint8_t data[LINK_PACKET_MAX];
+} held_packet_t;
+
+typedef struct link_s {
+    UDPsocket socket;
+    UDPpacket *packet; // Staging for every send and receive.
+    IPaddress remote;
+    unsigned short latency_ms;
+    float loss;
+    rng_t rng;
+
+    // Ring of held packets; they become due in the order they were sent.
+    held_packet_t *held;
+    size_t held_first;
+    size_t held_count;
+} link_t;
+
+static void send_now(link_t *link, void const *data, size_t size) {
+    memcpy(link->packet->data, data, size);
+    link->packet->len     = size;
+    link->packet->address = link->remote;
+    if (!SDLNet_UDP_Send(link->socket, -1, link->packet)) {
+        log_warn("Cannot send packet: %s", SDLNet_GetError());
+    }
+}
+
+/**
+ * Send every held packet that has waited long enough.
+ */
+static void send_due(link_t *link, uint64_t now_ms) {
+    while (link->held_count) {
+        held_packet_t *held = &link->held[link->held_first];
+        if (held->send_ms > now_ms) {
+            return;
+        }
+        send_now(link, held->data, held->size);
+        link->held_first = (link->held_first + 1) % HELD_PACKET_CAPACITY;
+        link->held_count--;
+    }
+}
+
+void link_send(link_t *link, void const *data, size_t size, uint64_t now_ms) {
+    if (size > LINK_PACKET_MAX) {
+        log_error("Cannot send %zu-byte packet; the most is %d", size,
+                  LINK_PACKET_MAX);
+        return;
+    }
+    if (link->loss > 0 && rng_next_double(&link->rng) < link->loss) {
+        return;
+    }
+    if (!link->latency_ms || link->held_count == HELD_PACKET_CAPACITY) {
+        send_now(link, data, size);
+        return;
+    }
+
+    size_t last         = link->held_first + link->held_count++;
+    held_packet_t *held = &link->held[last % HELD_PACKET_CAPACITY];
+    held->send_ms       = now_ms + link->latency_ms;
+    held->size          = size;
+    memcpy(held->data, data, size);
+}
+
+size_t link_receive(link_t *link, void *buffer, size_t capacity, uint64_t now_ms) {
+    send_due(link, now_ms);
+
+    while (SDLNet_UDP_Recv(link->socket, link->packet) > 0) {
+        // Anyone can send to an open port; only listen to the peer.
+        if (link->packet->address.host != link->remote.host ||
+            link->packet->address.port != link->remote.port) {
+            continue;
+        }
+        size_t size = (size_t)link->packet->len;
+        size        = size < capacity ? size : capacity;
+        memcpy(buffer, link->packet->data, size);
+        return size;
+    }
+    return 0;
+}
+
+link_t *link_init(link_config_t const *config) {
+    if (SDLNet_Init()) {
+        log_error("Cannot initialize networking: %s", SDLNet_GetError());
+        return NULL;
+    }
+
+    link_t *link = new (link_t);
+    if (!link) {
+        SDLNet_Quit();
+        return NULL;
+    }
+    link->socket     = NULL;
+    link->packet     = NULL;
+    link->latency_ms = config->latency_ms;
+    link->loss       = config->loss;
+    link->held       = NULL;
+    link->held_first = 0;
+    link->held_count = 0;
+    rng_init(&link->rng, config->seed);
+
+    if (SDLNet_ResolveHost(&link->remote, config->remote_host, config->remote_port)) {
+        log_error("Cannot resolve %s: %s", config->remote_host, SDLNet_GetError());
+        link_term(link);
+        return NULL;
+    }
+    if (!(link->socket = SDLNet_UDP_Open(config->local_port))) {
+        log_error("Cannot open UDP port %hu: %s", config->local_port,
+                  SDLNet_GetError());
+        link_term(link);
+        return NULL;
+    }
+    link->packet = SDLNet_AllocPacket(LINK_PACKET_MAX);
+    link->held   = new_array(HELD_PACKET_CAPACITY, held_packet_t);
+    if (!link->packet || !link->held) {
+        link_term(link);
+        return NULL;
+    }
+    return link;
+}
+
+void link_term(link_t *link) {
+    if (!link) {
+        return;
+    }
+    if (link->packet) {
+        SDLNet_FreePacket(link->packet);
+    }
+    if (link->socket) {
+        SDLNet_UDP_Close(link->socket);
+    }
+    delete (link->held);
+    delete (link);
+    SDLNet_Quit();
+}
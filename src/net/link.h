@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Largest datagram a link carries.
+#define LINK_PACKET_MAX 256
+
+/**
+ * Link Configuration Parameters.
+ *
+ * Latency and loss are simulated on the sending side, on top of whatever the
+ * network adds, so two peers on one machine can play as if far apart.
+ */
+typedef struct {
+  unsigned short local_port;  // UDP port to receive on.
+  char const *remote_host;    // Peer's host name or address.
+  unsigned short remote_port; // Peer's UDP port.
+  unsigned short latency_ms;  // Extra delay before each packet is sent.
+  float loss;                 // Fraction (0..1) of packets dropped instead.
+  uint64_t seed;              // Decides which packets are dropped.
+} link_config_t;
+
+typedef struct link_s link_t;
+
+/**
+ * Open an unreliable, unordered datagram link to one peer over UDP.
+ *
+ * \returns NULL, having logged why, if the socket cannot be opened or the peer
+ *          cannot be resolved.
+ * \sa link_term
+ */
+link_t *link_init(link_config_t const *config);
+
+void link_term(link_t *link);
+
+/**
+ * Send `size` bytes to the peer, after the simulated latency (if any).
+ *
+ * Packets still held back when the link is terminated are never sent.
+ *
+ * \param now_ms Current time; only compared with other times given to the link.
+ */
+void link_send(link_t *link, void const *data, size_t size, uint64_t now_ms);
+
+/**
+ * Send anything held back whose time has come, then take one packet from the
+ * peer, if any has arrived.
+ *
+ * \returns the size of the packet copied into `buffer`, or 0 if none was.
+ */
+size_t link_receive(link_t *link, void *buffer, size_t capacity, uint64_t now_ms);
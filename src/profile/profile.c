@@ -0,0 +1,181 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include "alloc.h"
+#include "profile.h"
+
+/**
+ * One recorded zone.
+ *
+ * `sequence` is a seqlock: 0 while a writer fills the slot, then the claim
+ * index plus one. A reader only trusts fields read between two equal loads.
+ */
+typedef struct {
+    atomic_uint_least64_t sequence;
+    char const *name;
+    char const *tag;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    unsigned long thread_id;
+} profile_slot_t;
+
+static struct {
+    profile_slot_t *slots;
+    size_t capacity;
+    atomic_uint_least64_t head; // Zones ever claimed; the next claim index.
+    atomic_bool is_enabled;
+} profiler;
+
+static _Thread_local char const *thread_tag = NULL;
+
+// -----------------------------------------------------------------------------
+// Lifecycle
+// -----------------------------------------------------------------------------
+
+bool profile_init(size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+
+    if (!(profiler.slots = new_array(rounded, profile_slot_t))) {
+        return false;
+    }
+    for (size_t index = 0; index < rounded; index++) {
+        atomic_init(&profiler.slots[index].sequence, 0);
+    }
+
+    profiler.capacity = rounded;
+    atomic_init(&profiler.head, 0);
+    atomic_init(&profiler.is_enabled, false);
+    return true;
+}
+
+void profile_term(void) {
+    atomic_store(&profiler.is_enabled, false);
+    delete (profiler.slots);
+    profiler.slots    = NULL;
+    profiler.capacity = 0;
+}
+
+void profile_set_enabled(bool is_enabled) {
+    atomic_store_explicit(&profiler.is_enabled, is_enabled && profiler.slots,
+                          memory_order_relaxed);
+}
+
+bool profile_is_enabled(void) {
+    return atomic_load_explicit(&profiler.is_enabled, memory_order_relaxed);
+}
+
+void profile_set_tag(char const *tag) { thread_tag = tag; }
+
+// -----------------------------------------------------------------------------
+// Recording
+// -----------------------------------------------------------------------------
+
+uint64_t profile_now_ns(void) {
+    uint64_t counter   = SDL_GetPerformanceCounter();
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+
+    // Split, so the scale-up cannot overflow.
+    return counter / frequency * 1000000000u +
+           counter % frequency * 1000000000u / frequency;
+}
+
+profile_zone_t profile_begin(char const *name) {
+    return (profile_zone_t){name, profile_is_enabled() ? profile_now_ns() : 0};
+}
+
+void profile_end(profile_zone_t *zone) {
+    if (!zone->start_ns || !profiler.slots) {
+        return;
+    }
+
+    uint64_t end_ns = profile_now_ns();
+    uint64_t index  =
+        atomic_fetch_add_explicit(&profiler.head, 1, memory_order_relaxed);
+    profile_slot_t *slot = &profiler.slots[index & (profiler.capacity - 1)];
+
+    atomic_store_explicit(&slot->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->name      = zone->name;
+    slot->tag       = thread_tag;
+    slot->start_ns  = zone->start_ns;
+    slot->end_ns    = end_ns;
+    slot->thread_id = SDL_ThreadID();
+
+    atomic_store_explicit(&slot->sequence, index + 1, memory_order_release);
+}
+
+size_t profile_get_count(void) {
+    uint64_t head = atomic_load(&profiler.head);
+    return head < profiler.capacity ? head : profiler.capacity;
+}
+
+// -----------------------------------------------------------------------------
+// Chrome Trace Export
+// -----------------------------------------------------------------------------
+
+static void write_json_string(FILE *file, char const *str) {
+    fputc('"', file);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            fputc('\\', file);
+        }
+        fputc(*str, file);
+    }
+    fputc('"', file);
+}
+
+bool profile_write_chrome_trace(char const *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+
+    uint64_t head  = atomic_load_explicit(&profiler.head, memory_order_acquire);
+    uint64_t first = head > profiler.capacity ? head - profiler.capacity : 0;
+    bool is_first  = true;
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+
+    for (uint64_t index = first; index < head; index++) {
+        profile_slot_t *slot = &profiler.slots[index & (profiler.capacity - 1)];
+
+        uint64_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        profile_slot_t copy;
+        copy.name      = slot->name;
+        copy.tag       = slot->tag;
+        copy.start_ns  = slot->start_ns;
+        copy.end_ns    = slot->end_ns;
+        copy.thread_id = slot->thread_id;
+        atomic_thread_fence(memory_order_acquire);
+
+        // Unfinished, or overwritten while being read.
+        if (sequence != index + 1 ||
+            atomic_load_explicit(&slot->sequence, memory_order_relaxed) != sequence) {
+            continue;
+        }
+
+        char const *tag = copy.tag ? copy.tag : "untagged";
+
+        fputs(is_first ? "\n" : ",\n", file);
+        fputs("{\"ph\":\"X\",\"pid\":1,\"name\":", file);
+        write_json_string(file, copy.name);
+        fputs(",\"cat\":", file);
+        write_json_string(file, tag);
+        fprintf(file, ",\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"state\":",
+                copy.thread_id, copy.start_ns / 1000.0,
+                (copy.end_ns - copy.start_ns) / 1000.0);
+        write_json_string(file, tag);
+        fputs("}}", file);
+        is_first = false;
+    }
+
+    fputs("\n]}\n", file);
+    return fclose(file) == 0;
+}
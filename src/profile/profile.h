@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * An open profiling zone.
+ *
+ * \sa profile_begin
+ */
+typedef struct {
+  char const *name;
+  uint64_t start_ns; // 0 if recording was off when the zone opened.
+} profile_zone_t;
+
+/**
+ * Initialize the process-wide profiler, keeping the last `capacity` zones.
+ *
+ * Recording starts switched off.
+ *
+ * \param capacity Rounded up to a power of two.
+ * \returns `false` if the zone buffer cannot be allocated.
+ * \sa profile_term
+ */
+bool profile_init(size_t capacity);
+
+/**
+ * Terminate the profiler, discarding anything recorded.
+ */
+void profile_term(void);
+
+/**
+ * Switch recording on or off; safe to call from any thread at any time.
+ */
+void profile_set_enabled(bool is_enabled);
+
+bool profile_is_enabled(void);
+
+/**
+ * Tag zones later closed on the calling thread (e.g. with the current state).
+ *
+ * \param tag Static string, or NULL for none.
+ */
+void profile_set_tag(char const *tag);
+
+/**
+ * Get the high-resolution clock, in nanoseconds.
+ */
+uint64_t profile_now_ns(void);
+
+/**
+ * Open a zone named `name` (a static string).
+ *
+ * \sa profile_end
+ */
+profile_zone_t profile_begin(char const *name);
+
+/**
+ * Close `zone` and record it; lock-free, so any thread may record at once.
+ */
+void profile_end(profile_zone_t *zone);
+
+/**
+ * Get the number of zones currently held (at most the capacity).
+ */
+size_t profile_get_count(void);
+
+/**
+ * Write every held zone to `path` as Chrome trace-event JSON.
+ *
+ * Open the file in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * \returns `false` if the file cannot be written.
+ */
+bool profile_write_chrome_trace(char const *path);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * Small seedable pseudo-random number generator (SplitMix64).
+ *
+ * Each simulation owns one, so matches stepped on different threads neither
+ * share state nor depend on the order they run in.
+ */
+typedef struct {
+  uint64_t state;
+} rng_t;
+
+static inline void rng_init(rng_t *rng, uint64_t seed) { rng->state = seed; }
+
+static inline uint64_t rng_next(rng_t *rng) {
+    uint64_t z = (rng->state += UINT64_C(0x9E3779B97F4A7C15));
+    z          = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z          = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+/**
+ * Get a uniformly distributed double in [0, 1).
+ */
+static inline double rng_next_double(rng_t *rng) {
+    return (rng_next(rng) >> 11) * (1.0 / (UINT64_C(1) << 53));
+}
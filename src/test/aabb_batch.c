@@ -0,0 +1,94 @@
+/**
+ * AABB Batch Kernel Differential Test.
+ *
+ * Every batch kernel the CPU supports must agree, box for box, with the scalar
+ * `aabb_get_intersection` and `aabb_is_beyond_edge` they replace. Boxes are
+ * packed tightly so touching borders and equal penetration depths (tie-breaks)
+ * come up often; counts cover every vector tail length.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "aabb.h"
+
+#define MAX_COUNT 1031
+#define ROUNDS    200
+
+static int xs[MAX_COUNT], ys[MAX_COUNT], ws[MAX_COUNT], hs[MAX_COUNT];
+static aabb_edge_t edges[MAX_COUNT];
+
+static int random_between(int low, int high) { return low + rand() % (high - low + 1); }
+
+static void scatter(size_t count, int spread, int size) {
+    for (size_t index = 0; index < count; index++) {
+        xs[index] = random_between(-spread, spread);
+        ys[index] = random_between(-spread, spread);
+        ws[index] = random_between(0, size);
+        hs[index] = random_between(0, size);
+    }
+}
+
+static aabb_edge_t expected_beyond_edge(aabb_t *outer, aabb_t *box) {
+    if (aabb_is_beyond_edge(box, outer, AABB_TOP_EDGE))
+        return AABB_TOP_EDGE;
+    if (aabb_is_beyond_edge(box, outer, AABB_BOTTOM_EDGE))
+        return AABB_BOTTOM_EDGE;
+    if (aabb_is_beyond_edge(box, outer, AABB_LEFT_EDGE))
+        return AABB_LEFT_EDGE;
+    if (aabb_is_beyond_edge(box, outer, AABB_RIGHT_EDGE))
+        return AABB_RIGHT_EDGE;
+    return AABB_NO_EDGE;
+}
+
+/**
+ * \returns number of boxes the current kernel got wrong.
+ */
+static int check(size_t count, int spread, int size) {
+    aabb_columns_t boxes = {xs, ys, ws, hs};
+    aabb_t a = {random_between(-spread, spread), random_between(-spread, spread),
+                random_between(0, size), random_between(0, size)};
+    int failures = 0;
+
+    scatter(count, spread, size);
+
+    aabb_get_intersections(&a, &boxes, count, edges);
+    for (size_t index = 0; index < count; index++) {
+        aabb_t box = {xs[index], ys[index], ws[index], hs[index]};
+        failures += edges[index] != aabb_get_intersection(&a, &box);
+    }
+
+    aabb_get_beyond_edges(&a, &boxes, count, edges);
+    for (size_t index = 0; index < count; index++) {
+        aabb_t box = {xs[index], ys[index], ws[index], hs[index]};
+        failures += edges[index] != expected_beyond_edge(&a, &box);
+    }
+
+    return failures;
+}
+
+int main(void) {
+    aabb_kernel_t best = aabb_kernel_detect();
+    int failures       = 0;
+
+    for (aabb_kernel_t kernel = AABB_KERNEL_SCALAR; kernel <= best; kernel++) {
+        if (!aabb_kernel_select(kernel)) {
+            continue;
+        }
+
+        int kernel_failures = 0;
+        srand(kernel + 1);
+        for (int round = 0; round < ROUNDS; round++) {
+            for (size_t count = 0; count <= 33; count++) {
+                kernel_failures += check(count, 12, 16);
+            }
+            kernel_failures += check(MAX_COUNT, 12, 16);
+            kernel_failures += check(MAX_COUNT, 100000, 5000);
+        }
+
+        printf("aabb/%s: %d mismatches\n", aabb_kernel_name(kernel), kernel_failures);
+        failures += kernel_failures;
+    }
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
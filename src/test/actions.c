@@ -0,0 +1,92 @@
+/**
+ * Action Event Test.
+ *
+ * Key events queued in SDL become action events applied in time order: a tap
+ * inside one tick still holds the action for that tick, an event stamped after
+ * the tick waits for the next, only pumped events are applied, and filtered
+ * event types never reach the queue.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include "game/actions.h"
+
+#define TEST_NAME "actions"
+#include "test/expect.h"
+
+static action_table_cfg_t config = {
+    [P1_UP] = SDL_SCANCODE_A,
+    [P1_DOWN] = SDL_SCANCODE_Z,
+    [CONFIRM] = SDL_SCANCODE_RETURN,
+};
+
+static void push_key(Uint32 type, SDL_Scancode scancode) {
+    SDL_Event event           = {.type = type};
+    event.key.keysym.scancode = scancode;
+    SDL_PushEvent(&event);
+}
+
+/**
+ * Pump, then advance, as a game ticking on the main thread does.
+ */
+static void advance(action_table_t *table, Uint32 until, action_states_t *states) {
+    action_table_pump(table);
+    action_table_advance(table, until, states);
+}
+
+int main(void) {
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_EVENTS) < 0) {
+        printf("actions: cannot initialize SDL: %s\n", SDL_GetError());
+        return EXIT_FAILURE;
+    }
+    action_table_t *table = action_table_init(config);
+    action_states_t states;
+
+    // --- A tap within one tick
+    push_key(SDL_KEYDOWN, config[P1_UP]);
+    push_key(SDL_KEYUP, config[P1_UP]);
+    advance(table, SDL_GetTicks(), &states);
+    expect(states.pressed[P1_UP] && states.released[P1_UP], "tap edges lost");
+    expect(states.held[P1_UP], "tap not held for its tick");
+    advance(table, SDL_GetTicks(), &states);
+    expect(!states.held[P1_UP] && !states.pressed[P1_UP], "tap held too long");
+
+    // --- Held across ticks
+    push_key(SDL_KEYDOWN, config[P1_DOWN]);
+    advance(table, SDL_GetTicks(), &states);
+    advance(table, SDL_GetTicks(), &states);
+    expect(states.held[P1_DOWN] && !states.pressed[P1_DOWN], "hold not kept");
+    push_key(SDL_KEYUP, config[P1_DOWN]);
+    advance(table, SDL_GetTicks(), &states);
+    expect(states.released[P1_DOWN], "release lost");
+
+    // --- An event after the tick waits for the next one
+    Uint32 const before = SDL_GetTicks() - 1;
+    push_key(SDL_KEYDOWN, config[CONFIRM]);
+    advance(table, before, &states);
+    expect(!states.pressed[CONFIRM], "event applied before its time");
+    advance(table, SDL_GetTicks(), &states);
+    expect(states.pressed[CONFIRM], "event never applied");
+
+    // --- Events wait in SDL's queue until pumped
+    push_key(SDL_KEYDOWN, config[P1_UP]);
+    action_table_advance(table, SDL_GetTicks(), &states);
+    expect(!states.pressed[P1_UP], "event applied before it was pumped");
+    advance(table, SDL_GetTicks(), &states);
+    expect(states.pressed[P1_UP], "pumped event never applied");
+
+    // --- Filtered types never queue
+    SDL_Event motion = {.type = SDL_MOUSEMOTION};
+    SDL_PushEvent(&motion);
+    expect(!SDL_PeepEvents(&motion, 1, SDL_PEEKEVENT, SDL_MOUSEMOTION, SDL_MOUSEMOTION),
+           "mouse motion was queued");
+
+    action_table_term(table);
+    SDL_Quit();
+
+    return expect_finish(NULL);
+}
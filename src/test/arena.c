@@ -0,0 +1,56 @@
+/**
+ * Arena Allocator Test.
+ *
+ * Allocations are aligned and disjoint, survive a spill into a new block, and
+ * a reset merges spilled blocks into one that fits the high-water mark.
+ */
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "alloc.h"
+
+#define TEST_NAME "arena"
+#include "test/expect.h"
+
+#define ALLOCATION_COUNT 200
+
+int main(void) {
+    arena_t *arena = arena_init(256);
+    unsigned char *blocks[ALLOCATION_COUNT];
+    arena_stats_t stats;
+
+    // --- Spill past the first block, filling each allocation with its index
+    for (int round = 0; round < 3; round++) {
+        for (int index = 0; index < ALLOCATION_COUNT; index++) {
+            size_t size   = 1 + index % 61;
+            blocks[index] = arena_alloc(arena, size);
+            expect(blocks[index] != NULL, "allocation failed");
+            expect((uintptr_t)blocks[index] % alignof(max_align_t) == 0, "misaligned");
+            memset(blocks[index], index, size);
+        }
+        for (int index = 0; index < ALLOCATION_COUNT; index++) {
+            for (size_t byte = 0; byte < 1 + (size_t)index % 61; byte++) {
+                expect(blocks[index][byte] == (unsigned char)index, "overlap");
+            }
+        }
+
+        arena_get_stats(arena, &stats);
+        expect(stats.used <= stats.capacity, "used exceeds capacity");
+        expect(stats.high_water >= stats.used, "high water below use");
+        expect(round == 0 || stats.block_count == 1, "reset did not merge blocks");
+
+        arena_reset(arena);
+    }
+
+    arena_get_stats(arena, &stats);
+    expect(stats.used == 0, "reset left bytes in use");
+    expect(stats.resets == 3, "resets not counted");
+    expect(stats.block_count == 1, "reset did not merge blocks");
+    expect(stats.capacity >= stats.high_water, "merged block below high water");
+
+    arena_term(arena);
+    return expect_finish(NULL);
+}
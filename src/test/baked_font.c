@@ -0,0 +1,63 @@
+/**
+ * Baked Font Test.
+ *
+ * The font baked by the build covers printable ASCII, every glyph lies within
+ * its atlas without overlapping another, every glyph advances, and the visible
+ * ones have coverage.
+ */
+
+#include <stdbool.h>
+
+#include "app/baked_font.h"
+
+#define TEST_NAME "baked font"
+#include "test/expect.h"
+
+static bool is_overlapping(baked_glyph_t const *a, baked_glyph_t const *b) {
+    return a->x < b->x + b->w && b->x < a->x + a->w && a->y < b->y + b->h &&
+           b->y < a->y + a->h;
+}
+
+static bool has_coverage(baked_font_t const *font, baked_glyph_t const *glyph) {
+    for (int y = glyph->y; y < glyph->y + glyph->h; y++) {
+        for (int x = glyph->x; x < glyph->x + glyph->w; x++) {
+            if (font->coverage[y * font->width + x]) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int main(void) {
+    baked_font_t const *font = &baked_font;
+
+    // --- Range and atlas
+    expect(font->first_glyph == ' ', "range does not start at space");
+    expect(font->first_glyph + font->glyph_count - 1 == '~', "range does not end at ~");
+    expect(font->width > 0 && font->height > 0, "atlas is empty");
+    expect(font->line_height > 0, "no line height");
+
+    // --- Glyphs
+    int outside = 0, overlapping = 0, still = 0, blank = 0;
+    for (int index = 0; index < font->glyph_count; index++) {
+        baked_glyph_t const *glyph = &font->glyphs[index];
+        char const ch              = (char)(font->first_glyph + index);
+
+        outside += glyph->x < 0 || glyph->y < 0 || glyph->w < 0 || glyph->h < 0 ||
+                   glyph->x + glyph->w > font->width ||
+                   glyph->y + glyph->h > font->height;
+        still += glyph->advance <= 0;
+        blank += ch != ' ' && !has_coverage(font, glyph);
+
+        for (int other = 0; other < index; other++) {
+            overlapping += is_overlapping(glyph, &font->glyphs[other]);
+        }
+    }
+    expect(!outside, "glyph outside the atlas");
+    expect(!overlapping, "glyphs overlap");
+    expect(!still, "glyph does not advance");
+    expect(!blank, "visible glyph has no coverage");
+
+    return expect_finish(NULL);
+}
@@ -0,0 +1,107 @@
+/**
+ * Swept Collision Test.
+ *
+ * A ball fast enough to cross a paddle in one tick hits it, bounces, and spends
+ * exactly the rest of the tick travelling back: it ends where it would have had
+ * it stopped at the paddle and left again at its new velocity, no farther. An
+ * entity touching nothing moves exactly its velocity over the tick, and one
+ * overlapping an entity despawned but not yet collected touches nothing.
+ */
+
+#include "alloc.h"
+#include "game/collision.h"
+#include "game/entity.h"
+
+#define TEST_NAME "collision"
+#include "test/expect.h"
+
+// A quarter second, so every distance below is exact in Q16.16.
+#define TICK_DELTA 0.25f
+
+static int bounces = 0;
+static int touches = 0;
+
+/** Bounce off whatever was hit, as the ball does off a paddle. */
+static void bounce(entity_t *self, entity_t *collider, aabb_edge_t edge) {
+    (void)collider;
+    entity_set_direction(self, edge == AABB_RIGHT_EDGE ? DIR_LEFT : DIR_RIGHT);
+    bounces++;
+}
+
+static void touch(entity_t *self, entity_t *collider, aabb_edge_t edge) {
+    (void)self;
+    (void)collider;
+    (void)edge;
+    touches++;
+}
+
+static entity_t spawn(entity_store_t *store, aabb_t transform, int vx, int vy) {
+    entity_t entity;
+    entity_get(store, entity_spawn(store), &entity);
+    entity_set_transform(&entity, &transform);
+    entity_set_velocity(&entity, vx, vy);
+    return entity;
+}
+
+static bool is_at(entity_t *entity, int x, int y) {
+    entity_store_t *store = entity->store;
+    return store->x[entity->index] == fixed_from_int(x) &&
+           store->y[entity->index] == fixed_from_int(y);
+}
+
+int main(void) {
+    aabb_t field = {0, 0, 640, 480};
+
+    entity_store_t *store  = entity_store_init(8);
+    collision_grid_t *grid = collision_grid_init(&field, 32);
+    arena_t *scratch       = arena_init(4096);
+
+    // --- A ball crossing 128 px a tick, 96 px short of an 8 px paddle
+    entity_t paddle = spawn(store, (aabb_t){112, 0, 8, 128}, 0, 0);
+    entity_t ball   = spawn(store, (aabb_t){0, 10, 16, 16}, 512, 256);
+    entity_get_behaviour(&ball)->collide = bounce;
+
+    // --- Far from both, moving freely
+    entity_t loner = spawn(store, (aabb_t){400, 300, 16, 16}, -100, 60);
+
+    bool const is_processed = collision_process(grid, store, scratch, NULL, TICK_DELTA);
+    entity_store_integrate(store, NULL, TICK_DELTA);
+
+    expect(is_processed, "collisions not processed");
+    expect(bounces == 1, "ball did not bounce exactly once");
+
+    // Contact after 3/4 of the tick at (96, 58), then back 32 px and down 16.
+    expect(is_at(&ball, 64, 74), "ball not where the bounce leaves it");
+    expect(is_at(&paddle, 112, 0), "paddle moved");
+    expect(is_at(&loner, 375, 315), "free entity did not move its velocity");
+
+    for (size_t index = 0; index < store->count; index++) {
+        expect(!store->elapsed[index], "tick not finished for every entity");
+    }
+
+    // --- Next tick, leaving the paddle behind
+    arena_reset(scratch);
+    collision_process(grid, store, scratch, NULL, TICK_DELTA);
+    entity_store_integrate(store, NULL, TICK_DELTA);
+    expect(bounces == 1, "ball bounced off the paddle again");
+    expect(is_at(&ball, -64, 138), "ball not moving at its new velocity");
+
+    // --- A still entity under one despawned this tick, its row not yet collected
+    entity_t target = spawn(store, (aabb_t){300, 200, 32, 32}, 0, 0);
+    entity_t ghost  = spawn(store, (aabb_t){308, 208, 16, 16}, 40, 0);
+    entity_get_behaviour(&target)->collide = touch;
+    entity_get_behaviour(&ghost)->collide  = touch;
+    entity_despawn(store, entity_get_handle(&ghost));
+
+    arena_reset(scratch);
+    collision_process(grid, store, scratch, NULL, TICK_DELTA);
+    entity_store_integrate(store, NULL, TICK_DELTA);
+    expect(!touches, "despawned entity still collides");
+    expect(is_at(&ghost, 308, 208), "despawned entity still moves");
+
+    arena_term(scratch);
+    collision_grid_term(grid);
+    entity_store_term(store);
+
+    return expect_finish(NULL);
+}
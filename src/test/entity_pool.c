@@ -0,0 +1,86 @@
+/**
+ * Entity Pool Test.
+ *
+ * Churns a small pool through many spawn/despawn cycles, checking that every
+ * live handle still reaches its own data after rows move, that despawned
+ * handles stay stale after their slots are reused, and that every entity is
+ * destroyed exactly once.
+ */
+
+#include <stdlib.h>
+
+#include "game/entity.h"
+
+#define TEST_NAME "entity pool"
+#include "test/expect.h"
+
+#define CAPACITY 64
+#define ROUNDS   10000
+
+static entity_handle_t handles[CAPACITY];
+static int ids[CAPACITY];
+static int destroyed = 0;
+
+static void destroy(entity_t *self) {
+    (void)self;
+    destroyed++;
+}
+
+/** Check every held handle against the id stashed in its x column. */
+static void check_live(entity_store_t *store, size_t live) {
+    for (size_t index = 0; index < live; index++) {
+        entity_t entity;
+        expect(entity_get(store, handles[index], &entity), "live handle is stale");
+        expect(store->x[entity.index] == ids[index], "handle reaches wrong row");
+        expect(entity_get_handle(&entity) == handles[index], "handle round-trip");
+    }
+}
+
+int main(void) {
+    entity_store_t *store = entity_store_init(CAPACITY);
+    entity_handle_t stale[CAPACITY];
+    size_t live = 0, stale_count = 0;
+    int spawned = 0, next_id = 1;
+
+    srand(CAPACITY);
+    for (int round = 0; round < ROUNDS; round++) {
+        // --- Spawn until full
+        entity_handle_t handle;
+        while ((handle = entity_spawn(store)) != ENTITY_HANDLE_NULL) {
+            entity_t entity;
+            entity_get(store, handle, &entity);
+            store->x[entity.index]                 = next_id;
+            entity_get_behaviour(&entity)->destroy = destroy;
+            handles[live]                          = handle;
+            ids[live++]                            = next_id++;
+            spawned++;
+        }
+        expect(live == CAPACITY, "pool filled short of capacity");
+
+        // --- Despawn a random subset, some twice
+        stale_count = 0;
+        for (size_t count = rand() % CAPACITY; count > 0; count--) {
+            size_t victim = rand() % live;
+            expect(entity_despawn(store, handles[victim]), "despawn refused");
+            expect(!entity_despawn(store, handles[victim]), "double despawn accepted");
+            stale[stale_count++] = handles[victim];
+            handles[victim]      = handles[--live];
+            ids[victim]          = ids[live];
+        }
+
+        check_live(store, live);
+        entity_store_collect(store);
+        expect(store->count == live, "collect left dead rows");
+        check_live(store, live);
+
+        for (size_t index = 0; index < stale_count; index++) {
+            expect(!entity_is_alive(store, stale[index]), "stale handle alive");
+        }
+    }
+
+    expect(destroyed == spawned - (int)live, "despawn destroyed wrong count");
+    entity_store_term(store);
+    expect(destroyed == spawned, "term destroyed wrong count");
+
+    return expect_finish(" (%d spawned)", spawned);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+/**
+ * Test Expectations.
+ *
+ * The checks every test program shares: failed expectations are counted and
+ * reported, each prefixed with the test's name, and `expect_finish` turns the
+ * count into the exit status. Define `TEST_NAME` before including.
+ *
+ *   #define TEST_NAME "arena"
+ *   #include "test/expect.h"
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef TEST_NAME
+#error "Define TEST_NAME before including test/expect.h"
+#endif
+
+// Failures reported one by one; a broken invariant in a loop reports only once
+// this many.
+#define EXPECT_MAX_REPORTS 10
+
+static int expect_failures = 0;
+
+/**
+ * Count a failure, reporting `what` went wrong, unless `condition` holds.
+ */
+static inline void expect(int condition, char const *what) {
+    if (!condition && expect_failures++ < EXPECT_MAX_REPORTS) {
+        printf(TEST_NAME ": %s\n", what);
+    }
+}
+
+/**
+ * Report the outcome: "ok" followed by `details` (printf format, may be NULL)
+ * if nothing failed, the failure count otherwise.
+ *
+ * \returns the exit status for `main`.
+ */
+__attribute__((format(printf, 1, 2))) static inline int
+expect_finish(char const *details, ...) {
+    if (expect_failures) {
+        printf(TEST_NAME ": %d failure(s)\n", expect_failures);
+        return EXIT_FAILURE;
+    }
+
+    printf(TEST_NAME ": ok");
+    if (details) {
+        va_list args;
+        va_start(args, details);
+        vprintf(details, args);
+        va_end(args);
+    }
+    printf("\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+/**
+ * Job System Test.
+ *
+ * Parallel loops visit every item exactly once, in grain-aligned chunks, on
+ * one thread or several, and loops nested inside jobs finish before the job
+ * that started them.
+ */
+
+#include <stdatomic.h>
+#include <string.h>
+
+#include "jobs/jobs.h"
+
+#define TEST_NAME "jobs"
+#include "test/expect.h"
+
+#define ITEM_COUNT  100000
+#define GRAIN       1000
+#define OUTER_COUNT 16
+#define INNER_COUNT 5000
+
+// --- Flat loop
+
+static unsigned char visits[ITEM_COUNT];
+static atomic_int bad_chunks;
+
+static void visit(void *context, size_t first, size_t count) {
+    (void)context;
+    if (first % GRAIN || !count || count > GRAIN) {
+        atomic_store(&bad_chunks, 1);
+    }
+    for (size_t item = first; item < first + count; item++) {
+        visits[item]++;
+    }
+}
+
+static void check_flat(job_system_t *jobs) {
+    memset(visits, 0, sizeof visits);
+    atomic_store(&bad_chunks, 0);
+    job_parallel_for(jobs, visit, NULL, ITEM_COUNT, GRAIN);
+
+    int is_once = 1;
+    for (size_t item = 0; item < ITEM_COUNT; item++) {
+        is_once &= visits[item] == 1;
+    }
+    expect(is_once, "an item was not visited exactly once");
+    expect(!atomic_load(&bad_chunks), "a chunk was not aligned to the grain");
+}
+
+// --- Nested loops
+
+typedef struct {
+    job_system_t *jobs;
+    unsigned long sums[OUTER_COUNT];
+} nested_t;
+
+typedef struct {
+    unsigned long partial[INNER_COUNT / 100];
+} inner_t;
+
+static void sum_inner(void *context, size_t first, size_t count) {
+    inner_t *inner = context;
+    for (size_t item = first; item < first + count; item++) {
+        inner->partial[first / 100] += item;
+    }
+}
+
+static void sum_outer(void *context, size_t first, size_t count) {
+    nested_t *nested = context;
+    for (size_t outer = first; outer < first + count; outer++) {
+        inner_t inner = {{0}};
+        job_parallel_for(nested->jobs, sum_inner, &inner, INNER_COUNT, 100);
+
+        // Merged in chunk order, as callers that need determinism do.
+        for (size_t chunk = 0; chunk < INNER_COUNT / 100; chunk++) {
+            nested->sums[outer] += inner.partial[chunk] * (outer + 1);
+        }
+    }
+}
+
+static void check_nested(job_system_t *jobs) {
+    nested_t nested = {.jobs = jobs};
+    job_parallel_for(jobs, sum_outer, &nested, OUTER_COUNT, 1);
+
+    unsigned long sum = (unsigned long)INNER_COUNT * (INNER_COUNT - 1) / 2;
+    int is_right      = 1;
+    for (size_t outer = 0; outer < OUTER_COUNT; outer++) {
+        is_right &= nested.sums[outer] == sum * (outer + 1);
+    }
+    expect(is_right, "a nested loop gave the wrong sum");
+}
+
+int main(void) {
+    check_flat(NULL);
+    check_nested(NULL);
+
+    unsigned const thread_counts[] = {1, 2, 4, 0};
+    for (size_t index = 0; index < sizeof thread_counts / sizeof *thread_counts;
+         index++) {
+        job_system_t *jobs = job_system_init(thread_counts[index]);
+        expect(jobs != NULL, "cannot initialize job system");
+        if (!jobs) {
+            continue;
+        }
+
+        // Repeated, so workers go back to sleep and wake up again in between.
+        for (int round = 0; round < 50; round++) {
+            check_flat(jobs);
+            check_nested(jobs);
+        }
+        job_system_term(jobs);
+    }
+
+    return expect_finish(NULL);
+}
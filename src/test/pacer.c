@@ -0,0 +1,50 @@
+/**
+ * Frame Pacer Test.
+ *
+ * Every paced frame is counted, and a deliberately late one is counted late.
+ * How long the run took is reported, not checked: on a loaded machine, or
+ * beside other tests, the wall clock says more about the scheduler than about
+ * the pacer.
+ */
+
+#include "SDL.h"
+
+#include "app/pacer.h"
+
+#define TEST_NAME "pacer"
+#include "test/expect.h"
+
+#define FRAME_RATE  120
+#define FRAME_COUNT 60
+
+int main(void) {
+    double const frequency = SDL_GetPerformanceFrequency();
+    double const period_ms = 1000.0 / FRAME_RATE;
+
+    pacer_t *pacer = pacer_init(&(pacer_config_t){.frame_rate = FRAME_RATE});
+    expect(pacer != NULL, "cannot allocate pacer");
+    if (!pacer) {
+        return 1;
+    }
+
+    uint64_t const start = SDL_GetPerformanceCounter();
+    for (int frame = 0; frame < FRAME_COUNT; frame++) {
+        // One frame overruns by half a period; the next should be short.
+        if (frame == FRAME_COUNT / 2) {
+            SDL_Delay(period_ms * 1.5);
+        }
+        pacer_wait(pacer);
+    }
+    double const elapsed_ms = (SDL_GetPerformanceCounter() - start) * 1000 / frequency;
+
+    pacer_stats_t stats;
+    pacer_get_stats(pacer, &stats);
+    expect(stats.frame_count == FRAME_COUNT, "frames miscounted");
+    expect(stats.late_count >= 1, "late frame not counted");
+    pacer_term(pacer);
+
+    return expect_finish(" (%.1f ms for %.1f ms of frames; %.3f ms mean, %.3f ms "
+                         "jitter, %.3f - %.3f ms, %lu late)",
+                         elapsed_ms, FRAME_COUNT * period_ms, stats.mean_ms,
+                         stats.jitter_ms, stats.min_ms, stats.max_ms, stats.late_count);
+}
@@ -0,0 +1,106 @@
+/**
+ * Replay Test.
+ *
+ * A match played with scripted input, and triggers fired from outside, is
+ * recorded; replaying the recording ends the same way. Truncated recordings
+ * are refused.
+ */
+
+#include <stdio.h>
+
+#include "game/actions.h"
+#include "game/replay.h"
+
+#define TEST_NAME "replay"
+#include "test/expect.h"
+
+#define RECORDING_PATH "test-replay.prec"
+#define TICK_RATE      60
+#define TICK_LIMIT     36000
+
+/**
+ * Play a match the way the game does, two scripted players at the keys.
+ */
+static match_result_t record_match(match_config_t const *config) {
+    match_result_t result = {0};
+    match_t *match        = match_init(config);
+    replay_recorder_t *recorder =
+        replay_recorder_init(RECORDING_PATH, config, TICK_RATE);
+    expect(match && recorder, "cannot start recording");
+    if (!match || !recorder) {
+        match_term(match);
+        return result;
+    }
+
+    replay_record_trigger(recorder, match, CONFIRM_TRIGGER);
+    match_trigger(match, CONFIRM_TRIGGER);
+
+    bool actions[ACTION_COUNT] = {0};
+    while (match_get_state(match) != TERM_STATE && match->tick_count < TICK_LIMIT) {
+        if (match_get_state(match) == GAME_OVER_STATE) {
+            replay_record_trigger(recorder, match, CANCEL_TRIGGER);
+            match_trigger(match, CANCEL_TRIGGER);
+            continue;
+        }
+
+        actions[P1_UP]   = match->tick_count / 37 % 3 == 0;
+        actions[P1_DOWN] = match->tick_count / 37 % 3 == 1;
+        actions[P2_UP]   = match->tick_count / 53 % 3 == 0;
+        actions[P2_DOWN] = match->tick_count / 53 % 3 == 2;
+        replay_record_actions(recorder, match, actions);
+        match_tick(match, actions, 1.0f / TICK_RATE);
+    }
+
+    result.score_1     = player_get_score(&match->player_1);
+    result.score_2     = player_get_score(&match->player_2);
+    result.tick_count  = match->tick_count;
+    result.is_finished = match_get_state(match) == TERM_STATE;
+    replay_recorder_term(recorder, match);
+    match_term(match);
+    return result;
+}
+
+/**
+ * Cut the last `count` bytes off the recording.
+ */
+static void truncate_recording(long count) {
+    FILE *file = fopen(RECORDING_PATH, "rb");
+    char bytes[1 << 16];
+    size_t size = file ? fread(bytes, 1, sizeof bytes, file) : 0;
+    if (file) {
+        fclose(file);
+    }
+    if ((file = fopen(RECORDING_PATH, "wb"))) {
+        fwrite(bytes, 1, size - count, file);
+        fclose(file);
+    }
+}
+
+int main(void) {
+    match_config_t config = {.field = {0, 0, 640, 480}, .seed = 7};
+
+    match_result_t recorded = record_match(&config);
+    expect(recorded.is_finished, "recorded match did not finish");
+
+    replay_t *replay = replay_load(RECORDING_PATH);
+    expect(replay != NULL, "cannot load recording");
+    if (replay) {
+        match_result_t replayed;
+        expect(replay_play(replay, &replayed), "replay did not end as recorded");
+        expect(replayed.score_1 == recorded.score_1 &&
+                   replayed.score_2 == recorded.score_2 &&
+                   replayed.tick_count == recorded.tick_count &&
+                   replayed.is_finished == recorded.is_finished,
+               "replay gave a different result");
+        replay_term(replay);
+    }
+
+    truncate_recording(3);
+    replay = replay_load(RECORDING_PATH);
+    expect(replay == NULL, "truncated recording was loaded");
+    replay_term(replay);
+    remove(RECORDING_PATH);
+
+    return expect_finish(" (%lu ticks, %hu - %hu)", recorded.tick_count,
+                         recorded.score_1, recorded.score_2);
+}
@@ -0,0 +1,155 @@
+/**
+ * Rollback over Loopback Test.
+ *
+ * Two peers in one process play a match over UDP on 127.0.0.1, each link
+ * holding packets back 50 ms (a 100 ms round trip) and dropping 10% of them,
+ * on a clock stepped one tick at a time. Both peers must end the match exactly
+ * as an offline match played on the same input does, having rolled back rather
+ * than waited for each other.
+ */
+
+#include <string.h>
+
+#include "game/actions.h"
+#include "game/rollback.h"
+
+#define TEST_NAME "rollback"
+#include "test/expect.h"
+
+#define TICK_RATE  60
+#define STEP_LIMIT 60000
+#define LATENCY_MS 50
+#define LOSS       0.1f
+#define PORT_1     47301
+#define PORT_2     47302
+
+static aabb_t const field  = {0, 0, 640, 480};
+static uint64_t const seed = 11;
+
+// Ticks each player's input waits; they need not agree.
+static unsigned char const input_delays[3] = {0, 1, 2};
+
+/**
+ * What `player` holds for tick `tick`, once it applies.
+ */
+static unsigned script(int player, unsigned long tick) {
+    if (tick < input_delays[player]) {
+        return 0;
+    }
+    unsigned long phase = player == 1 ? tick / 37 % 3 : tick / 53 % 3;
+    return phase == 0 ? ROLLBACK_UP : phase == 1 ? ROLLBACK_DOWN : 0;
+}
+
+/**
+ * Play the match offline, on the input both peers will have had.
+ */
+static void play_offline(match_snapshot_t *snapshot) {
+    match_t *match = match_init(&(match_config_t){field, seed, true, NULL});
+    expect(match != NULL, "cannot start offline match");
+    if (!match) {
+        return;
+    }
+    bool actions[ACTION_COUNT] = {0};
+    while (match_get_state(match) != TERM_STATE && match->tick_count < STEP_LIMIT) {
+        actions[P1_UP]   = script(1, match->tick_count) & ROLLBACK_UP;
+        actions[P1_DOWN] = script(1, match->tick_count) & ROLLBACK_DOWN;
+        actions[P2_UP]   = script(2, match->tick_count) & ROLLBACK_UP;
+        actions[P2_DOWN] = script(2, match->tick_count) & ROLLBACK_DOWN;
+        match_tick(match, actions, 1.0f / TICK_RATE);
+    }
+    match_save(match, snapshot);
+    match_term(match);
+}
+
+/**
+ * Step one peer, holding what its script says for the tick this input is for.
+ */
+static rollback_status_t step(rollback_t *session, int player, uint64_t now_ms) {
+    match_t *match = rollback_get_match(session);
+    unsigned input = 0;
+    if (match) {
+        input = script(player, match->tick_count + input_delays[player]);
+    }
+    return rollback_tick(session, input, now_ms);
+}
+
+static bool is_same_outcome(match_snapshot_t *a, match_snapshot_t *b) {
+    return a->state == b->state && a->rng.state == b->rng.state &&
+           player_get_score(&a->player_1) == player_get_score(&b->player_1) &&
+           player_get_score(&a->player_2) == player_get_score(&b->player_2) &&
+           a->entity_count == b->entity_count &&
+           !memcmp(a->entities, b->entities, a->entity_count * sizeof a->entities[0]);
+}
+
+int main(void) {
+    link_t *link_1 = link_init(&(link_config_t){PORT_1, "127.0.0.1", PORT_2,
+                                                LATENCY_MS, LOSS, 1});
+    link_t *link_2 = link_init(&(link_config_t){PORT_2, "127.0.0.1", PORT_1,
+                                                LATENCY_MS, LOSS, 2});
+    expect(link_1 && link_2, "cannot open loopback links");
+    if (!link_1 || !link_2) {
+        link_term(link_1);
+        link_term(link_2);
+        return 1;
+    }
+
+    rollback_config_t config = {.tick_rate = TICK_RATE, .field = field, .seed = seed};
+    config.player            = 1;
+    config.input_delay       = ROLLBACK_MAX_INPUT_DELAY + 1;
+    expect(!rollback_init(link_1, &config), "input delayed past the most was taken");
+
+    config.input_delay       = input_delays[1];
+    rollback_t *session_1    = rollback_init(link_1, &config);
+    config.player            = 2;
+    config.input_delay       = input_delays[2];
+    config.seed              = 0; // Player 1's is used.
+    config.field             = (aabb_t){0, 0, 1, 1};
+    rollback_t *session_2    = rollback_init(link_2, &config);
+
+    // Step both peers through the same clock until both are done.
+    rollback_status_t status_1 = ROLLBACK_CONNECTING;
+    rollback_status_t status_2 = ROLLBACK_CONNECTING;
+    double now_ms              = 0;
+    for (int steps = 0; steps < STEP_LIMIT; steps++) {
+        if (status_1 > ROLLBACK_RUNNING && status_2 > ROLLBACK_RUNNING) {
+            break;
+        }
+        // A finished peer keeps answering, as it would until its game closes.
+        status_1 = step(session_1, 1, now_ms);
+        status_2 = step(session_2, 2, now_ms);
+        now_ms += 1000.0 / TICK_RATE;
+    }
+    expect(status_1 == ROLLBACK_FINISHED, "player 1 did not finish");
+    expect(status_2 == ROLLBACK_FINISHED, "player 2 did not finish");
+
+    match_snapshot_t offline, peer_1, peer_2;
+    play_offline(&offline);
+    match_save(rollback_get_match(session_1), &peer_1);
+    match_save(rollback_get_match(session_2), &peer_2);
+    expect(is_same_outcome(&peer_1, &offline), "player 1 saw a different match");
+    expect(is_same_outcome(&peer_2, &offline), "player 2 saw a different match");
+
+    // Guessing, not waiting: at 100 ms round trip every tick is guessed first,
+    // and only a handful are waited out to keep the peers in step.
+    rollback_stats_t stats_1, stats_2;
+    rollback_get_stats(session_1, &stats_1);
+    rollback_get_stats(session_2, &stats_2);
+    expect(stats_1.rollback_count && stats_2.rollback_count, "no rollbacks");
+    expect(stats_1.stall_count < peer_1.tick_count / 20 &&
+               stats_2.stall_count < peer_2.tick_count / 20,
+           "peers waited for each other");
+
+    rollback_term(session_1);
+    rollback_term(session_2);
+    link_term(link_1);
+    link_term(link_2);
+
+    return expect_finish(" (%lu ticks, %hu - %hu; player 1 rolled back %lu times, "
+                         "%lu ticks, waited %lu; player 2 rolled back %lu times, "
+                         "%lu ticks, waited %lu)",
+                         offline.tick_count, player_get_score(&offline.player_1),
+                         player_get_score(&offline.player_2), stats_1.rollback_count,
+                         stats_1.resimulated, stats_1.stall_count,
+                         stats_2.rollback_count, stats_2.resimulated,
+                         stats_2.stall_count);
+}
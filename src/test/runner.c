@@ -0,0 +1,42 @@
+/**
+ * Match Runner Test.
+ *
+ * A batch of unattended matches plays to the end, and every match comes out
+ * the same whether the batch runs on one thread or several.
+ */
+
+#include "game/runner.h"
+
+#define TEST_NAME "runner"
+#include "test/expect.h"
+
+#define MATCH_COUNT 16
+
+int main(void) {
+    runner_config_t config = {
+        .match_count = MATCH_COUNT,
+        .seed        = 42,
+        .field       = {0, 0, 640, 480},
+        .tick_rate   = 60,
+        .tick_limit  = 36000,
+    };
+    match_result_t serial[MATCH_COUNT];
+    match_result_t parallel[MATCH_COUNT];
+
+    config.thread_count = 1;
+    expect(runner_run(&config, serial), "serial run failed");
+    config.thread_count = 4;
+    expect(runner_run(&config, parallel), "parallel run failed");
+
+    for (int index = 0; index < MATCH_COUNT; index++) {
+        expect(serial[index].is_finished, "match did not finish");
+        expect(serial[index].score_1 == 5 || serial[index].score_2 == 5,
+               "finished match has no winner");
+        expect(serial[index].score_1 == parallel[index].score_1 &&
+                   serial[index].score_2 == parallel[index].score_2 &&
+                   serial[index].tick_count == parallel[index].tick_count,
+               "thread count changed a result");
+    }
+
+    return expect_finish(NULL);
+}
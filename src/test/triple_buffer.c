@@ -0,0 +1,72 @@
+/**
+ * Triple Buffer Test.
+ *
+ * A writer thread publishes numbered slots as fast as it can while the reader
+ * takes the latest: the reader never sees a slot half written, never goes back
+ * to an older one, and ends on the last one published.
+ */
+
+#include <stdlib.h>
+
+#include "SDL.h"
+
+#include "app/triple_buffer.h"
+
+#define TEST_NAME "triple buffer"
+#include "test/expect.h"
+
+#define SLOT_WORDS    256
+#define PUBLISH_COUNT 100000
+
+/**
+ * Publish slots numbered 1 to PUBLISH_COUNT, every word of each set to its
+ * number.
+ */
+static int write_slots(void *context) {
+    triple_buffer_t *buffer = context;
+    for (unsigned number = 1; number <= PUBLISH_COUNT; number++) {
+        unsigned *slot = triple_buffer_get_back(buffer);
+        for (int word = 0; word < SLOT_WORDS; word++) {
+            slot[word] = number;
+        }
+        triple_buffer_publish(buffer);
+    }
+    return 0;
+}
+
+int main(void) {
+    triple_buffer_t *buffer = triple_buffer_init(SLOT_WORDS * sizeof(unsigned));
+    expect(buffer != NULL, "cannot allocate buffer");
+    if (!buffer) {
+        return EXIT_FAILURE;
+    }
+    expect(triple_buffer_get_front(buffer) == NULL, "slot read before publishing");
+
+    SDL_Thread *writer = SDL_CreateThread(write_slots, "writer", buffer);
+    expect(writer != NULL, "cannot start writer");
+
+    unsigned last     = 0;
+    unsigned reads    = 0;
+    bool is_torn      = false;
+    bool is_backwards = false;
+    while (writer && last < PUBLISH_COUNT) {
+        unsigned const *slot = triple_buffer_get_front(buffer);
+        if (!slot) {
+            continue;
+        }
+        for (int word = 1; word < SLOT_WORDS; word++) {
+            is_torn |= slot[word] != slot[0];
+        }
+        is_backwards |= slot[0] < last;
+        last = slot[0];
+        reads++;
+    }
+    SDL_WaitThread(writer, NULL);
+
+    expect(!is_torn, "slot read while written");
+    expect(!is_backwards, "older slot read after a newer one");
+    expect(last == PUBLISH_COUNT, "last slot never read");
+    triple_buffer_term(buffer);
+
+    return expect_finish(" (%u reads)", reads);
+}
@@ -0,0 +1,213 @@
+/**
+ * Font Baker.
+ *
+ * Rasterizes the printable ASCII glyphs of a TrueType font at one size, packs
+ * them into rows of a glyph atlas, and writes the atlas coverage and glyph
+ * metrics as C source defining `baked_font` (see app/baked_font.h). Run by the
+ * build, so the game draws text without SDL_ttf or the font file.
+ *
+ *   font-baker FONT SIZE OUTPUT
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SDL_MAIN_HANDLED
+#include <SDL2/SDL.h>
+#include <SDL_ttf.h>
+
+#include "app/baked_font.h"
+
+// --- Atlas Layout
+#define ATLAS_WIDTH   512
+#define ATLAS_PADDING 1
+
+// Coverage bytes written per line of output.
+#define BYTES_PER_LINE 24
+
+/** A font rasterized into memory, ready to write out. */
+typedef struct {
+    int line_height;
+    int height;
+    baked_glyph_t glyphs[BAKED_FONT_GLYPH_COUNT];
+    uint8_t *coverage; // ATLAS_WIDTH * height.
+} atlas_t;
+
+/**
+ * Copy the alpha of `surface`, which holds one glyph, into the atlas at the
+ * glyph's place.
+ */
+static bool copy_coverage(atlas_t *atlas, baked_glyph_t const *glyph,
+                          SDL_Surface *surface) {
+    SDL_Surface *rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    if (!rgba) {
+        return false;
+    }
+    SDL_LockSurface(rgba);
+    for (int row = 0; row < glyph->h; row++) {
+        Uint32 const *pixels = (Uint32 const *)((Uint8 const *)rgba->pixels +
+                                                row * rgba->pitch);
+        uint8_t *coverage    = atlas->coverage + (glyph->y + row) * ATLAS_WIDTH +
+                            glyph->x;
+        for (int column = 0; column < glyph->w; column++) {
+            coverage[column] = pixels[column] >> 24;
+        }
+    }
+    SDL_UnlockSurface(rgba);
+    SDL_FreeSurface(rgba);
+    return true;
+}
+
+/**
+ * Rasterize every glyph of `font` white, lay them out in rows, then gather
+ * their coverage into one atlas.
+ */
+static bool atlas_bake(atlas_t *atlas, TTF_Font *font) {
+    static SDL_Color const WHITE = {255, 255, 255, 255};
+
+    SDL_Surface *surfaces[BAKED_FONT_GLYPH_COUNT] = {0};
+    bool is_baked                                 = true;
+
+    atlas->line_height = TTF_FontHeight(font);
+
+    // --- Rasterize and lay out glyphs in rows
+    int pen_x = 0, pen_y = 0, row_height = 0;
+    for (int index = 0; index < BAKED_FONT_GLYPH_COUNT; index++) {
+        uint16_t ch          = BAKED_FONT_FIRST_GLYPH + index;
+        baked_glyph_t *glyph = &atlas->glyphs[index];
+        int advance          = 0;
+
+        TTF_GlyphMetrics(font, ch, NULL, NULL, NULL, NULL, &advance);
+        *glyph = (baked_glyph_t){.advance = advance};
+
+        // Blank glyphs (e.g. space) may not produce a surface; they only advance.
+        SDL_Surface *surface = TTF_RenderGlyph_Blended(font, ch, WHITE);
+        if (!surface) {
+            continue;
+        }
+
+        if (pen_x + surface->w > ATLAS_WIDTH) {
+            pen_x = 0;
+            pen_y += row_height + ATLAS_PADDING;
+            row_height = 0;
+        }
+
+        glyph->x = pen_x;
+        glyph->y = pen_y;
+        glyph->w = surface->w;
+        glyph->h = surface->h;
+        pen_x += surface->w + ATLAS_PADDING;
+        if (surface->h > row_height) {
+            row_height = surface->h;
+        }
+
+        surfaces[index] = surface;
+    }
+    atlas->height = pen_y + row_height;
+
+    // --- Gather coverage into the atlas
+    atlas->coverage = calloc((size_t)ATLAS_WIDTH * atlas->height, 1);
+    for (int index = 0; index < BAKED_FONT_GLYPH_COUNT; index++) {
+        if (surfaces[index] && atlas->coverage) {
+            is_baked &= copy_coverage(atlas, &atlas->glyphs[index], surfaces[index]);
+        }
+        SDL_FreeSurface(surfaces[index]);
+    }
+    return is_baked && atlas->coverage;
+}
+
+/**
+ * Write the atlas as C source defining `baked_font`.
+ */
+static bool atlas_write(atlas_t const *atlas, char const *font_path, int size,
+                        char const *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+
+    // Only the file name goes into the binary, not where it was built.
+    char const *name = strrchr(font_path, '/');
+    name             = name ? name + 1 : font_path;
+
+    fprintf(file, "// Baked from %s at %d pt by font-baker. Do not edit.\n\n", name,
+            size);
+    fprintf(file, "#include \"app/baked_font.h\"\n\n");
+
+    fprintf(file, "static baked_glyph_t const glyphs[%d] = {\n",
+            BAKED_FONT_GLYPH_COUNT);
+    for (int index = 0; index < BAKED_FONT_GLYPH_COUNT; index++) {
+        baked_glyph_t const *glyph = &atlas->glyphs[index];
+        fprintf(file, "    {%d, %d, %d, %d, %d},\n", glyph->x, glyph->y, glyph->w,
+                glyph->h, glyph->advance);
+    }
+    fprintf(file, "};\n\n");
+
+    size_t const count = (size_t)ATLAS_WIDTH * atlas->height;
+    fprintf(file, "static uint8_t const coverage[%zu] = {\n", count);
+    for (size_t index = 0; index < count; index++) {
+        bool const is_line_start = index % BYTES_PER_LINE == 0;
+        bool const is_line_end   = index % BYTES_PER_LINE == BYTES_PER_LINE - 1;
+        fprintf(file, "%s%u,%s", is_line_start ? "    " : "", atlas->coverage[index],
+                is_line_end || index == count - 1 ? "\n" : "");
+    }
+    fprintf(file, "};\n\n");
+
+    fprintf(file,
+            "baked_font_t const baked_font = {\n"
+            "    .name        = \"%s\",\n"
+            "    .size        = %d,\n"
+            "    .first_glyph = %d,\n"
+            "    .glyph_count = %d,\n"
+            "    .width       = %d,\n"
+            "    .height      = %d,\n"
+            "    .line_height = %d,\n"
+            "    .glyphs      = glyphs,\n"
+            "    .coverage    = coverage,\n"
+            "};\n",
+            name, size, BAKED_FONT_FIRST_GLYPH, BAKED_FONT_GLYPH_COUNT, ATLAS_WIDTH,
+            atlas->height, atlas->line_height);
+
+    bool const is_written = !ferror(file);
+    return fclose(file) == 0 && is_written;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 4) {
+        fprintf(stderr, "usage: %s FONT SIZE OUTPUT\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    char const *font_path = argv[1];
+    int const size        = atoi(argv[2]);
+    char const *path      = argv[3];
+
+    if (TTF_Init() < 0) {
+        fprintf(stderr, "font-baker: %s\n", TTF_GetError());
+        return EXIT_FAILURE;
+    }
+    TTF_Font *font = TTF_OpenFont(font_path, size);
+    if (!font) {
+        fprintf(stderr, "font-baker: %s\n", TTF_GetError());
+        TTF_Quit();
+        return EXIT_FAILURE;
+    }
+
+    atlas_t atlas         = {0};
+    bool const is_baked   = atlas_bake(&atlas, font);
+    bool const is_written = is_baked && atlas_write(&atlas, font_path, size, path);
+    free(atlas.coverage);
+    TTF_CloseFont(font);
+    TTF_Quit();
+
+    if (!is_baked) {
+        fprintf(stderr, "font-baker: cannot rasterize %s\n", font_path);
+        return EXIT_FAILURE;
+    }
+    if (!is_written) {
+        fprintf(stderr, "font-baker: cannot write %s\n", path);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}